@@ -8,6 +8,7 @@
 #include <string.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 
 // GLEW header
 #ifdef USEGLEW
@@ -53,6 +54,17 @@
 #define ROOM_MIN_Z -28.0f
 #define ROOM_MAX_Z 28.0f
 
+// Stage bounds and height
+#define STAGE_MIN_X -10.0f
+#define STAGE_MAX_X 10.0f
+#define STAGE_MIN_Z -30.0f
+#define STAGE_MAX_Z -20.0f
+#define STAGE_HEIGHT 2.0f
+
+// Entrance door position
+#define DOOR_POS_X 0.0f
+#define DOOR_POS_Z 29.9f
+
 // Stage grid and elevation settings
 extern const float GRID_SNAP_SIZE;
 
@@ -70,6 +82,9 @@ void Print(const char *format, ...);
 void Fatal(const char *format, ...);
 #endif
 
+    // High resolution clock in milliseconds
+    double timer_now_ms(void);
+
     // Texture loading and GL error check utilities
     unsigned int LoadTexBMP(const char *file);
     void ErrCheck(const char *where);
@@ -79,6 +94,8 @@ void Fatal(const char *format, ...);
     void scene_init(void);
     void reshape(int width, int height);
     void Project(void);
+    void draw_view(void);
+    void init_render(void);
 
     // Object draw functions
     void drawTable(float x, float z);
@@ -104,6 +121,9 @@ void Fatal(const char *format, ...);
     void lighting_init(void);
     void lighting_update(void);
     void lighting_draw_debug_marker(void);
+    void lighting_build_lamp_grid(void);
+    void lighting_select_lamps(float x, float z);
+    int lighting_lamp_count(int *cellsFull);
 
     int CreateShaderProg(char *VertFile, char *FragFile);
 
@@ -142,6 +162,14 @@ void Fatal(const char *format, ...);
         float subBox[MAX_SUBBOXES][6]; // each is {xmin, xmax, ymin, ymax, zmin, zmax}
     } SceneObject;
 
+    // Where an object is and how it is turned
+    typedef struct
+    {
+        float x, y, z;
+        float rotation;
+        float scale;
+    } SceneTransform;
+
     typedef enum
     {
         SPAWN_LAMP = 0,
@@ -155,12 +183,52 @@ void Fatal(const char *format, ...);
         SPAWN_TYPE_COUNT
     } SceneSpawnType;
 
+    // Bulk placement patterns
+    typedef enum
+    {
+        PATTERN_THEATRE = 0,
+        PATTERN_ROUNDS,
+        PATTERN_CLASSROOM,
+        PATTERN_TYPE_COUNT
+    } ScenePatternType;
+
+    typedef struct
+    {
+        ScenePatternType type;
+        float originX, originZ; // center of the block
+        int rows, cols;
+        float spacingX, spacingZ;
+        int aisleEvery; // columns between aisles (0 = no aisle)
+        float aisleWidth;
+        int seatsPerTable; // chairs around a round table / behind a desk
+    } ScenePattern;
+
+    typedef enum
+    {
+        SLOT_PENDING = 0,
+        SLOT_PLACED,
+        SLOT_OUTSIDE_ROOM,
+        SLOT_COLLISION,
+        SLOT_NO_CAPACITY
+    } SceneSlotStatus;
+
+    typedef struct
+    {
+        SceneSpawnType type;
+        float x, z;
+        float rotation;
+        SceneSlotStatus status;
+    } ScenePatternSlot;
+
+#define MAX_PATTERN_SLOTS 512
+
 // Scene object management
-#define MAX_OBJECTS 100
+#define MAX_OBJECTS 1024
 
     extern SceneObject objects[MAX_OBJECTS];
     extern int objectCount;
     extern bool collidesWithAnyObject(SceneObject *movingObj, float newX, float newZ, bool adjustPlayerHeight, bool allowStageSnap);
+    int scene_check_overlaps(int firstIndex);
     SceneObject *addObject(const char *name,
                            float positionX, float positionZ,
                            void (*drawFunc)(float, float),
@@ -177,6 +245,11 @@ void Fatal(const char *format, ...);
     void scene_apply_stage_height(SceneObject *obj);
     void configureObjectBounds(SceneObject *sceneObject);
     void scene_spawn_reset(void);
+    void scene_clear_movable_objects(void);
+    void scene_init_objects(void);
+    void scene_object_footprint(const SceneObject *sceneObject, float worldX, float worldZ,
+                                float *minX, float *maxX, float *minZ, float *maxZ);
+    void scene_object_box_bounds(const SceneObject *sceneObject, int boxIndex, float bounds[6]);
 
     // Mouse interaction
     void mouse_button(int button, int state, int mouseX, int mouseY);
@@ -219,14 +292,440 @@ void Fatal(const char *format, ...);
     // Interaction utilities
     void rotateObject(SceneObject *obj, float angle);
     SceneObject *scene_spawn_object(SceneSpawnType type);
+    int scene_spawn_prototype(SceneSpawnType type, SceneObject *prototype);
+    SceneObject *scene_spawn_at(SceneSpawnType type, float x, float z, float rotation);
+    const char *scene_spawn_type_name(SceneSpawnType type);
+    SceneObject *scene_spawn_restore(SceneSpawnType type, const char *name,
+                                     float x, float y, float z, float rotation, float scale);
+    int scene_spawn_request(SceneSpawnType type);
+    int scene_spawn_pending_count(void);
+    void scene_spawn_update(double budgetMs);
+    void scene_spawn_draw_pending(void);
+    int scene_pattern_build(const ScenePattern *pattern, ScenePatternSlot *slots, int maxSlots);
+    int scene_spawn_pattern(const ScenePattern *pattern, ScenePatternSlot *slots, int maxSlots, int *slotCountOut);
+    void scene_pattern_cycle(void);
+    void scene_spawn_active_pattern(void);
     void scene_remove_selected_object(void);
+    void scene_remove_object(SceneObject *sceneObject);
+    SceneObject *scene_find_object_id(int id);
+    void scene_set_object_id(SceneObject *sceneObject, int id);
+    void scene_get_transform(const SceneObject *sceneObject, SceneTransform *transform);
+    void scene_set_transform(SceneObject *sceneObject, const SceneTransform *transform);
+
+    // Undo/redo history (undo.c)
+    extern int undoMemoryLimitKB;
+    void undo_begin_edit(void);
+    void undo_end_edit(void);
+    void undo_clear(void);
+    void undo_record_transform(const SceneObject *sceneObject, const SceneTransform *before);
+    void undo_record_spawn(const SceneObject *sceneObject);
+    void undo_record_remove(const SceneObject *sceneObject);
+    int undo_undo(void);
+    int undo_redo(void);
 
     // Player collision
     void initPlayerCollision(void);
 
+    // Seating layout optimizer
+    typedef struct
+    {
+        SceneSpawnType type;
+        int count; // -1 = as many as fit
+    } LayoutItem;
+
+    typedef struct
+    {
+        float aisleWidth;     // clear walkway from the door to the stage
+        float stageClearance; // empty strip in front of the stage
+        float doorClearance;  // empty area inside the door
+        float seatClearance;  // extra gap kept around every object
+        int timeBudgetMs;
+    } LayoutConstraints;
+
+    int layout_optimize(const LayoutItem *items, int itemCount, const LayoutConstraints *constraints);
+    int layout_optimize_start(const LayoutItem *items, int itemCount, const LayoutConstraints *constraints,
+                              const char *saveFile);
+    void layout_optimize_update(double budgetMs);
+    int layout_optimize_running(void);
+    int layout_optimize_status(char *text, int size);
+    void layout_optimize_default(void);
+
     // Save/Load functions
     void save_scene(const char *filename);
-    void load_scene(const char *filename);
+    int load_scene(const char *filename);
+
+    // Background saving (savethread.c)
+    extern int autosaveEnabled;
+    void save_scene_async(const char *filename);
+    void save_async_flush(void);
+    void save_async_update(void);
+    int save_async_status(char *text, int textSize);
+
+    // Edit journal (journal.c)
+    void journal_open(void);
+    void journal_close(void);
+    void journal_use_files(const char *journalPath, const char *checkpointPath);
+    void journal_checkpoint(void);
+    int journal_replay(const char *filename);
+    void journal_spawn(const SceneObject *sceneObject);
+    void journal_move(const SceneObject *sceneObject);
+    void journal_rotate(const SceneObject *sceneObject);
+    void journal_remove(const char *name);
+
+    // One saved object, also the record layout of binary layout files (56 bytes)
+    typedef struct
+    {
+        char name[32];
+        int type; // SceneSpawnType, -1 if unknown
+        float x, y, z;
+        float rotation;
+        float scale;
+    } LayoutRecord;
+
+    // Called for every record read from a layout; return 0 to stop reading
+    typedef int (*LayoutRecordFunc)(const LayoutRecord *record, void *userData);
+
+    // Growable list of records, filled by layout_collect_record
+    typedef struct
+    {
+        LayoutRecord *records;
+        int count;
+        int capacity;
+    } LayoutRecordList;
+    int layout_collect_record(const LayoutRecord *record, void *userData);
+
+    // Streaming CSV reader (fields are split in place inside its buffer)
+#define CSV_MAX_FIELDS 16
+    typedef struct
+    {
+        FILE *file;
+        char *buffer;
+        size_t capacity;
+        size_t start, end; // unread part of the buffer
+        int atEnd;
+        int line; // line number of the current record (from 1)
+        int fieldCount;
+        char *fields[CSV_MAX_FIELDS];
+        int fieldColumns[CSV_MAX_FIELDS];
+    } CsvReader;
+
+    int csv_open(CsvReader *reader, const char *filename);
+    int csv_next_record(CsvReader *reader);
+    void csv_close(CsvReader *reader);
+    int csv_parse_float(const char *text, float *out);
+
+    int layout_type_from_name(const char *name);
+    int layout_is_binary(const char *filename);
+    int scene_snapshot_layout(LayoutRecord **recordsOut);
+    int layout_read(const char *filename, LayoutRecordFunc recordFunc, void *userData);
+    int layout_write(const char *filename, const LayoutRecord *records, int recordCount);
+    int layout_write_atomic(const char *filename, const LayoutRecord *records, int recordCount);
+    int layout_read_csv(const char *filename, LayoutRecordFunc recordFunc, void *userData);
+    int layout_write_csv(const char *filename, const LayoutRecord *records, int recordCount);
+    int layout_read_bin(const char *filename, LayoutRecordFunc recordFunc, void *userData);
+    int layout_write_bin(const char *filename, const LayoutRecord *records, int recordCount);
+    int layout_convert(const char *inputFile, const char *outputFile);
+    unsigned char *layout_bin_encode(const LayoutRecord *records, int recordCount, size_t *sizeOut);
+    int layout_bin_validate(const unsigned char *data, size_t fileSize, const char *sourceName);
+    int layout_bin_decode(const unsigned char *data, size_t fileSize, const char *sourceName,
+                          LayoutRecordFunc recordFunc, void *userData);
+    const unsigned char *file_map(const char *filename, size_t *sizeOut);
+    void file_unmap(const unsigned char *data, size_t size);
+    int scene_restore_record(const LayoutRecord *record, void *userData);
+    int scene_begin_load(void);
+    void scene_finish_load(const char *sourceName, int firstLoaded, double startTime);
+
+    // Layout diff and merge (diff.c)
+    typedef enum
+    {
+        DIFF_ADDED = 1,
+        DIFF_REMOVED = 2,
+        DIFF_MOVED = 4,
+        DIFF_ROTATED = 8,
+        DIFF_SCALED = 16
+    } LayoutDiffFlags;
+
+    typedef struct
+    {
+        char name[32];
+        int flags;          // LayoutDiffFlags
+        int indexA, indexB; // record in each layout, -1 if missing
+    } LayoutDiffEntry;
+
+    typedef enum
+    {
+        MERGE_BOTH_CHANGED,       // both sides moved, turned or resized it differently
+        MERGE_CHANGED_AND_REMOVED, // one side changed it, the other removed it
+        MERGE_BOTH_ADDED          // both sides added the same name in different places (both kept)
+    } LayoutMergeConflictType;
+
+    typedef struct
+    {
+        char name[32];
+        LayoutMergeConflictType type;
+        char renamed[32]; // MERGE_BOTH_ADDED: the new name given to their object
+    } LayoutMergeConflict;
+
+    int layout_diff(const LayoutRecord *a, int countA, const LayoutRecord *b, int countB,
+                    LayoutDiffEntry **entriesOut);
+    int layout_merge(const LayoutRecord *base, int baseCount,
+                     const LayoutRecord *ours, int oursCount,
+                     const LayoutRecord *theirs, int theirsCount,
+                     LayoutRecordList *merged, LayoutMergeConflict **conflictsOut);
+
+    // Layout library archive (library.c)
+#define LIBRARY_FILE "layouts.ehla"
+#define LIBRARY_MAX_TYPES 16
+#define LIBRARY_THUMB_WIDTH 48
+#define LIBRARY_THUMB_HEIGHT 72
+    typedef struct
+    {
+        char name[32];
+        long long savedTime; // seconds since 1970
+        unsigned int objectCount;
+        unsigned int typeCounts[LIBRARY_MAX_TYPES]; // objects of each SceneSpawnType
+        unsigned int layoutOffset, layoutSize;      // binary layout inside the archive
+        unsigned int thumbOffset;                   // RGB top down picture
+        unsigned int reserved[2];
+    } LibraryEntry;
+
+    extern int libraryBrowserOpen;
+    int library_add(const char *archiveFile, const char *name, const LayoutRecord *records, int recordCount);
+    int library_read_index(const char *archiveFile, LibraryEntry **entriesOut);
+    int library_compact(const char *archiveFile);
+    int library_load_entry(const char *archiveFile, const LibraryEntry *entry,
+                           LayoutRecordFunc recordFunc, void *userData);
+    int library_read_thumb(const char *archiveFile, const LibraryEntry *entry, unsigned char *rgb);
+    void library_render_thumb(const LayoutRecord *records, int recordCount, unsigned char *rgb);
+    void library_save_current(void);
+    void library_browser_toggle(void);
+    int library_browser_key(unsigned char key);
+    int library_browser_special(int key);
+    void library_browser_draw(void);
+
+    // Texture loading (texture.c)
+    typedef struct
+    {
+        const char *file;      // BMP file
+        unsigned int *texture; // where the handle for texture_bind goes
+        int atlas;             // 1 to pack it into the furniture atlas
+        int preload;           // 1 to load it at startup instead of when it is first drawn
+    } TextureRequest;
+
+    // RGB image decoded from a BMP, rows packed, bottom row first
+    typedef struct
+    {
+        int width, height;
+        unsigned char *pixels; // inside memory
+        void *memory;          // freed by texture_free_image
+    } TextureImage;
+
+    typedef enum
+    {
+        TEXTURE_FILTER_LINEAR,      // full size only, as the textures were first loaded
+        TEXTURE_FILTER_TRILINEAR,   // mipmaps, blended between levels
+        TEXTURE_FILTER_ANISOTROPIC, // mipmaps plus anisotropic filtering for floors seen at an angle
+        TEXTURE_FILTER_COUNT
+    } TextureFilter;
+
+    extern TextureFilter textureFilter;
+    extern int textureCompression;
+    extern int textureStatsShown;
+    extern int textureBudgetMB;
+    const TextureRequest *scene_texture_list(int *count);
+    void texture_register_batch(const TextureRequest *requests, int count);
+    void texture_bind(unsigned int handle);
+    int texture_take_bind_count(void);
+    void texture_end_frame(void);
+    int texture_loaded_count(int *total);
+    int texture_decode_bmp(const char *file, int maxSize, TextureImage *image, char *error, int errorSize);
+    void texture_free_image(TextureImage *image);
+    int texture_mip_count(int width, int height);
+    size_t texture_mip_chain_size(int width, int height);
+    void texture_build_mipmaps(unsigned char *chain, int width, int height);
+    size_t texture_memory_bytes(void);
+    const char *texture_filter_name(void);
+    int texture_samples_per_pixel(void);
+    void texture_cycle_filter(void);
+    void texture_print_report(void);
+
+    // Baked texture cache (texcache.c)
+#define TEXTURE_CACHE_FILE "textures/textures.ehtc"
+    typedef struct
+    {
+        int width, height;
+        int levelCount;
+        const unsigned char *levels; // mipmap chain, full size first
+    } TextureCacheImage;
+
+    int texture_cache_open(const char *cacheFile);
+    void texture_cache_close(void);
+    int texture_cache_find(const char *file, TextureCacheImage *image);
+    int texture_cache_bake(const char *cacheFile, const char *const *files, int count);
+
+    // Shader programs with a binary cache and hot reload (shadercache.c)
+    int shader_load(const char *vertFile, const char *fragFile);
+    int shader_use(int shader);
+    int shader_uniform(int shader, const char *name);
+    void shader_poll_reload(void);
+
+    // Baked lightmaps for the room shell (lightmap.c)
+#define LIGHTMAP_FILE "lightmaps.ehlm"
+    typedef struct
+    {
+        const char *name;
+        float origin[3];          // corner the lightmap starts at
+        float axisU[3], axisV[3]; // unit directions the lightmap runs along
+        float sizeU, sizeV;       // meters covered along each direction
+        float normal[3];
+        // Curved surfaces place each texel themselves (NULL for flat ones): u and v are meters
+        // along the axes, returns 0 when (u, v) is off the surface
+        int (*place)(float u, float v, float position[3], float normal[3]);
+    } LightmapSurface;
+
+    extern int lightmapsEnabled;
+    const LightmapSurface *scene_lightmap_surfaces(int *count);
+    int scene_lightmap_occluders(float boxes[][6], int maxBoxes);
+    void lightmap_init(void);
+    void lightmap_update(void);
+    void lightmap_wait(void);
+    int lightmap_bake_file(const char *file);
+    void lightmap_begin(int surface);
+    void lightmap_end(void);
+
+    // Frame profiler (profiler.c); build with -DNO_PROFILER to leave the timing out
+    typedef enum
+    {
+        PROFILE_FRAME,
+        PROFILE_LIGHTING,
+        PROFILE_ROOM, // floor, ceiling and walls
+        PROFILE_STAGE,
+        PROFILE_OBJECTS,
+        PROFILE_FIRE,
+        PROFILE_CEILING, // shapes hanging from the ceiling
+        PROFILE_HUD,
+        PROFILE_PHASE_COUNT
+    } ProfilePhase;
+
+    // Render passes timed on the graphics card; only one can be timed at a time
+    typedef enum
+    {
+        GPU_ROOM, // floor, ceiling, walls and stage
+        GPU_FURNITURE,
+        GPU_OUTLINE, // selection outline and bounding boxes
+        GPU_FIRE,
+        GPU_CEILING,
+        GPU_HUD,
+        GPU_PASS_COUNT
+    } GpuPass;
+
+#ifdef NO_PROFILER
+#define PROFILE_BEGIN(phase) ((void)0)
+#define PROFILE_END(phase) ((void)0)
+#define GPU_BEGIN(pass) ((void)0)
+#define GPU_END(pass) ((void)0)
+#else
+#define PROFILE_BEGIN(phase) profiler_begin(phase)
+#define PROFILE_END(phase) profiler_end(phase)
+#define GPU_BEGIN(pass) profiler_gpu_begin(pass)
+#define GPU_END(pass) profiler_gpu_end(pass)
+    void profiler_begin(ProfilePhase phase);
+    void profiler_end(ProfilePhase phase);
+    void profiler_gpu_begin(GpuPass pass);
+    void profiler_gpu_end(GpuPass pass);
+#endif
+    extern int profilerShown;
+    void profiler_end_frame(void);
+    void profiler_draw(void);
+
+    // Chrome trace recording (trace.c), also left out with -DNO_PROFILER
+    // Time a block with: double start = TRACE_NOW(); ... TRACE_RECORD("name", "category", start);
+    extern _Atomic int traceRecording;
+#ifdef NO_PROFILER
+#define TRACE_NOW() 0.0
+#define TRACE_RECORD(name, category, start) ((void)(start))
+#else
+#define TRACE_NOW() (traceRecording ? timer_now_ms() : 0.0)
+#define TRACE_RECORD(name, category, start)                          \
+    do                                                               \
+    {                                                                \
+        if (traceRecording)                                          \
+            trace_record(name, category, start, timer_now_ms());     \
+    } while (0)
+    void trace_record(const char *name, const char *category, double startMs, double endMs);
+#endif
+    void trace_init(void);
+    void trace_toggle(void);
+
+    // Draw call counters (drawcount.c), also left out with -DNO_PROFILER
+    // The GL calls below are wrapped so every file counts what it submits. The counts are filed
+    // under the part of the scene set with DRAW_GROUP, or under the object's type with DRAW_OBJECT.
+    typedef struct
+    {
+        int drawCalls; // glBegin blocks plus other draws (spheres, pixel rectangles)
+        int blocks;    // glBegin/glEnd blocks
+        int vertices;
+        int textureBinds;
+        int stateChanges; // glEnable/glDisable calls
+    } DrawCounts;
+
+    typedef enum
+    {
+        DRAW_OTHER,
+        DRAW_ROOM, // floor, ceiling, walls and stage
+        DRAW_OUTLINE,
+        DRAW_FIRE,
+        DRAW_CEILING,
+        DRAW_HUD,
+        DRAW_GROUP_FIXED // object types follow
+    } DrawGroup;
+
+#ifdef NO_PROFILER
+#define DRAW_GROUP(group) ((void)0)
+#define DRAW_OBJECT(object) ((void)0)
+#else
+    extern DrawCounts drawCounts; // running totals
+#define DRAW_GROUP(group) draw_count_group(group)
+#define DRAW_OBJECT(object) draw_count_object(object)
+#define glBegin(mode) (drawCounts.drawCalls++, drawCounts.blocks++, glBegin(mode))
+#define glVertex3f(x, y, z) (drawCounts.vertices++, glVertex3f(x, y, z))
+#define glVertex3fv(v) (drawCounts.vertices++, glVertex3fv(v))
+#define glBindTexture(target, texture) (drawCounts.textureBinds++, glBindTexture(target, texture))
+#define glEnable(cap) (drawCounts.stateChanges++, glEnable(cap))
+#define glDisable(cap) (drawCounts.stateChanges++, glDisable(cap))
+#define glDrawPixels(width, height, format, type, pixels) \
+    (drawCounts.drawCalls++, glDrawPixels(width, height, format, type, pixels))
+#define glutSolidSphere(radius, slices, stacks) (drawCounts.drawCalls++, glutSolidSphere(radius, slices, stacks))
+    void draw_count_group(DrawGroup group);
+    void draw_count_object(const SceneObject *object);
+#endif
+    extern int drawCountsShown;
+    void draw_count_end_frame(void);
+    void draw_count_frame_total(DrawCounts *total);
+    void draw_count_draw(void);
+    void draw_count_toggle_csv(void);
+
+    // Offscreen rendering (offscreen.c): draws views into image files without a window
+    typedef enum
+    {
+        VIEW_PERSPECTIVE,
+        VIEW_FPV,
+        VIEW_ORTHOGONAL, // straight down, the whole floor plan
+        VIEW_COUNT
+    } ViewPreset;
+
+    extern int offscreenRendering; // no window, so nothing may call GLUT
+    int offscreen_open(int width, int height);
+    void offscreen_close(void);
+    const char *view_preset_name(ViewPreset view);
+    void view_preset_apply(ViewPreset view);
+    int offscreen_write_bmp(const char *file);
+
+    // Render benchmark (bench.c)
+    int bench_run(const char *layout, int syntheticCount, int frameCount, const char *outputFile);
+
+    // Command line tools
+    int tools_main(int argc, char *argv[]);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,267 @@
+#include "CSCIx229.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+// Render benchmark: flies the camera along a fixed path through the perspective, FPV and
+// orthogonal views (a third of the frames each) and writes frame times, draw counts and peak
+// memory as JSON. It draws offscreen, so it runs the same on a CI machine under Xvfb or with
+// Mesa's software renderer. Each frame is timed up to glFinish, so the time includes the drawing
+// itself and not only handing the commands to the driver.
+#define BENCH_WARMUP_FRAMES 10 // drawn first and not timed (textures load on first use)
+
+// Synthetic hall: every SYNTHETIC_TABLE_EVERY-th item is an event table, the rest are banquet chairs
+#define SYNTHETIC_TABLE_EVERY 5
+#define SYNTHETIC_MIN_X -18.0f
+#define SYNTHETIC_MAX_X 18.0f
+#define SYNTHETIC_MIN_Z -18.0f // in front of the stage
+#define SYNTHETIC_MAX_Z 28.0f
+
+// Helper function to fill the hall with count chairs and tables on an even grid
+// They are placed without collision checks, so large counts overlap, which is fine for timing
+// Returns the number placed
+static int buildSyntheticHall(int count)
+{
+    scene_begin_load();
+
+    float width = SYNTHETIC_MAX_X - SYNTHETIC_MIN_X;
+    float depth = SYNTHETIC_MAX_Z - SYNTHETIC_MIN_Z;
+    int columns = (int)ceil(sqrt(count * width / depth));
+    if (columns < 1)
+        columns = 1;
+    int rows = (count + columns - 1) / columns;
+
+    int placed = 0;
+    for (int i = 0; i < count; i++)
+    {
+        SceneSpawnType type = (i % SYNTHETIC_TABLE_EVERY == 0) ? SPAWN_EVENT_TABLE : SPAWN_BANQUET_CHAIR;
+        float x = SYNTHETIC_MIN_X + width * (i % columns + 0.5f) / columns;
+        float z = SYNTHETIC_MIN_Z + depth * (i / columns + 0.5f) / rows;
+
+        // Chairs face the stage
+        char name[32];
+        snprintf(name, sizeof(name), "%s_%d", scene_spawn_type_name(type), i + 1);
+        if (!scene_spawn_restore(type, name, x, 0.0f, z, type == SPAWN_EVENT_TABLE ? 0.0f : 180.0f, 1.0f))
+            break;
+        placed++;
+    }
+    return placed;
+}
+
+// Helper function to point the camera at frame (0 to frameCount-1) of the path
+static void placeCamera(int frame, int frameCount)
+{
+    // Each view gets a third of the frames; t runs from 0 to 1 within it
+    int segment = frame * VIEW_COUNT / frameCount;
+    int segmentStart = (segment * frameCount + VIEW_COUNT - 1) / VIEW_COUNT;
+    int segmentEnd = ((segment + 1) * frameCount + VIEW_COUNT - 1) / VIEW_COUNT;
+    double t = segmentEnd > segmentStart ? (double)(frame - segmentStart) / (segmentEnd - segmentStart) : 0.0;
+
+    view_preset_apply((ViewPreset)segment);
+    if (segment == VIEW_PERSPECTIVE)
+    {
+        // Swing from side to side while tilting down
+        th = 60.0 * Sin(360.0 * t);
+        ph = 20.0 * t;
+    }
+    else if (segment == VIEW_FPV)
+    {
+        // Walk from the door towards the stage, weaving and looking around
+        fpvX = 8.0 * Sin(360.0 * t);
+        fpvZ = 24.0 - 38.0 * t;
+        yaw = 30.0 * Sin(720.0 * t);
+    }
+    else
+    {
+        // Turn the floor plan a full circle
+        th = 360.0 * t;
+    }
+}
+
+// Helper function for qsort to sort frame times
+static int compareMs(const void *a, const void *b)
+{
+    double msA = *(const double *)a;
+    double msB = *(const double *)b;
+    return (msA > msB) - (msA < msB);
+}
+
+// Helper function to pick the p-th percentile of sorted times (nearest rank)
+static double percentile(const double *sorted, int count, int p)
+{
+    int rank = (p * count + 99) / 100 - 1;
+    return sorted[rank < 0 ? 0 : rank];
+}
+
+// Helper function to write a JSON string with quotes and backslashes escaped
+static void writeJsonString(FILE *f, const char *text)
+{
+    fputc('"', f);
+    for (; text && *text; text++)
+    {
+        if (*text == '"' || *text == '\\')
+            fputc('\\', f);
+        if ((unsigned char)*text >= ' ')
+            fputc(*text, f);
+    }
+    fputc('"', f);
+}
+
+// Helper function to write min, percentiles, max and mean of some frame times (sorts them)
+static void writeTimes(FILE *f, double *times, int count)
+{
+    double sum = 0.0;
+    for (int i = 0; i < count; i++)
+        sum += times[i];
+    qsort(times, count, sizeof(double), compareMs);
+    fprintf(f, "{\"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f, \"mean\": %.3f}",
+            times[0], percentile(times, count, 50), percentile(times, count, 90), percentile(times, count, 99),
+            times[count - 1], sum / count);
+}
+
+// Helper function to read the largest the process has been, in KB (-1 if unknown)
+static long peakMemoryKB(void)
+{
+#ifdef _WIN32
+    return -1;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// Runs the benchmark on the layout file, or on a synthetic hall of syntheticCount items when
+// layout is NULL, and writes the results to outputFile
+// The offscreen context must be open. Returns 0 on success
+int bench_run(const char *layout, int syntheticCount, int frameCount, const char *outputFile)
+{
+    if (frameCount < VIEW_COUNT)
+        frameCount = VIEW_COUNT;
+
+    int itemCount = 0;
+    if (layout)
+    {
+        if (load_scene(layout) != 0)
+            return 1;
+    }
+    else if (syntheticCount > 0)
+    {
+        itemCount = buildSyntheticHall(syntheticCount);
+        printf("Synthetic hall: %d chairs and tables\n", itemCount);
+    }
+
+    double *times = (double *)malloc(frameCount * sizeof(double));
+    if (!times)
+        return 1;
+    double drawCalls = 0.0, blocks = 0.0, vertices = 0.0, textureBinds = 0.0, stateChanges = 0.0;
+    int maxDrawCalls = 0, maxVertices = 0;
+
+    // Warm up at the start of the path
+    for (int frame = 0; frame < BENCH_WARMUP_FRAMES; frame++)
+    {
+        placeCamera(0, frameCount);
+        draw_view();
+        texture_end_frame();
+        draw_count_end_frame();
+    }
+    glFinish();
+
+    double startTime = timer_now_ms();
+    for (int frame = 0; frame < frameCount; frame++)
+    {
+        double frameStart = timer_now_ms();
+        placeCamera(frame, frameCount);
+        draw_view();
+        texture_end_frame();
+        glFinish();
+        times[frame] = timer_now_ms() - frameStart;
+
+        draw_count_end_frame();
+        DrawCounts counts;
+        draw_count_frame_total(&counts);
+        drawCalls += counts.drawCalls;
+        blocks += counts.blocks;
+        vertices += counts.vertices;
+        textureBinds += counts.textureBinds;
+        stateChanges += counts.stateChanges;
+        if (counts.drawCalls > maxDrawCalls)
+            maxDrawCalls = counts.drawCalls;
+        if (counts.vertices > maxVertices)
+            maxVertices = counts.vertices;
+    }
+    double totalMs = timer_now_ms() - startTime;
+    ErrCheck("bench_run");
+
+    FILE *f = fopen(outputFile, "w");
+    if (!f)
+    {
+        fprintf(stderr, "Cannot create %s\n", outputFile);
+        free(times);
+        return 1;
+    }
+
+    fprintf(f, "{\n  \"layout\": ");
+    if (layout)
+        writeJsonString(f, layout);
+    else
+        fprintf(f, "null");
+    fprintf(f, ",\n  \"synthetic_items\": %d,\n", itemCount);
+    fprintf(f, "  \"objects\": %d,\n", objectCount);
+    fprintf(f, "  \"frames\": %d,\n", frameCount);
+    fprintf(f, "  \"width\": %d,\n  \"height\": %d,\n", screenWidth, screenHeight);
+    fprintf(f, "  \"renderer\": ");
+    writeJsonString(f, (const char *)glGetString(GL_RENDERER));
+    fprintf(f, ",\n  \"gl_version\": ");
+    writeJsonString(f, (const char *)glGetString(GL_VERSION));
+    fprintf(f, ",\n  \"total_ms\": %.1f,\n  \"fps\": %.1f,\n", totalMs, frameCount * 1000.0 / totalMs);
+
+    // Each view's share of the path, then the whole path (writeTimes sorts, so the whole path goes last)
+    fprintf(f, "  \"frame_ms_by_view\": {");
+    for (int view = 0; view < VIEW_COUNT; view++)
+    {
+        int first = (view * frameCount + VIEW_COUNT - 1) / VIEW_COUNT;
+        int end = ((view + 1) * frameCount + VIEW_COUNT - 1) / VIEW_COUNT;
+        fprintf(f, "%s\n    ", view > 0 ? "," : "");
+        writeJsonString(f, view_preset_name((ViewPreset)view));
+        fprintf(f, ": ");
+        double *viewTimes = (double *)malloc((end - first) * sizeof(double));
+        if (viewTimes)
+        {
+            memcpy(viewTimes, times + first, (end - first) * sizeof(double));
+            writeTimes(f, viewTimes, end - first);
+            free(viewTimes);
+        }
+        else
+            fprintf(f, "null");
+    }
+    fprintf(f, "\n  },\n  \"frame_ms\": ");
+    writeTimes(f, times, frameCount);
+    fprintf(f, ",\n");
+
+#ifdef NO_PROFILER
+    fprintf(f, "  \"per_frame\": null,\n");
+#else
+    fprintf(f, "  \"per_frame\": {\"draw_calls\": %.1f, \"max_draw_calls\": %d, \"blocks\": %.1f, "
+               "\"vertices\": %.1f, \"max_vertices\": %d, \"texture_binds\": %.1f, \"state_changes\": %.1f},\n",
+            drawCalls / frameCount, maxDrawCalls, blocks / frameCount, vertices / frameCount, maxVertices,
+            textureBinds / frameCount, stateChanges / frameCount);
+#endif
+    fprintf(f, "  \"peak_memory_kb\": %ld,\n", peakMemoryKB());
+    fprintf(f, "  \"texture_memory_kb\": %.0f\n}\n", texture_memory_bytes() / 1024.0);
+
+    int result = fclose(f) == 0 ? 0 : 1;
+    if (result != 0)
+        fprintf(stderr, "Cannot write %s\n", outputFile);
+    else
+        printf("Benchmark: %d frames in %.0f ms (%.1f fps), results in %s\n", frameCount, totalMs,
+               frameCount * 1000.0 / totalMs, outputFile);
+    free(times);
+    return result;
+}
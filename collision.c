@@ -72,6 +72,34 @@ static void computeRotatedBounds(const SceneObject *sceneObject, int boxIndex,
     }
 }
 
+// Calculates the floor area covered by a whole object if it stood at (worldX, worldZ)
+void scene_object_footprint(const SceneObject *sceneObject, float worldX, float worldZ,
+                            float *minX, float *maxX, float *minZ, float *maxZ)
+{
+    *minX = *minZ = +1e9f;
+    *maxX = *maxZ = -1e9f;
+
+    // Merge the rotated bounds of every subbox
+    for (int boxIndex = 0; boxIndex < sceneObject->subBoxCount; boxIndex++)
+    {
+        float boxMinX, boxMaxX, boxMinY, boxMaxY, boxMinZ, boxMaxZ;
+        computeRotatedBounds(sceneObject, boxIndex, worldX, worldZ,
+                             &boxMinX, &boxMaxX, &boxMinY, &boxMaxY, &boxMinZ, &boxMaxZ);
+
+        *minX = fminf(*minX, boxMinX);
+        *maxX = fmaxf(*maxX, boxMaxX);
+        *minZ = fminf(*minZ, boxMinZ);
+        *maxZ = fmaxf(*maxZ, boxMaxZ);
+    }
+}
+
+// Calculates the world space box around one of an object's subboxes, as {xmin, xmax, ymin, ymax, zmin, zmax}
+void scene_object_box_bounds(const SceneObject *sceneObject, int boxIndex, float bounds[6])
+{
+    computeRotatedBounds(sceneObject, boxIndex, sceneObject->x, sceneObject->z,
+                         &bounds[0], &bounds[1], &bounds[2], &bounds[3], &bounds[4], &bounds[5]);
+}
+
 // Build the BoxOBB structure for the rotated box
 // Detailed check if the quick check says they might be hitting
 static void buildBoxOBB(const SceneObject *sceneObject, int boxIndex,
@@ -182,13 +210,99 @@ static int obbOverlapXZ(const BoxOBB *a, const BoxOBB *b)
 }
 /* --- END AI GENERATED CODE --- */
 
+// Check if one object standing at (newX, newZ) hits another object
+// Platforms it could stand on are not hits, but the highest one is remembered in bestPlatformTop
+static bool objectPairCollides(const SceneObject *movingObject, float newX, float newZ,
+                               const SceneObject *otherObject, bool allowStageSnap,
+                               float *bestPlatformTop)
+{
+    // Check every subbox of the moving object
+    for (int movingSubBoxIndex = 0; movingSubBoxIndex < movingObject->subBoxCount; movingSubBoxIndex++)
+    {
+        // Variables for the object
+        float movingAabbMinX, movingAabbMaxX, movingAabbMinY, movingAabbMaxY, movingAabbMinZ, movingAabbMaxZ;
+        BoxOBB movingObb;
+
+        // Calculate the bounds for the moving object at the new position
+        computeRotatedBounds(movingObject, movingSubBoxIndex, newX, newZ,
+                             &movingAabbMinX, &movingAabbMaxX,
+                             &movingAabbMinY, &movingAabbMaxY,
+                             &movingAabbMinZ, &movingAabbMaxZ);
+        buildBoxOBB(movingObject, movingSubBoxIndex, newX, newZ, &movingObb);
+
+        // Check against every subbox of the other object
+        for (int otherSubBoxIndex = 0; otherSubBoxIndex < otherObject->subBoxCount; otherSubBoxIndex++)
+        {
+            // Variables for the other object
+            float otherAabbMinX, otherAabbMaxX, otherAabbMinY, otherAabbMaxY, otherAabbMinZ, otherAabbMaxZ;
+            BoxOBB otherObb;
+
+            // Calculate bounds for the other object at its current position
+            computeRotatedBounds(otherObject, otherSubBoxIndex, otherObject->x, otherObject->z,
+                                 &otherAabbMinX, &otherAabbMaxX,
+                                 &otherAabbMinY, &otherAabbMaxY,
+                                 &otherAabbMinZ, &otherAabbMaxZ);
+            buildBoxOBB(otherObject, otherSubBoxIndex, otherObject->x, otherObject->z, &otherObb);
+
+            // Quick Check (AABB)
+            // If the simple outer boxes don't touch, we can stop right here
+            bool aabbOverlapXZ =
+                (movingAabbMaxX > otherAabbMinX && movingAabbMinX < otherAabbMaxX &&
+                 movingAabbMaxZ > otherAabbMinZ && movingAabbMinZ < otherAabbMaxZ);
+
+            if (!aabbOverlapXZ)
+                continue; // Too far apart, check next object
+
+            // Detailed Check (OBB)
+            // The outer boxes touched, so check the rotated boxes
+            if (!obbOverlapXZ(&movingObb, &otherObb))
+                continue;
+
+            // Height Check
+            // Check if the object is a Stage that we can walk on
+            bool isPlatform = allowStageSnap &&
+                              strstr(otherObject->name, "Stage") != NULL;
+
+            if (isPlatform)
+            {
+                float stageTop = otherObb.maxY;
+
+                // If the player's feet are above the platform top
+                if (movingObb.minY >= stageTop - 2.0f)
+                {
+                    // Save the highest platform we are standing on
+                    if (stageTop > *bestPlatformTop)
+                        *bestPlatformTop = stageTop;
+
+                    // It's a floor, not a wall, so don't block movement
+                    continue;
+                }
+            }
+
+            // Check if they overlap vertically (Height)
+            bool yOverlap =
+                (movingObb.maxY > otherObb.minY && movingObb.minY < otherObb.maxY);
+
+            // Overlapping in X, Z, and Y
+            if (yOverlap)
+            {
+                // Collision detected, no movement allowed
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 // Check if moving an object to a new spot causes a crash
 bool collidesWithAnyObject(SceneObject *movingObject, float newX, float newZ,
                            bool adjustPlayerHeight, bool allowStageSnap)
 {
+    double traceStart = TRACE_NOW();
     float bestPlatformTop = 0.0f;
     float playerHeight = 0.0f;
-    
+
     // If we need to adjust the player height, find out how tall the player is
     if (adjustPlayerHeight)
     {
@@ -204,80 +318,10 @@ bool collidesWithAnyObject(SceneObject *movingObject, float newX, float newZ,
         if (otherObject == movingObject || !otherObject->solid)
             continue;
 
-        // Check every subbox of the moving object
-        for (int movingSubBoxIndex = 0; movingSubBoxIndex < movingObject->subBoxCount; movingSubBoxIndex++)
+        if (objectPairCollides(movingObject, newX, newZ, otherObject, allowStageSnap, &bestPlatformTop))
         {
-            // Variables for the object
-            float movingAabbMinX, movingAabbMaxX, movingAabbMinY, movingAabbMaxY, movingAabbMinZ, movingAabbMaxZ;
-            BoxOBB movingObb;
-
-            // Calculate the bounds for the moving object at the new position
-            computeRotatedBounds(movingObject, movingSubBoxIndex, newX, newZ,
-                                 &movingAabbMinX, &movingAabbMaxX,
-                                 &movingAabbMinY, &movingAabbMaxY,
-                                 &movingAabbMinZ, &movingAabbMaxZ);
-            buildBoxOBB(movingObject, movingSubBoxIndex, newX, newZ, &movingObb);
-
-            // Check against every subbox of the other object
-            for (int otherSubBoxIndex = 0; otherSubBoxIndex < otherObject->subBoxCount; otherSubBoxIndex++)
-            {
-                // Variables for the other object
-                float otherAabbMinX, otherAabbMaxX, otherAabbMinY, otherAabbMaxY, otherAabbMinZ, otherAabbMaxZ;
-                BoxOBB otherObb;
-                
-                // Calculate bounds for the other object at its current position
-                computeRotatedBounds(otherObject, otherSubBoxIndex, otherObject->x, otherObject->z,
-                                     &otherAabbMinX, &otherAabbMaxX,
-                                     &otherAabbMinY, &otherAabbMaxY,
-                                     &otherAabbMinZ, &otherAabbMaxZ);
-                buildBoxOBB(otherObject, otherSubBoxIndex, otherObject->x, otherObject->z, &otherObb);
-
-                // Quick Check (AABB)
-                // If the simple outer boxes don't touch, we can stop right here
-                bool aabbOverlapXZ =
-                    (movingAabbMaxX > otherAabbMinX && movingAabbMinX < otherAabbMaxX &&
-                     movingAabbMaxZ > otherAabbMinZ && movingAabbMinZ < otherAabbMaxZ);
-
-                if (!aabbOverlapXZ)
-                    continue; // Too far apart, check next object
-
-                // Detailed Check (OBB)
-                // The outer boxes touched, so check the rotated boxes
-                if (!obbOverlapXZ(&movingObb, &otherObb))
-                    continue;
-
-                // Height Check
-                // Check if the object is a Stage that we can walk on
-                bool isPlatform = allowStageSnap &&
-                                   strstr(otherObject->name, "Stage") != NULL;
-
-                if (isPlatform)
-                {
-                    float stageTop = otherObb.maxY; 
-
-                    // If the player's feet are above the platform top
-                    if (movingObb.minY >= stageTop - 2.0f)
-                    {
-                        // Save the highest platform we are standing on
-                        if (stageTop > bestPlatformTop)
-                            bestPlatformTop = stageTop;
-
-                        // It's a floor, not a wall, so don't block movement
-                        continue;
-                    }
-                }
-
-                // Check if they overlap vertically (Height)
-                bool yOverlap =
-                    (movingObb.maxY > otherObb.minY && movingObb.minY < otherObb.maxY);
-
-                // Overlapping in X, Z, and Y
-                if (yOverlap)
-                {
-                    // Collision detected, no movement allowed
-                    return true;
-                }
-            }
+            TRACE_RECORD("collidesWithAnyObject", "collision", traceStart);
+            return true;
         }
     }
 
@@ -304,9 +348,85 @@ bool collidesWithAnyObject(SceneObject *movingObject, float newX, float newZ,
         }
     }
 
+    TRACE_RECORD("collidesWithAnyObject", "collision", traceStart);
     return false; // Safe to move
 }
 
+// Floor area of one object, used by the batch overlap check
+typedef struct
+{
+    int index;
+    float minX, maxX, minZ, maxZ;
+} FootprintEntry;
+
+// Sort helper: orders footprints by their left edge
+static int compareFootprintMinX(const void *a, const void *b)
+{
+    float minA = ((const FootprintEntry *)a)->minX;
+    float minB = ((const FootprintEntry *)b)->minX;
+    return (minA > minB) - (minA < minB);
+}
+
+// Checks all objects from firstIndex onwards for overlaps in one batch
+// Footprints are sorted along X so only neighbours are compared in detail
+// Returns the number of overlapping pairs and prints the first few
+int scene_check_overlaps(int firstIndex)
+{
+    if (objectCount <= 0)
+        return 0;
+
+    FootprintEntry *entries = (FootprintEntry *)malloc(objectCount * sizeof(FootprintEntry));
+    if (!entries)
+        return 0;
+
+    // Work out every footprint once
+    int entryCount = 0;
+    for (int i = 0; i < objectCount; i++)
+    {
+        if (!objects[i].solid || objects[i].subBoxCount == 0)
+            continue;
+
+        FootprintEntry *entry = &entries[entryCount++];
+        entry->index = i;
+        scene_object_footprint(&objects[i], objects[i].x, objects[i].z,
+                               &entry->minX, &entry->maxX, &entry->minZ, &entry->maxZ);
+    }
+
+    qsort(entries, entryCount, sizeof(FootprintEntry), compareFootprintMinX);
+
+    // Sweep along X, stopping as soon as the next footprint starts past this one
+    int overlapCount = 0;
+    for (int i = 0; i < entryCount; i++)
+    {
+        for (int j = i + 1; j < entryCount && entries[j].minX < entries[i].maxX; j++)
+        {
+            int indexA = entries[i].index;
+            int indexB = entries[j].index;
+
+            // Pairs where both objects were already in the scene are not our business
+            if (indexA < firstIndex && indexB < firstIndex)
+                continue;
+            if (entries[j].maxZ <= entries[i].minZ || entries[j].minZ >= entries[i].maxZ)
+                continue;
+
+            // Let the newer object be the moving one so stage platforms are handled the usual way
+            SceneObject *movingObject = &objects[indexA > indexB ? indexA : indexB];
+            SceneObject *otherObject = &objects[indexA > indexB ? indexB : indexA];
+            float bestPlatformTop = 0.0f;
+
+            if (objectPairCollides(movingObject, movingObject->x, movingObject->z, otherObject, true, &bestPlatformTop))
+            {
+                if (overlapCount < 10)
+                    printf("Overlap: %s and %s\n", movingObject->name, otherObject->name);
+                overlapCount++;
+            }
+        }
+    }
+
+    free(entries);
+    return overlapCount;
+}
+
 // Helper funciton to dry run a rotation to see if it hits anything
 bool checkRotationCollision(SceneObject *sceneObject, float newRotation)
 {
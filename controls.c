@@ -7,6 +7,22 @@ void controls_key(unsigned char key, int x, int y)
     (void)y;
     const double speed = 0.8;
     const double yawDegrees = yaw;
+    double traceStart = TRACE_NOW();
+
+    // The layout browser takes its keys first while it is open
+    if (library_browser_key(key))
+    {
+        TRACE_RECORD("controls_key", "input", traceStart);
+        glutPostRedisplay();
+        return;
+    }
+
+    // The hall is locked while the optimizer works on it; ESC still quits
+    if (layout_optimize_running() && key != 27)
+    {
+        printf("Optimizer is still running.\n");
+        return;
+    }
 
     switch (key)
     {
@@ -22,7 +38,10 @@ void controls_key(unsigned char key, int x, int y)
         snapToGridEnabled = !snapToGridEnabled;
         printf("Snap-to-grid %s.\n", snapToGridEnabled ? "enabled" : "disabled");
         if (snapToGridEnabled)
+        {
             scene_snap_all_objects();
+            journal_checkpoint(); // Everything may have moved
+        }
         break;
 
     // Cycle through light modes
@@ -73,7 +92,7 @@ void controls_key(unsigned char key, int x, int y)
 
     // Save scene layout
     case '/':
-        save_scene("layout.csv");
+        save_scene_async("layout.csv");
         break;
 
     // Load scene layout
@@ -206,13 +225,31 @@ void controls_key(unsigned char key, int x, int y)
     // Rotate selected object clockwise
     case 'r':
         if (selectedObject)
+        {
+            SceneTransform before;
+            scene_get_transform(selectedObject, &before);
             rotateObject(selectedObject, 15.0f);
+            if (selectedObject->rotation != before.rotation)
+            {
+                journal_rotate(selectedObject);
+                undo_record_transform(selectedObject, &before);
+            }
+        }
         break;
 
     // Rotate selected object counter-clockwise
     case 'R':
         if (selectedObject)
+        {
+            SceneTransform before;
+            scene_get_transform(selectedObject, &before);
             rotateObject(selectedObject, -15.0f);
+            if (selectedObject->rotation != before.rotation)
+            {
+                journal_rotate(selectedObject);
+                undo_record_transform(selectedObject, &before);
+            }
+        }
         break;
 
     // Remove selected object
@@ -221,30 +258,47 @@ void controls_key(unsigned char key, int x, int y)
         scene_remove_selected_object();
         break;
 
-    // Spawn objects on ground
+    // Spawn objects on ground (queued, the search runs over the next frames)
     case '1':
-        scene_spawn_object(SPAWN_LAMP);
+        scene_spawn_request(SPAWN_LAMP);
         break;
     case '2':
-        scene_spawn_object(SPAWN_EVENT_TABLE);
+        scene_spawn_request(SPAWN_EVENT_TABLE);
         break;
     case '3':
-        scene_spawn_object(SPAWN_MEETING_TABLE);
+        scene_spawn_request(SPAWN_MEETING_TABLE);
         break;
     case '4':
-        scene_spawn_object(SPAWN_BAR_CHAIR);
+        scene_spawn_request(SPAWN_BAR_CHAIR);
         break;
     case '5':
-        scene_spawn_object(SPAWN_BANQUET_CHAIR);
+        scene_spawn_request(SPAWN_BANQUET_CHAIR);
         break;
     case '6':
-        scene_spawn_object(SPAWN_COCKTAIL_1);
+        scene_spawn_request(SPAWN_COCKTAIL_1);
         break;
     case '7':
-        scene_spawn_object(SPAWN_COCKTAIL_2);
+        scene_spawn_request(SPAWN_COCKTAIL_2);
         break;
     case '8':
-        scene_spawn_object(SPAWN_COCKTAIL_3);
+        scene_spawn_request(SPAWN_COCKTAIL_3);
+        break;
+
+    // Pick the bulk spawn pattern
+    case 'p':
+    case 'P':
+        scene_pattern_cycle();
+        break;
+
+    // Stamp the picked pattern
+    case '9':
+        scene_spawn_active_pattern();
+        break;
+
+    // Fill the hall with as many seats as fit
+    case 'o':
+    case 'O':
+        layout_optimize_default();
         break;
 
     // Reset scene
@@ -263,11 +317,82 @@ void controls_key(unsigned char key, int x, int y)
         selectedObject = NULL;
         break;
 
+    // Undo the last edit
+    case 'u':
+        undo_undo();
+        break;
+
+    // Redo the last undone edit
+    case 'U':
+        undo_redo();
+        break;
+
+    // Save the layout into the library
+    case 'k':
+        library_save_current();
+        break;
+
+    // Browse the layout library
+    case 'K':
+        library_browser_toggle();
+        break;
+
+    // Cycle texture filtering (bilinear, trilinear mipmaps, anisotropic)
+    case 'f':
+        texture_cycle_filter();
+        break;
+
+    // Show or hide texture memory and filtering in the HUD
+    case 'F':
+        textureStatsShown = !textureStatsShown;
+        if (textureStatsShown)
+            texture_print_report();
+        break;
+
+    // Toggle the baked room lighting
+    case 'h':
+    case 'H':
+        lightmapsEnabled = !lightmapsEnabled;
+        printf("Baked lighting %s.\n", lightmapsEnabled ? "on" : "off");
+        break;
+
+    // Show or hide the frame phase timings
+    case 'i':
+    case 'I':
+        profilerShown = !profilerShown;
+        break;
+
+    // Show or hide the draw call counts
+    case 'c':
+        drawCountsShown = !drawCountsShown;
+        break;
+
+    // Start or stop writing the draw call counts to a CSV file
+    case 'C':
+        draw_count_toggle_csv();
+        break;
+
+    // Start or stop recording a trace
+    case 't':
+    case 'T':
+        trace_toggle();
+        break;
+
+    // Toggle autosave
+    case 'v':
+    case 'V':
+        autosaveEnabled = !autosaveEnabled;
+        printf("Autosave %s.\n", autosaveEnabled ? "on" : "off");
+        break;
+
     // Exit program (ESC)
+    // Queued saves are finished and the edit journal is cleared by exit handlers
     case 27:
+        TRACE_RECORD("controls_key", "input", traceStart);
         exit(0);
     }
 
+    TRACE_RECORD("controls_key", "input", traceStart);
     glutPostRedisplay();
 }
 
@@ -277,6 +402,13 @@ void controls_special(int key, int x, int y)
     (void)x;
     (void)y;
 
+    // Arrow keys pick a layout while the browser is open
+    if (library_browser_special(key))
+    {
+        glutPostRedisplay();
+        return;
+    }
+
     if (mode == 1)
     {
         // FPV look controls
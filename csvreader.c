@@ -0,0 +1,249 @@
+#include "CSCIx229.h"
+
+// Bytes read from the file at a time
+#define CSV_BLOCK_SIZE 65536
+
+// Significant digits kept when parsing a number (a float is decided by its first 112)
+#define CSV_MAX_DIGITS 120
+
+// Largest mantissa a float holds exactly (2^24)
+#define CSV_EXACT_MANTISSA 16777216UL
+
+// Powers of ten a float holds exactly
+static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10};
+
+// Opens a CSV file for reading
+// Returns 0 on success, -1 if the file can't be opened
+int csv_open(CsvReader *reader, const char *filename)
+{
+    memset(reader, 0, sizeof(CsvReader));
+
+    reader->file = fopen(filename, "rb");
+    if (!reader->file)
+        return -1;
+
+    reader->capacity = CSV_BLOCK_SIZE;
+    reader->buffer = (char *)malloc(reader->capacity + 1);
+    if (!reader->buffer)
+    {
+        fclose(reader->file);
+        reader->file = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+// Closes the file and frees the buffer
+void csv_close(CsvReader *reader)
+{
+    if (reader->file)
+        fclose(reader->file);
+    free(reader->buffer);
+    memset(reader, 0, sizeof(CsvReader));
+}
+
+// Pulls the next block of the file in behind whatever is left of the current one
+// Returns 0 once there is nothing more to read
+static int refill(CsvReader *reader)
+{
+    if (reader->atEnd)
+        return 0;
+
+    // Slide the unfinished line to the front
+    size_t remaining = reader->end - reader->start;
+    if (reader->start > 0)
+    {
+        memmove(reader->buffer, reader->buffer + reader->start, remaining);
+        reader->start = 0;
+        reader->end = remaining;
+    }
+
+    // A line longer than the whole buffer: grow it (only happens for very long lines)
+    if (reader->end == reader->capacity)
+    {
+        size_t newCapacity = reader->capacity * 2;
+        char *grown = (char *)realloc(reader->buffer, newCapacity + 1);
+        if (!grown)
+            return 0;
+        reader->buffer = grown;
+        reader->capacity = newCapacity;
+    }
+
+    size_t readCount = fread(reader->buffer + reader->end, 1, reader->capacity - reader->end, reader->file);
+    if (readCount == 0)
+        reader->atEnd = 1;
+    reader->end += readCount;
+    return readCount > 0;
+}
+
+// Reads the next line and splits it into fields in place
+// Returns the number of fields (a blank line has one empty field), or -1 at the end of the file
+int csv_next_record(CsvReader *reader)
+{
+    // Find the end of the line, reading more of the file as needed
+    size_t searched = 0; // bytes of this line already checked for a newline
+    char *lineEnd = NULL;
+    while (1)
+    {
+        lineEnd = (char *)memchr(reader->buffer + reader->start + searched, '\n',
+                                 reader->end - reader->start - searched);
+        if (lineEnd)
+            break;
+
+        // refill() keeps the line but may move it to the front of the buffer
+        searched = reader->end - reader->start;
+        if (!refill(reader))
+        {
+            // Last line without a newline
+            if (reader->start == reader->end)
+                return -1;
+            lineEnd = reader->buffer + reader->end;
+            break;
+        }
+    }
+
+    char *line = reader->buffer + reader->start;
+    size_t lineLength = lineEnd - line;
+    reader->start = (lineEnd - reader->buffer) + (lineEnd < reader->buffer + reader->end ? 1 : 0);
+    reader->line++;
+
+    // Drop the carriage return of Windows line endings
+    if (lineLength > 0 && line[lineLength - 1] == '\r')
+        lineLength--;
+    line[lineLength] = '\0';
+
+    // Split on commas
+    reader->fieldCount = 0;
+    char *field = line;
+    while (1)
+    {
+        if (reader->fieldCount < CSV_MAX_FIELDS)
+        {
+            reader->fields[reader->fieldCount] = field;
+            reader->fieldColumns[reader->fieldCount] = (int)(field - line) + 1;
+        }
+        reader->fieldCount++;
+
+        char *comma = strchr(field, ',');
+        if (!comma)
+            break;
+        *comma = '\0';
+        field = comma + 1;
+    }
+
+    return reader->fieldCount;
+}
+
+// Helper function to add one digit to the significant digits of a number
+// Leading zeros are dropped; past CSV_MAX_DIGITS only whether anything nonzero followed is kept
+static void addDigit(char *digits, int *digitCount, int *exponent, char digit, int afterPoint)
+{
+    if (*digitCount == 0 && digit == '0')
+    {
+        if (afterPoint)
+            (*exponent)--;
+        return;
+    }
+
+    if (*digitCount < CSV_MAX_DIGITS)
+    {
+        digits[(*digitCount)++] = digit;
+        if (afterPoint)
+            (*exponent)--;
+    }
+    else
+    {
+        // A float never needs more digits than this to round the right way; a trailing 1 stands for the rest
+        if (digit != '0')
+            digits[CSV_MAX_DIGITS] = '1';
+        if (!afterPoint)
+            (*exponent)++;
+    }
+}
+
+// Parses a decimal number such as "-12.5000" or "3e-2" without going through the C locale
+// The result is rounded exactly like strtof/sscanf("%f") would round it
+// Returns 1 if the whole text was a valid number
+int csv_parse_float(const char *text, float *out)
+{
+    const char *ch = text;
+
+    // Surrounding spaces are allowed, like %f
+    while (*ch == ' ' || *ch == '\t')
+        ch++;
+
+    int negative = 0;
+    if (*ch == '-' || *ch == '+')
+        negative = (*ch++ == '-');
+
+    // Collect the significant digits, remembering how far the decimal point moved
+    char digits[CSV_MAX_DIGITS + 2] = {0};
+    int digitCount = 0;
+    int exponent = 0;
+    int sawDigit = 0;
+
+    while (*ch >= '0' && *ch <= '9')
+    {
+        sawDigit = 1;
+        addDigit(digits, &digitCount, &exponent, *ch++, 0);
+    }
+
+    if (*ch == '.')
+    {
+        ch++;
+        while (*ch >= '0' && *ch <= '9')
+        {
+            sawDigit = 1;
+            addDigit(digits, &digitCount, &exponent, *ch++, 1);
+        }
+    }
+
+    if (!sawDigit)
+        return 0;
+
+    // Optional exponent
+    if (*ch == 'e' || *ch == 'E')
+    {
+        ch++;
+        int exponentNegative = 0;
+        if (*ch == '-' || *ch == '+')
+            exponentNegative = (*ch++ == '-');
+        if (*ch < '0' || *ch > '9')
+            return 0;
+
+        int value = 0;
+        while (*ch >= '0' && *ch <= '9')
+        {
+            if (value < 10000)
+                value = value * 10 + (*ch - '0');
+            ch++;
+        }
+        exponent += exponentNegative ? -value : value;
+    }
+
+    while (*ch == ' ' || *ch == '\t')
+        ch++;
+    if (*ch != '\0')
+        return 0;
+
+    // Short numbers (all a layout holds): the digits and the power of ten are both exact floats,
+    // so one multiply or divide in double rounds to the same float as the exact value would
+    unsigned long mantissa = 0;
+    for (int i = 0; i < digitCount && mantissa <= CSV_EXACT_MANTISSA; i++)
+        mantissa = mantissa * 10 + (digits[i] - '0');
+    if (mantissa <= CSV_EXACT_MANTISSA && digits[CSV_MAX_DIGITS] == '\0' && exponent >= -10 && exponent <= 10)
+    {
+        double value = (exponent >= 0) ? mantissa * powersOfTen[exponent] : mantissa / powersOfTen[-exponent];
+        *out = (float)(negative ? -value : value);
+        return 1;
+    }
+
+    // Anything else goes to strtof as plain digits and an exponent, which has no decimal point for the locale to change
+    char number[CSV_MAX_DIGITS + 24];
+    int stickyDigit = digits[CSV_MAX_DIGITS] != '\0';
+    snprintf(number, sizeof(number), "%s%se%d", negative ? "-" : "", digitCount ? digits : "0",
+             digitCount ? exponent - stickyDigit : 0);
+    *out = strtof(number, NULL);
+    return 1;
+}
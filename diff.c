@@ -0,0 +1,362 @@
+#include "CSCIx229.h"
+
+// Differences smaller than this are rounding from the CSV format
+#define POSITION_EPSILON 1e-3f
+#define ANGLE_EPSILON 1e-2f
+
+// Hash table from object name to record index (open addressing, linear probing)
+typedef struct
+{
+    int *slots; // record index, -1 for empty
+    unsigned int mask;
+    const LayoutRecord *records;
+} NameIndex;
+
+// FNV-1a hash of an object name
+static unsigned int hashName(const char *name)
+{
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < 32 && name[i]; i++)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Builds the index for a list of records; a repeated name keeps its first record
+// Returns 0 on success
+static int buildIndex(NameIndex *index, const LayoutRecord *records, int recordCount)
+{
+    // At most half full so lookups stay short
+    unsigned int capacity = 16;
+    while (capacity < (unsigned int)recordCount * 2)
+        capacity *= 2;
+
+    index->slots = (int *)malloc(capacity * sizeof(int));
+    if (!index->slots)
+        return -1;
+    memset(index->slots, 0xff, capacity * sizeof(int));
+    index->mask = capacity - 1;
+    index->records = records;
+
+    for (int i = 0; i < recordCount; i++)
+    {
+        unsigned int slot = hashName(records[i].name) & index->mask;
+        while (index->slots[slot] >= 0 &&
+               strncmp(records[index->slots[slot]].name, records[i].name, sizeof(records[i].name)) != 0)
+            slot = (slot + 1) & index->mask;
+
+        if (index->slots[slot] < 0)
+            index->slots[slot] = i;
+    }
+
+    return 0;
+}
+
+// Finds a record by name, -1 if it isn't there
+static int findName(const NameIndex *index, const char *name)
+{
+    unsigned int slot = hashName(name) & index->mask;
+    while (index->slots[slot] >= 0)
+    {
+        if (strncmp(index->records[index->slots[slot]].name, name, sizeof(index->records[0].name)) == 0)
+            return index->slots[slot];
+        slot = (slot + 1) & index->mask;
+    }
+    return -1;
+}
+
+// Helper function to check if two objects stand in the same place
+static int samePosition(const LayoutRecord *a, const LayoutRecord *b)
+{
+    return fabsf(a->x - b->x) <= POSITION_EPSILON &&
+           fabsf(a->y - b->y) <= POSITION_EPSILON &&
+           fabsf(a->z - b->z) <= POSITION_EPSILON;
+}
+
+// Helper function to check if two objects face the same way (0 and 360 are the same)
+static int sameRotation(const LayoutRecord *a, const LayoutRecord *b)
+{
+    float difference = fmodf(fabsf(a->rotation - b->rotation), 360.0f);
+    return difference <= ANGLE_EPSILON || difference >= 360.0f - ANGLE_EPSILON;
+}
+
+// Helper function to check if two objects have the same size
+static int sameScale(const LayoutRecord *a, const LayoutRecord *b)
+{
+    return fabsf(a->scale - b->scale) <= POSITION_EPSILON;
+}
+
+// Helper function to check if two objects are placed exactly alike
+static int sameTransform(const LayoutRecord *a, const LayoutRecord *b)
+{
+    return samePosition(a, b) && sameRotation(a, b) && sameScale(a, b);
+}
+
+// Helper function to add an entry to the diff list
+static int addDiffEntry(LayoutDiffEntry **entries, int *entryCount, int *capacity,
+                        const char *name, int flags, int indexA, int indexB)
+{
+    if (*entryCount == *capacity)
+    {
+        int newCapacity = *capacity ? *capacity * 2 : 64;
+        LayoutDiffEntry *grown = (LayoutDiffEntry *)realloc(*entries, newCapacity * sizeof(LayoutDiffEntry));
+        if (!grown)
+            return 0;
+        *entries = grown;
+        *capacity = newCapacity;
+    }
+
+    LayoutDiffEntry *entry = &(*entries)[(*entryCount)++];
+    memcpy(entry->name, name, sizeof(entry->name));
+    entry->flags = flags;
+    entry->indexA = indexA;
+    entry->indexB = indexB;
+    return 1;
+}
+
+// Compares two layouts object by object, matching objects by name
+// Changed objects are listed in the order of b, then objects only in a
+// Returns the number of differences (the list is malloc'd), or -1 if out of memory
+int layout_diff(const LayoutRecord *a, int countA, const LayoutRecord *b, int countB,
+                LayoutDiffEntry **entriesOut)
+{
+    *entriesOut = NULL;
+
+    NameIndex indexA, indexB;
+    if (buildIndex(&indexA, a, countA) != 0)
+        return -1;
+    if (buildIndex(&indexB, b, countB) != 0)
+    {
+        free(indexA.slots);
+        return -1;
+    }
+
+    LayoutDiffEntry *entries = NULL;
+    int entryCount = 0;
+    int capacity = 0;
+    int ok = 1;
+
+    // Objects in b: new, or changed since a
+    for (int i = 0; i < countB && ok; i++)
+    {
+        int match = findName(&indexA, b[i].name);
+        if (match < 0)
+        {
+            ok = addDiffEntry(&entries, &entryCount, &capacity, b[i].name, DIFF_ADDED, -1, i);
+            continue;
+        }
+
+        int flags = 0;
+        if (!samePosition(&a[match], &b[i]))
+            flags |= DIFF_MOVED;
+        if (!sameRotation(&a[match], &b[i]))
+            flags |= DIFF_ROTATED;
+        if (!sameScale(&a[match], &b[i]))
+            flags |= DIFF_SCALED;
+
+        if (flags)
+            ok = addDiffEntry(&entries, &entryCount, &capacity, b[i].name, flags, match, i);
+    }
+
+    // Objects only in a were removed
+    for (int i = 0; i < countA && ok; i++)
+    {
+        if (findName(&indexB, a[i].name) < 0)
+            ok = addDiffEntry(&entries, &entryCount, &capacity, a[i].name, DIFF_REMOVED, i, -1);
+    }
+
+    free(indexA.slots);
+    free(indexB.slots);
+
+    if (!ok)
+    {
+        free(entries);
+        return -1;
+    }
+
+    *entriesOut = entries;
+    return entryCount;
+}
+
+// Helper function to add a conflict to the list
+static int addConflict(LayoutMergeConflict **conflicts, int *conflictCount, int *capacity,
+                       const char *name, LayoutMergeConflictType type)
+{
+    if (*conflictCount == *capacity)
+    {
+        int newCapacity = *capacity ? *capacity * 2 : 16;
+        LayoutMergeConflict *grown = (LayoutMergeConflict *)realloc(*conflicts, newCapacity * sizeof(LayoutMergeConflict));
+        if (!grown)
+            return 0;
+        *conflicts = grown;
+        *capacity = newCapacity;
+    }
+
+    LayoutMergeConflict *conflict = &(*conflicts)[(*conflictCount)++];
+    memcpy(conflict->name, name, sizeof(conflict->name));
+    conflict->type = type;
+    conflict->renamed[0] = '\0';
+    return 1;
+}
+
+// Helper function to make up a name that none of the three layouts uses, like a new spawn would get
+// ("BanquetChair_New12"); counter remembers where the last search for this type stopped
+static void uniqueName(const LayoutRecord *record, const NameIndex *indexes[3], int *counter, char *name)
+{
+    while (1)
+    {
+        (*counter)++;
+        if (record->type >= 0 && record->type < SPAWN_TYPE_COUNT)
+            snprintf(name, 32, "%s_New%d", scene_spawn_type_name((SceneSpawnType)record->type), *counter);
+        else
+            snprintf(name, 32, "%.19s_%d", record->name, *counter);
+
+        if (findName(indexes[0], name) < 0 && findName(indexes[1], name) < 0 && findName(indexes[2], name) < 0)
+            return;
+    }
+}
+
+// Merges one object that is in all three layouts, one property at a time
+// Returns 1 if ours and theirs changed the same property in different ways (ours is kept)
+static int mergeChanged(const LayoutRecord *base, const LayoutRecord *ours, const LayoutRecord *theirs,
+                        LayoutRecord *merged)
+{
+    int conflict = 0;
+    *merged = *ours;
+
+    // Position
+    if (samePosition(ours, base))
+    {
+        merged->x = theirs->x;
+        merged->y = theirs->y;
+        merged->z = theirs->z;
+    }
+    else if (!samePosition(theirs, base) && !samePosition(ours, theirs))
+        conflict = 1;
+
+    // Rotation
+    if (sameRotation(ours, base))
+        merged->rotation = theirs->rotation;
+    else if (!sameRotation(theirs, base) && !sameRotation(ours, theirs))
+        conflict = 1;
+
+    // Scale
+    if (sameScale(ours, base))
+        merged->scale = theirs->scale;
+    else if (!sameScale(theirs, base) && !sameScale(ours, theirs))
+        conflict = 1;
+
+    return conflict;
+}
+
+// Three way merge of two edited copies of the same base layout, matching objects by name
+// Changes made on only one side are taken; when both sides changed the same thing differently,
+// ours is kept and a conflict is reported. New objects get names like "BanquetChair_New3" on
+// both sides, so when both added the same name in different places both are kept and theirs is renamed
+// Returns the number of conflicts, or -1 if out of memory
+int layout_merge(const LayoutRecord *base, int baseCount,
+                 const LayoutRecord *ours, int oursCount,
+                 const LayoutRecord *theirs, int theirsCount,
+                 LayoutRecordList *merged, LayoutMergeConflict **conflictsOut)
+{
+    *conflictsOut = NULL;
+
+    NameIndex baseIndex, oursIndex, theirsIndex;
+    baseIndex.slots = oursIndex.slots = theirsIndex.slots = NULL;
+    if (buildIndex(&baseIndex, base, baseCount) != 0 ||
+        buildIndex(&oursIndex, ours, oursCount) != 0 ||
+        buildIndex(&theirsIndex, theirs, theirsCount) != 0)
+    {
+        free(baseIndex.slots);
+        free(oursIndex.slots);
+        free(theirsIndex.slots);
+        return -1;
+    }
+
+    LayoutMergeConflict *conflicts = NULL;
+    int conflictCount = 0;
+    int capacity = 0;
+    int ok = 1;
+
+    // Where the search for a free name stopped, per type (the last one for unknown types)
+    const NameIndex *indexes[3] = {&baseIndex, &oursIndex, &theirsIndex};
+    int renameCounters[SPAWN_TYPE_COUNT + 1] = {0};
+
+    // Everything in ours, in its order
+    for (int i = 0; i < oursCount && ok; i++)
+    {
+        int baseMatch = findName(&baseIndex, ours[i].name);
+        int theirsMatch = findName(&theirsIndex, ours[i].name);
+        LayoutRecord record = ours[i];
+
+        // Objects we added are taken as they are (a same named one of theirs is handled below)
+        if (baseMatch >= 0 && theirsMatch < 0)
+        {
+            // They removed it: fine unless we changed it
+            if (sameTransform(&ours[i], &base[baseMatch]))
+                continue;
+            ok = addConflict(&conflicts, &conflictCount, &capacity, ours[i].name, MERGE_CHANGED_AND_REMOVED);
+        }
+        else if (baseMatch >= 0 && mergeChanged(&base[baseMatch], &ours[i], &theirs[theirsMatch], &record))
+        {
+            ok = addConflict(&conflicts, &conflictCount, &capacity, ours[i].name, MERGE_BOTH_CHANGED);
+        }
+
+        if (ok)
+            ok = layout_collect_record(&record, merged);
+    }
+
+    // Objects only they have: new on their side, or removed by us, and their half of a name both added
+    for (int i = 0; i < theirsCount && ok; i++)
+    {
+        int baseMatch = findName(&baseIndex, theirs[i].name);
+        int oursMatch = findName(&oursIndex, theirs[i].name);
+        if (oursMatch >= 0)
+        {
+            // Both added an object under this name: the same one if it stands in the same place,
+            // otherwise two different ones, so theirs comes along under a new name
+            if (baseMatch >= 0 || sameTransform(&ours[oursMatch], &theirs[i]))
+                continue;
+
+            LayoutRecord record = theirs[i];
+            int type = (record.type >= 0 && record.type < SPAWN_TYPE_COUNT) ? record.type : SPAWN_TYPE_COUNT;
+            uniqueName(&theirs[i], indexes, &renameCounters[type], record.name);
+            ok = addConflict(&conflicts, &conflictCount, &capacity, theirs[i].name, MERGE_BOTH_ADDED);
+            if (ok)
+            {
+                memcpy(conflicts[conflictCount - 1].renamed, record.name, sizeof(record.name));
+                ok = layout_collect_record(&record, merged);
+            }
+            continue;
+        }
+
+        if (baseMatch < 0)
+        {
+            ok = layout_collect_record(&theirs[i], merged);
+            continue;
+        }
+
+        // We removed it: fine unless they changed it
+        if (!sameTransform(&theirs[i], &base[baseMatch]))
+        {
+            ok = addConflict(&conflicts, &conflictCount, &capacity, theirs[i].name, MERGE_CHANGED_AND_REMOVED);
+            if (ok)
+                ok = layout_collect_record(&theirs[i], merged);
+        }
+    }
+
+    free(baseIndex.slots);
+    free(oursIndex.slots);
+    free(theirsIndex.slots);
+
+    if (!ok)
+    {
+        free(conflicts);
+        return -1;
+    }
+
+    *conflictsOut = conflicts;
+    return conflictCount;
+}
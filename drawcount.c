@@ -0,0 +1,261 @@
+#include "CSCIx229.h"
+#include <time.h>
+
+// Draw call counters: draw calls, glBegin/glEnd blocks, vertices, texture binds and glEnable/glDisable
+// calls made each frame. The GL calls are wrapped by macros in CSCIx229.h, which only bump the running
+// totals in drawCounts. DRAW_GROUP / DRAW_OBJECT file what was counted since the last switch under the
+// group that was drawing, so a switch costs a subtraction and no GL calls are slowed down further.
+#define DRAW_GROUP_MAX 32
+#define DRAW_FUNC_MAX 64
+
+int drawCountsShown = 0;
+
+#ifndef NO_PROFILER
+DrawCounts drawCounts = {0};
+
+// Rows of the table; the object types are added as they are first drawn
+static const char *groupNames[DRAW_GROUP_MAX] = {
+    [DRAW_OTHER] = "Other",
+    [DRAW_ROOM] = "Room",
+    [DRAW_OUTLINE] = "Outline",
+    [DRAW_FIRE] = "Fire",
+    [DRAW_CEILING] = "Ceiling",
+    [DRAW_HUD] = "HUD"};
+static char typeNames[DRAW_GROUP_MAX][32];
+static int groupCount = DRAW_GROUP_FIXED;
+
+// Draw function of each object type seen so far and its group
+static void (*groupDrawFuncs[DRAW_FUNC_MAX])(float, float);
+static int groupOfDrawFunc[DRAW_FUNC_MAX];
+static int drawFuncCount = 0;
+
+static DrawCounts groupCounts[DRAW_GROUP_MAX]; // this frame so far
+static DrawCounts lastFrame[DRAW_GROUP_MAX];   // what the HUD shows
+static DrawCounts mark;                        // drawCounts at the last switch
+static int currentGroup = DRAW_OTHER;
+static int frameNumber = 0;
+
+// CSV export
+static FILE *csvFile = NULL;
+static char csvName[64];
+
+// Helper function to file the counts since the last switch under the current group
+static void fileCounts(void)
+{
+    DrawCounts *group = &groupCounts[currentGroup];
+    group->drawCalls += drawCounts.drawCalls - mark.drawCalls;
+    group->blocks += drawCounts.blocks - mark.blocks;
+    group->vertices += drawCounts.vertices - mark.vertices;
+    group->textureBinds += drawCounts.textureBinds - mark.textureBinds;
+    group->stateChanges += drawCounts.stateChanges - mark.stateChanges;
+    mark = drawCounts;
+}
+
+// Counts what follows under a part of the scene
+void draw_count_group(DrawGroup group)
+{
+    fileCounts();
+    currentGroup = group;
+}
+
+// Helper function to find (or add) the group of an object's type
+static int objectGroup(const SceneObject *object)
+{
+    for (int i = 0; i < drawFuncCount; i++)
+        if (groupDrawFuncs[i] == object->drawFunc)
+            return groupOfDrawFunc[i];
+
+    // Spawned furniture is named after its type with a number ("BarChair_3"), the fixed objects by name
+    int type = layout_type_from_name(object->name);
+    const char *name = type >= 0 ? scene_spawn_type_name((SceneSpawnType)type) : object->name;
+    int group = -1;
+    for (int i = DRAW_GROUP_FIXED; i < groupCount; i++)
+        if (strcmp(groupNames[i], name) == 0)
+            group = i;
+    if (group < 0)
+    {
+        if (groupCount == DRAW_GROUP_MAX)
+            return DRAW_OTHER;
+        group = groupCount++;
+        snprintf(typeNames[group], sizeof(typeNames[group]), "%s", name);
+        groupNames[group] = typeNames[group];
+    }
+
+    if (drawFuncCount < DRAW_FUNC_MAX)
+    {
+        groupDrawFuncs[drawFuncCount] = object->drawFunc;
+        groupOfDrawFunc[drawFuncCount] = group;
+        drawFuncCount++;
+    }
+    return group;
+}
+
+// Counts what follows under the type of an object
+void draw_count_object(const SceneObject *object)
+{
+    fileCounts();
+    currentGroup = object->drawFunc ? objectGroup(object) : DRAW_OTHER;
+}
+
+// Helper function to close the CSV export
+static void stopCsv(void)
+{
+    if (!csvFile)
+        return;
+    if (fclose(csvFile) != 0)
+        printf("Error: could not write %s\n", csvName);
+    else
+        printf("Draw counts written to %s\n", csvName);
+    csvFile = NULL;
+}
+
+// Starts or stops writing the counts of every frame to drawcounts-<date>-<time>.csv
+void draw_count_toggle_csv(void)
+{
+    if (csvFile)
+    {
+        stopCsv();
+        return;
+    }
+
+    time_t now = time(NULL);
+    strftime(csvName, sizeof(csvName), "drawcounts-%Y%m%d-%H%M%S.csv", localtime(&now));
+    csvFile = fopen(csvName, "w");
+    if (!csvFile)
+    {
+        printf("Error: could not create %s\n", csvName);
+        return;
+    }
+    fprintf(csvFile, "frame,group,draw_calls,blocks,vertices,texture_binds,state_changes\n");
+    printf("Writing draw counts to %s\n", csvName);
+
+    // An export still open at exit is closed then
+    static int exitHandlerAdded = 0;
+    if (!exitHandlerAdded)
+        atexit(stopCsv);
+    exitHandlerAdded = 1;
+}
+
+// Helper function to write one CSV row
+static void writeCsvRow(const char *name, const DrawCounts *counts)
+{
+    fprintf(csvFile, "%d,%s,%d,%d,%d,%d,%d\n", frameNumber, name, counts->drawCalls, counts->blocks,
+            counts->vertices, counts->textureBinds, counts->stateChanges);
+}
+
+// Totals of the last finished frame
+void draw_count_frame_total(DrawCounts *total)
+{
+    memset(total, 0, sizeof(*total));
+    for (int group = 0; group < groupCount; group++)
+    {
+        total->drawCalls += lastFrame[group].drawCalls;
+        total->blocks += lastFrame[group].blocks;
+        total->vertices += lastFrame[group].vertices;
+        total->textureBinds += lastFrame[group].textureBinds;
+        total->stateChanges += lastFrame[group].stateChanges;
+    }
+}
+
+// Files the counts of the frame that just ended and starts the next one
+void draw_count_end_frame(void)
+{
+    fileCounts();
+    memcpy(lastFrame, groupCounts, sizeof(lastFrame));
+    memset(groupCounts, 0, sizeof(groupCounts));
+    currentGroup = DRAW_OTHER;
+
+    if (csvFile)
+    {
+        for (int group = 0; group < groupCount; group++)
+            if (lastFrame[group].drawCalls > 0 || lastFrame[group].stateChanges > 0)
+                writeCsvRow(groupNames[group], &lastFrame[group]);
+        DrawCounts total;
+        draw_count_frame_total(&total);
+        writeCsvRow("Total", &total);
+    }
+    frameNumber++;
+}
+
+// Helper function to print one row of the table
+static void drawRow(int x, int y, const char *name, const DrawCounts *counts)
+{
+    glWindowPos2i(x, y);
+    Print("%s", name);
+    glWindowPos2i(x + 120, y);
+    Print("%d", counts->drawCalls);
+    glWindowPos2i(x + 180, y);
+    Print("%d", counts->blocks);
+    glWindowPos2i(x + 240, y);
+    Print("%d", counts->vertices);
+    glWindowPos2i(x + 310, y);
+    Print("%d", counts->textureBinds);
+    glWindowPos2i(x + 355, y);
+    Print("%d", counts->stateChanges);
+}
+
+// Draws the counts of the last frame per group in the top right corner
+// Call it with the HUD's projection set up
+void draw_count_draw(void)
+{
+    if (!drawCountsShown || frameNumber == 0)
+        return;
+
+    int x = screenWidth - 400;
+    int y = screenHeight - 25;
+    glWindowPos2i(x, y);
+    Print("Per frame");
+    glWindowPos2i(x + 120, y);
+    Print("draws");
+    glWindowPos2i(x + 180, y);
+    Print("begin");
+    glWindowPos2i(x + 240, y);
+    Print("verts");
+    glWindowPos2i(x + 310, y);
+    Print("bind");
+    glWindowPos2i(x + 355, y);
+    Print("state");
+
+    for (int group = 0; group < groupCount; group++)
+    {
+        if (lastFrame[group].drawCalls == 0 && lastFrame[group].stateChanges == 0)
+            continue;
+        y -= 20;
+        drawRow(x, y, groupNames[group], &lastFrame[group]);
+    }
+
+    DrawCounts total;
+    draw_count_frame_total(&total);
+    y -= 20;
+    drawRow(x, y, "Total", &total);
+
+    if (csvFile)
+    {
+        glWindowPos2i(x, y - 20);
+        Print("Writing %s", csvName);
+    }
+}
+#else
+// The counters are compiled out
+void draw_count_end_frame(void)
+{
+}
+
+void draw_count_frame_total(DrawCounts *total)
+{
+    memset(total, 0, sizeof(*total));
+}
+
+void draw_count_draw(void)
+{
+    if (!drawCountsShown)
+        return;
+    glWindowPos2i(screenWidth - 400, screenHeight - 25);
+    Print("Draw counters left out of this build (-DNO_PROFILER)");
+}
+
+void draw_count_toggle_csv(void)
+{
+    printf("Draw counters are left out of this build (-DNO_PROFILER)\n");
+}
+#endif
@@ -107,7 +107,7 @@ void drawDisk(float radius, float y, float thickness)
     if (glIsEnabled(GL_LIGHTING))
     {
         glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, cocktailTableTex);
+        texture_bind(cocktailTableTex);
         glColor3f(1, 1, 1);
     }
 
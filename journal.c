@@ -0,0 +1,253 @@
+#include "CSCIx229.h"
+
+// Edits since the last checkpoint, one line each
+#define JOURNAL_FILE "session.journal"
+// Full layout the journal starts from
+#define JOURNAL_CHECKPOINT "session_checkpoint.ehl"
+
+// Journal lines written before they get folded into a new checkpoint
+#define JOURNAL_COMPACT_EDITS 256
+
+// Journal records (every record holds absolute values, so replaying one twice is harmless):
+//   S,Name,X,Y,Z,Rotation,Scale   object spawned
+//   M,Name,X,Y,Z                  object moved
+//   R,Name,Rotation               object rotated
+//   D,Name                        object removed
+
+static FILE *journalFile = NULL;
+static int journalEdits = 0;
+static const char *journalName = JOURNAL_FILE;
+static const char *checkpointName = JOURNAL_CHECKPOINT;
+
+// Helper function to find a furniture object by its name
+static SceneObject *findObjectByName(const char *name)
+{
+    for (int i = 0; i < objectCount; i++)
+    {
+        if (objects[i].movable && strcmp(objects[i].name, name) == 0)
+            return &objects[i];
+    }
+    return NULL;
+}
+
+// Finishes a journal line; pushes it to the OS right away so a crash doesn't lose it
+static void endRecord(void)
+{
+    fflush(journalFile);
+    journalEdits++;
+
+    // Fold long journals into a checkpoint so replay stays short
+    if (journalEdits >= JOURNAL_COMPACT_EDITS)
+        journal_checkpoint();
+}
+
+// Writes the whole layout as the new checkpoint and starts an empty journal
+void journal_checkpoint(void)
+{
+    if (!journalFile)
+        return;
+
+    LayoutRecord *records = NULL;
+    int recordCount = scene_snapshot_layout(&records);
+    if (recordCount < 0)
+        return;
+
+    // The journal is only cleared once the checkpoint is safely in place
+    if (layout_write_atomic(checkpointName, records, recordCount) == 0)
+    {
+        FILE *emptied = freopen(journalName, "w", journalFile);
+        journalFile = emptied;
+        journalEdits = 0;
+        if (!journalFile)
+            printf("Error: Could not reopen %s, journal stopped.\n", journalName);
+    }
+    else
+    {
+        printf("Error: Could not write %s\n", checkpointName);
+    }
+
+    free(records);
+}
+
+// Applies the records of a journal file to the scene
+// Returns the number of records applied, or -1 if the file can't be opened
+int journal_replay(const char *filename)
+{
+    CsvReader reader;
+    if (csv_open(&reader, filename) != 0)
+        return -1;
+
+    int applied = 0;
+
+    while (csv_next_record(&reader) >= 0)
+    {
+        char kind = reader.fields[0][0];
+        if (reader.fieldCount < 2 || reader.fields[0][1] != '\0')
+            continue;
+
+        const char *name = reader.fields[1];
+        SceneObject *sceneObject = findObjectByName(name);
+
+        // Read the numbers that follow the name
+        float values[5] = {0};
+        int valueCount = reader.fieldCount - 2;
+        if (valueCount > 5)
+            valueCount = 5;
+        int valid = 1;
+        for (int i = 0; i < valueCount && valid; i++)
+            valid = csv_parse_float(reader.fields[i + 2], &values[i]);
+
+        if (!valid)
+        {
+            printf("%s:%d: bad journal record, skipped\n", filename, reader.line);
+            continue;
+        }
+
+        if (kind == 'S' && valueCount == 5)
+        {
+            // Spawn, or update an object that is already there
+            if (sceneObject)
+            {
+                sceneObject->x = values[0];
+                sceneObject->y = values[1];
+                sceneObject->z = values[2];
+                sceneObject->rotation = values[3];
+                sceneObject->scale = values[4];
+            }
+            else
+            {
+                int type = layout_type_from_name(name);
+                if (type < 0 || !scene_spawn_restore((SceneSpawnType)type, name, values[0], values[1],
+                                                     values[2], values[3], values[4]))
+                    continue;
+            }
+        }
+        else if (kind == 'M' && valueCount == 3 && sceneObject)
+        {
+            sceneObject->x = values[0];
+            sceneObject->y = values[1];
+            sceneObject->z = values[2];
+        }
+        else if (kind == 'R' && valueCount == 1 && sceneObject)
+        {
+            sceneObject->rotation = values[0];
+        }
+        else if (kind == 'D' && sceneObject)
+        {
+            scene_remove_object(sceneObject);
+        }
+        else
+        {
+            continue;
+        }
+
+        applied++;
+    }
+
+    csv_close(&reader);
+    return applied;
+}
+
+// Starts journaling; if the last session didn't shut down cleanly its edits are recovered first
+void journal_open(void)
+{
+    FILE *leftover = fopen(journalName, "rb");
+    if (leftover)
+    {
+        fclose(leftover);
+
+        // Rebuild the layout from the last checkpoint plus everything logged after it
+        double startTime = timer_now_ms();
+        FILE *checkpoint = fopen(checkpointName, "rb");
+        if (checkpoint)
+        {
+            fclose(checkpoint);
+            load_scene(checkpointName);
+        }
+
+        int applied = journal_replay(journalName);
+        selectedObject = NULL;
+        dragging = 0;
+        printf("Recovered last session: %d journal edits replayed in %.1f ms\n",
+               applied, timer_now_ms() - startTime);
+    }
+
+    journalFile = fopen(journalName, "a");
+    if (!journalFile)
+    {
+        printf("Error: Could not open %s, edits won't be journaled.\n", journalName);
+        return;
+    }
+
+    // Start from a checkpoint of the current layout
+    journal_checkpoint();
+
+    // Any normal exit (ESC, closing the window) clears the journal; only a crash leaves it behind
+    static int exitHandlerAdded = 0;
+    if (!exitHandlerAdded)
+        atexit(journal_close);
+    exitHandlerAdded = 1;
+}
+
+// Journals into other files (the self test uses this so it leaves a running session's journal alone)
+// Call it before journal_open
+void journal_use_files(const char *journalPath, const char *checkpointPath)
+{
+    journalName = journalPath;
+    checkpointName = checkpointPath;
+}
+
+// Stops journaling after a clean exit; nothing is left to recover
+void journal_close(void)
+{
+    if (!journalFile)
+        return;
+
+    fclose(journalFile);
+    journalFile = NULL;
+    remove(journalName);
+    remove(checkpointName);
+}
+
+// Logs a newly spawned object
+void journal_spawn(const SceneObject *sceneObject)
+{
+    if (!journalFile || !sceneObject)
+        return;
+
+    fprintf(journalFile, "S,%s,%.4f,%.4f,%.4f,%.4f,%.4f\n", sceneObject->name,
+            sceneObject->x, sceneObject->y, sceneObject->z, sceneObject->rotation, sceneObject->scale);
+    endRecord();
+}
+
+// Logs an object's new position
+void journal_move(const SceneObject *sceneObject)
+{
+    if (!journalFile || !sceneObject)
+        return;
+
+    fprintf(journalFile, "M,%s,%.4f,%.4f,%.4f\n", sceneObject->name,
+            sceneObject->x, sceneObject->y, sceneObject->z);
+    endRecord();
+}
+
+// Logs an object's new rotation
+void journal_rotate(const SceneObject *sceneObject)
+{
+    if (!journalFile || !sceneObject)
+        return;
+
+    fprintf(journalFile, "R,%s,%.4f\n", sceneObject->name, sceneObject->rotation);
+    endRecord();
+}
+
+// Logs an object that has been removed
+// Call it once the object is gone: this record may start a checkpoint, which must not include it
+void journal_remove(const char *name)
+{
+    if (!journalFile || !name)
+        return;
+
+    fprintf(journalFile, "D,%s\n", name);
+    endRecord();
+}
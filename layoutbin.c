@@ -0,0 +1,291 @@
+#include "CSCIx229.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Binary layout file:
+//   header | type table (typeCount names of 32 bytes) | recordCount packed LayoutRecords
+// All numbers are stored in the host's (little endian) byte order
+#define LAYOUT_BIN_VERSION 1
+#define LAYOUT_TYPE_NAME_SIZE 32
+static const char layoutBinMagic[4] = {'E', 'H', 'L', 'B'};
+
+typedef struct
+{
+    char magic[4];
+    unsigned int version;
+    unsigned int typeCount;
+    unsigned int recordCount;
+    unsigned int typeTableOffset;
+    unsigned int recordOffset;
+    unsigned int recordSize;
+    unsigned int reserved;
+} LayoutBinHeader;
+
+// Builds the bytes of a binary layout in memory (also used for layout library entries)
+// Returns a malloc'd buffer and its size, or NULL if out of memory
+unsigned char *layout_bin_encode(const LayoutRecord *records, int recordCount, size_t *sizeOut)
+{
+    // Work out where each section goes
+    LayoutBinHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, layoutBinMagic, sizeof(header.magic));
+    header.version = LAYOUT_BIN_VERSION;
+    header.typeCount = SPAWN_TYPE_COUNT;
+    header.recordCount = recordCount;
+    header.typeTableOffset = sizeof(LayoutBinHeader);
+    header.recordOffset = header.typeTableOffset + SPAWN_TYPE_COUNT * LAYOUT_TYPE_NAME_SIZE;
+    header.recordSize = sizeof(LayoutRecord);
+
+    size_t fileSize = header.recordOffset + (size_t)recordCount * sizeof(LayoutRecord);
+    unsigned char *buffer = (unsigned char *)calloc(1, fileSize);
+    if (!buffer)
+        return NULL;
+
+    // Header
+    memcpy(buffer, &header, sizeof(header));
+
+    // Type table, in the order of SceneSpawnType
+    for (int type = 0; type < SPAWN_TYPE_COUNT; type++)
+        strncpy((char *)buffer + header.typeTableOffset + type * LAYOUT_TYPE_NAME_SIZE,
+                scene_spawn_type_name((SceneSpawnType)type), LAYOUT_TYPE_NAME_SIZE - 1);
+
+    // Records are stored exactly as they are in memory
+    if (recordCount > 0)
+        memcpy(buffer + header.recordOffset, records, (size_t)recordCount * sizeof(LayoutRecord));
+
+    *sizeOut = fileSize;
+    return buffer;
+}
+
+// Writes records as a binary layout with a single write call
+// Returns 0 on success, -1 on failure
+int layout_write_bin(const char *filename, const LayoutRecord *records, int recordCount)
+{
+    size_t fileSize = 0;
+    unsigned char *buffer = layout_bin_encode(records, recordCount, &fileSize);
+    if (!buffer)
+        return -1;
+
+    FILE *layoutFile = fopen(filename, "wb");
+    int result = -1;
+    if (layoutFile)
+    {
+        if (fwrite(buffer, fileSize, 1, layoutFile) == 1)
+            result = 0;
+        if (fclose(layoutFile) != 0)
+            result = -1;
+    }
+
+    free(buffer);
+    return result;
+}
+
+// Maps a whole file into memory for reading (also used for the texture cache)
+// Returns NULL if it can't be opened; file_unmap releases it
+const unsigned char *file_map(const char *filename, size_t *sizeOut)
+{
+#ifdef _WIN32
+    // No mmap here, read the file into memory instead
+    FILE *layoutFile = fopen(filename, "rb");
+    if (!layoutFile)
+        return NULL;
+
+    fseek(layoutFile, 0, SEEK_END);
+    long fileSize = ftell(layoutFile);
+    rewind(layoutFile);
+
+    unsigned char *buffer = (unsigned char *)malloc(fileSize > 0 ? fileSize : 1);
+    if (!buffer || (fileSize > 0 && fread(buffer, fileSize, 1, layoutFile) != 1))
+    {
+        free(buffer);
+        fclose(layoutFile);
+        return NULL;
+    }
+
+    fclose(layoutFile);
+    *sizeOut = fileSize;
+    return buffer;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0 || fileInfo.st_size == 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void *mapped = mmap(NULL, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return NULL;
+
+    *sizeOut = fileInfo.st_size;
+    return (const unsigned char *)mapped;
+#endif
+}
+
+// Releases memory from file_map
+void file_unmap(const unsigned char *data, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    free((void *)data);
+#else
+    munmap((void *)data, size);
+#endif
+}
+
+// Helper function to read a binary layout's header and check it before trusting any offsets
+// Returns 0 if the layout is valid
+static int readHeader(const unsigned char *data, size_t fileSize, const char *sourceName, LayoutBinHeader *headerOut)
+{
+    LayoutBinHeader header;
+    if (fileSize < sizeof(header))
+    {
+        printf("Error: %s is not a valid layout file\n", sourceName);
+        return -1;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, layoutBinMagic, sizeof(header.magic)) != 0 ||
+        header.version != LAYOUT_BIN_VERSION ||
+        header.recordSize != sizeof(LayoutRecord) ||
+        header.typeCount > 256 ||
+        header.typeTableOffset + (size_t)header.typeCount * LAYOUT_TYPE_NAME_SIZE > fileSize ||
+        header.recordOffset + (size_t)header.recordCount * sizeof(LayoutRecord) > fileSize ||
+        header.recordOffset % sizeof(float) != 0)
+    {
+        printf("Error: %s is not a valid layout file\n", sourceName);
+        return -1;
+    }
+
+    *headerOut = header;
+    return 0;
+}
+
+// Checks a binary layout that is already in memory without reading its records
+// Every record of a layout that passes can be read, so a load can check first and clear the scene after
+// Returns the number of records, or -1 if it is not a valid layout (sourceName is used in the message)
+int layout_bin_validate(const unsigned char *data, size_t fileSize, const char *sourceName)
+{
+    LayoutBinHeader header;
+    if (readHeader(data, fileSize, sourceName, &header) != 0)
+        return -1;
+    return (int)header.recordCount;
+}
+
+// Reads a binary layout that is already in memory and hands every record to recordFunc
+// When the layout's type table matches ours, records are passed straight out of the buffer
+// Returns the number of records read, or -1 if it is not a valid layout (sourceName is used in the message)
+int layout_bin_decode(const unsigned char *data, size_t fileSize, const char *sourceName,
+                      LayoutRecordFunc recordFunc, void *userData)
+{
+    LayoutBinHeader header;
+    if (readHeader(data, fileSize, sourceName, &header) != 0)
+        return -1;
+
+    // Translate the file's type numbers into ours by name
+    int typeMap[256];
+    int sameTypes = (header.typeCount == SPAWN_TYPE_COUNT);
+    for (unsigned int i = 0; i < header.typeCount; i++)
+    {
+        char typeName[LAYOUT_TYPE_NAME_SIZE];
+        memcpy(typeName, data + header.typeTableOffset + i * LAYOUT_TYPE_NAME_SIZE, LAYOUT_TYPE_NAME_SIZE);
+        typeName[LAYOUT_TYPE_NAME_SIZE - 1] = '\0';
+
+        typeMap[i] = layout_type_from_name(typeName);
+        if (typeMap[i] != (int)i)
+            sameTypes = 0;
+    }
+
+    const LayoutRecord *records = (const LayoutRecord *)(data + header.recordOffset);
+    int recordCount = 0;
+
+    for (unsigned int i = 0; i < header.recordCount; i++)
+    {
+        recordCount++;
+
+        // Fast path: use the record where it sits in the file
+        if (sameTypes && records[i].name[sizeof(records[i].name) - 1] == '\0')
+        {
+            if (!recordFunc(&records[i], userData))
+                break;
+            continue;
+        }
+
+        // Otherwise fix up a copy
+        LayoutRecord record = records[i];
+        record.name[sizeof(record.name) - 1] = '\0';
+        record.type = (record.type >= 0 && (unsigned int)record.type < header.typeCount) ? typeMap[record.type] : -1;
+        if (!recordFunc(&record, userData))
+            break;
+    }
+
+    return recordCount;
+}
+
+// Reads a binary layout file through a memory mapping
+// Returns the number of records read, or -1 if the file is missing or not a valid layout
+int layout_read_bin(const char *filename, LayoutRecordFunc recordFunc, void *userData)
+{
+    size_t fileSize = 0;
+    const unsigned char *data = file_map(filename, &fileSize);
+    if (!data)
+        return -1;
+
+    int recordCount = layout_bin_decode(data, fileSize, filename, recordFunc, userData);
+    file_unmap(data, fileSize);
+    return recordCount;
+}
+
+// Appends a record to a LayoutRecordList (use as a LayoutRecordFunc)
+int layout_collect_record(const LayoutRecord *record, void *userData)
+{
+    LayoutRecordList *list = (LayoutRecordList *)userData;
+
+    if (list->count == list->capacity)
+    {
+        int newCapacity = list->capacity ? list->capacity * 2 : 256;
+        LayoutRecord *grown = (LayoutRecord *)realloc(list->records, newCapacity * sizeof(LayoutRecord));
+        if (!grown)
+            return 0;
+        list->records = grown;
+        list->capacity = newCapacity;
+    }
+
+    list->records[list->count++] = *record;
+    return 1;
+}
+
+// Converts a layout between CSV and binary (formats are picked from the file names)
+// Returns 0 on success
+int layout_convert(const char *inputFile, const char *outputFile)
+{
+    LayoutRecordList list = {NULL, 0, 0};
+
+    if (layout_read(inputFile, layout_collect_record, &list) < 0)
+    {
+        fprintf(stderr, "Cannot read layout %s\n", inputFile);
+        free(list.records);
+        return 1;
+    }
+
+    if (layout_write(outputFile, list.records, list.count) != 0)
+    {
+        fprintf(stderr, "Cannot write layout %s\n", outputFile);
+        free(list.records);
+        return 1;
+    }
+
+    printf("Converted %d objects: %s -> %s\n", list.count, inputFile, outputFile);
+    free(list.records);
+    return 0;
+}
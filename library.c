@@ -0,0 +1,632 @@
+#include "CSCIx229.h"
+#include <time.h>
+
+// Layout library archive:
+//   header | entries (binary layout + thumbnail) ... | index
+// New entries and a fresh index are appended at the end and the header is updated last,
+// so the old index stays valid until the new one is complete.
+// Entries are found through the index without reading the rest of the archive.
+#define LIBRARY_VERSION 1
+
+// Wasted space allowed before an archive gets compacted (bytes)
+#define LIBRARY_COMPACT_SLACK (1 << 20)
+static const char libraryMagic[4] = {'E', 'H', 'L', 'A'};
+
+typedef struct
+{
+    char magic[4];
+    unsigned int version;
+    unsigned int typeCount; // histograms are counted per SceneSpawnType
+    unsigned int entryCount;
+    unsigned int indexOffset;
+    unsigned int entrySize;
+    unsigned int thumbWidth;
+    unsigned int thumbHeight;
+    unsigned int reserved[4];
+} LibraryHeader;
+
+// Thumbnail colours for each spawn type (RGB)
+static const unsigned char typeColors[SPAWN_TYPE_COUNT][3] = {
+    [SPAWN_LAMP] = {250, 220, 90},
+    [SPAWN_EVENT_TABLE] = {170, 120, 70},
+    [SPAWN_MEETING_TABLE] = {130, 90, 60},
+    [SPAWN_BAR_CHAIR] = {90, 160, 230},
+    [SPAWN_BANQUET_CHAIR] = {220, 70, 70},
+    [SPAWN_COCKTAIL_1] = {120, 200, 120},
+    [SPAWN_COCKTAIL_2] = {90, 170, 90},
+    [SPAWN_COCKTAIL_3] = {60, 140, 60}};
+
+// Browser state
+int libraryBrowserOpen = 0;
+static LibraryEntry *browserEntries = NULL;
+static int browserEntryCount = 0;
+static int browserSelected = 0;
+static unsigned char **browserThumbs = NULL; // read the first time an entry is shown
+
+// Thumbnails shown per row in the browser, and how much they are enlarged
+#define BROWSER_COLUMNS 6
+#define BROWSER_ROWS 2
+#define BROWSER_ZOOM 2
+
+// Helper function to turn a room position into a thumbnail pixel (row 0 is the door end)
+static void roomToPixel(float x, float z, int *col, int *row)
+{
+    *col = (int)((x - ROOM_MIN_X) / (ROOM_MAX_X - ROOM_MIN_X) * LIBRARY_THUMB_WIDTH);
+    *row = (int)((ROOM_MAX_Z - z) / (ROOM_MAX_Z - ROOM_MIN_Z) * LIBRARY_THUMB_HEIGHT);
+}
+
+// Helper function to fill a rectangle of the room in a thumbnail
+static void fillRect(unsigned char *rgb, float minX, float maxX, float minZ, float maxZ, const unsigned char color[3])
+{
+    int col0, row0, col1, row1;
+    roomToPixel(minX, maxZ, &col0, &row0);
+    roomToPixel(maxX, minZ, &col1, &row1);
+
+    if (col0 < 0)
+        col0 = 0;
+    if (row0 < 0)
+        row0 = 0;
+    if (col1 >= LIBRARY_THUMB_WIDTH)
+        col1 = LIBRARY_THUMB_WIDTH - 1;
+    if (row1 >= LIBRARY_THUMB_HEIGHT)
+        row1 = LIBRARY_THUMB_HEIGHT - 1;
+
+    for (int row = row0; row <= row1; row++)
+        for (int col = col0; col <= col1; col++)
+            memcpy(rgb + (row * LIBRARY_THUMB_WIDTH + col) * 3, color, 3);
+}
+
+// Draws a top down picture of a layout on the CPU (stage at the top)
+void library_render_thumb(const LayoutRecord *records, int recordCount, unsigned char *rgb)
+{
+    static const unsigned char floorColor[3] = {60, 60, 66};
+    static const unsigned char stageColor[3] = {110, 80, 120};
+
+    fillRect(rgb, ROOM_MIN_X, ROOM_MAX_X, ROOM_MIN_Z, ROOM_MAX_Z, floorColor);
+    fillRect(rgb, STAGE_MIN_X, STAGE_MAX_X, STAGE_MIN_Z, STAGE_MAX_Z, stageColor);
+
+    for (int i = 0; i < recordCount; i++)
+    {
+        const LayoutRecord *record = &records[i];
+        SceneObject prototype;
+
+        if (record->type < 0 || record->type >= SPAWN_TYPE_COUNT ||
+            !scene_spawn_prototype((SceneSpawnType)record->type, &prototype))
+            continue;
+
+        prototype.rotation = record->rotation;
+        float minX, maxX, minZ, maxZ;
+        scene_object_footprint(&prototype, record->x, record->z, &minX, &maxX, &minZ, &maxZ);
+        fillRect(rgb, minX, maxX, minZ, maxZ, typeColors[record->type]);
+    }
+}
+
+// Reads the header of an archive, checking it is one of ours
+static int readHeader(FILE *archive, LibraryHeader *header)
+{
+    rewind(archive);
+    if (fread(header, sizeof(LibraryHeader), 1, archive) != 1)
+        return -1;
+
+    if (memcmp(header->magic, libraryMagic, sizeof(header->magic)) != 0 ||
+        header->version != LIBRARY_VERSION ||
+        header->entrySize != sizeof(LibraryEntry) ||
+        header->thumbWidth != LIBRARY_THUMB_WIDTH ||
+        header->thumbHeight != LIBRARY_THUMB_HEIGHT ||
+        header->typeCount > LIBRARY_MAX_TYPES ||
+        header->indexOffset < sizeof(LibraryHeader))
+        return -1;
+
+    return 0;
+}
+
+// Reads the index of an archive
+// Returns the number of entries (the list is malloc'd), or -1 if the archive can't be read
+int library_read_index(const char *archiveFile, LibraryEntry **entriesOut)
+{
+    *entriesOut = NULL;
+
+    FILE *archive = fopen(archiveFile, "rb");
+    if (!archive)
+        return -1;
+
+    LibraryHeader header;
+    if (readHeader(archive, &header) != 0)
+    {
+        printf("Error: %s is not a layout library\n", archiveFile);
+        fclose(archive);
+        return -1;
+    }
+
+    LibraryEntry *entries = (LibraryEntry *)malloc((header.entryCount > 0 ? header.entryCount : 1) * sizeof(LibraryEntry));
+    if (!entries || fseek(archive, header.indexOffset, SEEK_SET) != 0 ||
+        fread(entries, sizeof(LibraryEntry), header.entryCount, archive) != header.entryCount)
+    {
+        printf("Error: %s has a damaged index\n", archiveFile);
+        free(entries);
+        fclose(archive);
+        return -1;
+    }
+
+    fclose(archive);
+
+    for (unsigned int i = 0; i < header.entryCount; i++)
+    {
+        // Names are always terminated when they come back out
+        entries[i].name[sizeof(entries[i].name) - 1] = '\0';
+
+        // Histograms from a build with different furniture types can't be trusted
+        if (header.typeCount != SPAWN_TYPE_COUNT)
+            memset(entries[i].typeCounts, 0, sizeof(entries[i].typeCounts));
+    }
+
+    *entriesOut = entries;
+    return header.entryCount;
+}
+
+// Creates an empty archive
+static FILE *createArchive(const char *archiveFile)
+{
+    FILE *archive = fopen(archiveFile, "w+b");
+    if (!archive)
+        return NULL;
+
+    LibraryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, libraryMagic, sizeof(header.magic));
+    header.version = LIBRARY_VERSION;
+    header.typeCount = SPAWN_TYPE_COUNT;
+    header.entryCount = 0;
+    header.indexOffset = sizeof(LibraryHeader);
+    header.entrySize = sizeof(LibraryEntry);
+    header.thumbWidth = LIBRARY_THUMB_WIDTH;
+    header.thumbHeight = LIBRARY_THUMB_HEIGHT;
+
+    if (fwrite(&header, sizeof(header), 1, archive) != 1)
+    {
+        fclose(archive);
+        return NULL;
+    }
+
+    return archive;
+}
+
+// Adds a layout to an archive (creating it if needed); an entry with the same name is replaced
+// Returns 0 on success, -1 on failure
+int library_add(const char *archiveFile, const char *name, const LayoutRecord *records, int recordCount)
+{
+    FILE *archive = fopen(archiveFile, "r+b");
+    if (!archive)
+        archive = createArchive(archiveFile);
+    if (!archive)
+        return -1;
+
+    LibraryHeader header;
+    if (readHeader(archive, &header) != 0)
+    {
+        printf("Error: %s is not a layout library\n", archiveFile);
+        fclose(archive);
+        return -1;
+    }
+
+    // Old index plus room for the new entry
+    LibraryEntry *entries = (LibraryEntry *)malloc((header.entryCount + 1) * sizeof(LibraryEntry));
+    if (!entries || fseek(archive, header.indexOffset, SEEK_SET) != 0 ||
+        fread(entries, sizeof(LibraryEntry), header.entryCount, archive) != header.entryCount)
+    {
+        free(entries);
+        fclose(archive);
+        return -1;
+    }
+
+    // Describe the new entry
+    LibraryEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    strncpy(entry.name, name, sizeof(entry.name) - 1);
+    entry.savedTime = (long long)time(NULL);
+    entry.objectCount = recordCount;
+    for (int i = 0; i < recordCount; i++)
+        if (records[i].type >= 0 && records[i].type < LIBRARY_MAX_TYPES)
+            entry.typeCounts[records[i].type]++;
+
+    size_t layoutSize = 0;
+    unsigned char *layoutData = layout_bin_encode(records, recordCount, &layoutSize);
+    unsigned char thumb[LIBRARY_THUMB_WIDTH * LIBRARY_THUMB_HEIGHT * 3];
+    library_render_thumb(records, recordCount, thumb);
+
+    // Append the entry after everything else, then the new index
+    fseek(archive, 0, SEEK_END);
+    long end = ftell(archive);
+    entry.layoutOffset = (unsigned int)end;
+    entry.layoutSize = (unsigned int)layoutSize;
+    entry.thumbOffset = (unsigned int)(end + layoutSize);
+
+    int replaced = 0;
+    for (unsigned int i = 0; i < header.entryCount && !replaced; i++)
+    {
+        if (strncmp(entries[i].name, entry.name, sizeof(entry.name)) == 0)
+        {
+            entries[i] = entry;
+            replaced = 1;
+        }
+    }
+    if (!replaced)
+        entries[header.entryCount++] = entry;
+    header.indexOffset = entry.thumbOffset + sizeof(thumb);
+
+    int result = -1;
+    if (layoutData &&
+        fwrite(layoutData, layoutSize, 1, archive) == 1 &&
+        fwrite(thumb, sizeof(thumb), 1, archive) == 1 &&
+        fwrite(entries, sizeof(LibraryEntry), header.entryCount, archive) == header.entryCount &&
+        fflush(archive) == 0)
+    {
+        // Point the header at the new index only once it is fully written
+        rewind(archive);
+        if (fwrite(&header, sizeof(header), 1, archive) == 1)
+            result = 0;
+    }
+
+    if (fclose(archive) != 0)
+        result = -1;
+
+    // Old indexes and replaced entries pile up; rewrite the archive once they outweigh the live data
+    size_t liveBytes = sizeof(LibraryHeader) + (size_t)header.entryCount * sizeof(LibraryEntry);
+    for (unsigned int i = 0; i < header.entryCount; i++)
+        liveBytes += entries[i].layoutSize + sizeof(thumb);
+    if (result == 0 && (size_t)header.indexOffset > 2 * liveBytes + LIBRARY_COMPACT_SLACK)
+        result = library_compact(archiveFile);
+
+    free(layoutData);
+    free(entries);
+    return result;
+}
+
+// Rewrites an archive with only the entries its index still uses, then swaps it in
+// Returns 0 on success
+int library_compact(const char *archiveFile)
+{
+    LibraryEntry *entries = NULL;
+    int entryCount = library_read_index(archiveFile, &entries);
+    if (entryCount < 0)
+        return -1;
+
+    char tempFile[272];
+    snprintf(tempFile, sizeof(tempFile), "%s.tmp", archiveFile);
+
+    FILE *source = fopen(archiveFile, "rb");
+    FILE *compacted = createArchive(tempFile);
+    int result = (source && compacted) ? 0 : -1;
+
+    // Copy each entry's layout and thumbnail, which sit next to each other
+    size_t thumbSize = LIBRARY_THUMB_WIDTH * LIBRARY_THUMB_HEIGHT * 3;
+    unsigned int offset = sizeof(LibraryHeader);
+    for (int i = 0; i < entryCount && result == 0; i++)
+    {
+        size_t entrySize = entries[i].layoutSize + thumbSize;
+        unsigned char *data = (unsigned char *)malloc(entrySize);
+
+        if (!data ||
+            fseek(source, entries[i].layoutOffset, SEEK_SET) != 0 ||
+            fread(data, entries[i].layoutSize, 1, source) != 1 ||
+            fseek(source, entries[i].thumbOffset, SEEK_SET) != 0 ||
+            fread(data + entries[i].layoutSize, thumbSize, 1, source) != 1 ||
+            fwrite(data, entrySize, 1, compacted) != 1)
+            result = -1;
+
+        entries[i].layoutOffset = offset;
+        entries[i].thumbOffset = offset + entries[i].layoutSize;
+        offset += entrySize;
+        free(data);
+    }
+
+    // Index and header
+    if (result == 0)
+    {
+        LibraryHeader header;
+        if (readHeader(compacted, &header) != 0)
+            result = -1;
+        header.entryCount = entryCount;
+        header.indexOffset = offset;
+
+        if (result == 0 &&
+            (fseek(compacted, offset, SEEK_SET) != 0 ||
+             fwrite(entries, sizeof(LibraryEntry), entryCount, compacted) != (size_t)entryCount ||
+             fseek(compacted, 0, SEEK_SET) != 0 ||
+             fwrite(&header, sizeof(header), 1, compacted) != 1))
+            result = -1;
+    }
+
+    if (source)
+        fclose(source);
+    if (compacted && fclose(compacted) != 0)
+        result = -1;
+    free(entries);
+
+    if (result != 0)
+    {
+        remove(tempFile);
+        return -1;
+    }
+
+#ifdef _WIN32
+    // rename() won't replace an existing file on Windows
+    remove(archiveFile);
+#endif
+    return rename(tempFile, archiveFile) == 0 ? 0 : -1;
+}
+
+// Reads one entry's layout straight from its offset and hands the records to recordFunc
+// Returns the number of records read, or -1 on failure
+int library_load_entry(const char *archiveFile, const LibraryEntry *entry,
+                       LayoutRecordFunc recordFunc, void *userData)
+{
+    FILE *archive = fopen(archiveFile, "rb");
+    if (!archive)
+        return -1;
+
+    unsigned char *layoutData = (unsigned char *)malloc(entry->layoutSize > 0 ? entry->layoutSize : 1);
+    int recordCount = -1;
+    if (layoutData && fseek(archive, entry->layoutOffset, SEEK_SET) == 0 &&
+        fread(layoutData, entry->layoutSize, 1, archive) == 1)
+        recordCount = layout_bin_decode(layoutData, entry->layoutSize, entry->name, recordFunc, userData);
+
+    free(layoutData);
+    fclose(archive);
+    return recordCount;
+}
+
+// Reads one entry's thumbnail (LIBRARY_THUMB_WIDTH x LIBRARY_THUMB_HEIGHT RGB)
+// Returns 0 on success
+int library_read_thumb(const char *archiveFile, const LibraryEntry *entry, unsigned char *rgb)
+{
+    FILE *archive = fopen(archiveFile, "rb");
+    if (!archive)
+        return -1;
+
+    size_t thumbSize = LIBRARY_THUMB_WIDTH * LIBRARY_THUMB_HEIGHT * 3;
+    int result = (fseek(archive, entry->thumbOffset, SEEK_SET) == 0 &&
+                  fread(rgb, thumbSize, 1, archive) == 1)
+                     ? 0
+                     : -1;
+    fclose(archive);
+    return result;
+}
+
+// Saves the current furniture into the library under a name made from the date and time
+void library_save_current(void)
+{
+    LayoutRecord *records = NULL;
+    int recordCount = scene_snapshot_layout(&records);
+    if (recordCount < 0)
+        return;
+
+    char baseName[32];
+    time_t now = time(NULL);
+    strftime(baseName, sizeof(baseName), "Layout %Y-%m-%d %H:%M:%S", localtime(&now));
+
+    // library_add replaces an entry of the same name, so a second save within the same second
+    // becomes "... (2)" and so on
+    LibraryEntry *entries = NULL;
+    int entryCount = library_read_index(LIBRARY_FILE, &entries); // -1 before the first save
+    char name[32];
+    snprintf(name, sizeof(name), "%s", baseName);
+    for (int copy = 2, taken = 1; taken && copy < 100; copy++)
+    {
+        taken = 0;
+        for (int i = 0; i < entryCount && !taken; i++)
+            taken = strcmp(entries[i].name, name) == 0;
+        if (taken)
+            snprintf(name, sizeof(name), "%.26s (%d)", baseName, copy);
+    }
+    free(entries);
+
+    if (library_add(LIBRARY_FILE, name, records, recordCount) == 0)
+        printf("Saved \"%s\" to %s (%d objects)\n", name, LIBRARY_FILE, recordCount);
+    else
+        printf("Error: Could not save to %s\n", LIBRARY_FILE);
+
+    free(records);
+
+    // Reread the index next time the browser opens
+    if (libraryBrowserOpen)
+        library_browser_toggle();
+}
+
+// Frees everything the browser read
+static void closeBrowser(void)
+{
+    for (int i = 0; i < browserEntryCount; i++)
+        free(browserThumbs[i]);
+    free(browserThumbs);
+    free(browserEntries);
+    browserThumbs = NULL;
+    browserEntries = NULL;
+    browserEntryCount = 0;
+    libraryBrowserOpen = 0;
+}
+
+// Opens or closes the library browser
+void library_browser_toggle(void)
+{
+    if (libraryBrowserOpen)
+    {
+        closeBrowser();
+        return;
+    }
+
+    int entryCount = library_read_index(LIBRARY_FILE, &browserEntries);
+    if (entryCount <= 0)
+    {
+        printf("The layout library is empty, press k to add the current layout.\n");
+        free(browserEntries);
+        browserEntries = NULL;
+        return;
+    }
+
+    browserEntryCount = entryCount;
+    browserThumbs = (unsigned char **)calloc(entryCount, sizeof(unsigned char *));
+    if (browserSelected >= entryCount)
+        browserSelected = entryCount - 1;
+    libraryBrowserOpen = 1;
+}
+
+// Replaces the furniture with the selected library entry
+static void loadSelected(void)
+{
+    const LibraryEntry *entry = &browserEntries[browserSelected];
+
+    // Read the entry first, so a damaged archive leaves the current layout alone
+    double startTime = timer_now_ms();
+    LayoutRecordList list = {NULL, 0, 0};
+    if (library_load_entry(LIBRARY_FILE, entry, layout_collect_record, &list) != list.count)
+    {
+        printf("Error: Could not load \"%s\"\n", entry->name);
+        free(list.records);
+        return;
+    }
+
+    int firstLoaded = scene_begin_load();
+    for (int i = 0; i < list.count; i++)
+        if (!scene_restore_record(&list.records[i], (void *)entry->name))
+            break;
+    free(list.records);
+    scene_finish_load(entry->name, firstLoaded, startTime);
+}
+
+// Keyboard handling while the browser is open
+// Returns 1 if the key was used
+int library_browser_key(unsigned char key)
+{
+    if (!libraryBrowserOpen)
+        return 0;
+
+    switch (key)
+    {
+    // Load the selected layout and close
+    case 13:
+        loadSelected();
+        closeBrowser();
+        return 1;
+
+    // Close without loading
+    case 27:
+    case 'K':
+        closeBrowser();
+        return 1;
+    }
+
+    return 0;
+}
+
+// Arrow keys move the selection while the browser is open
+// Returns 1 if the key was used
+int library_browser_special(int key)
+{
+    if (!libraryBrowserOpen)
+        return 0;
+
+    int selected = browserSelected;
+    if (key == GLUT_KEY_LEFT)
+        selected--;
+    else if (key == GLUT_KEY_RIGHT)
+        selected++;
+    else if (key == GLUT_KEY_UP)
+        selected -= BROWSER_COLUMNS;
+    else if (key == GLUT_KEY_DOWN)
+        selected += BROWSER_COLUMNS;
+    else
+        return 0;
+
+    if (selected >= 0 && selected < browserEntryCount)
+        browserSelected = selected;
+    return 1;
+}
+
+// Helper function to fill a rectangle of the window with a colour
+static void fillWindowRect(int x, int y, int width, int height, float r, float g, float b)
+{
+    glScissor(x, y, width, height);
+    glClearColor(r, g, b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+// Draws the browser over the scene: a page of thumbnails with the selected entry's details
+void library_browser_draw(void)
+{
+    if (!libraryBrowserOpen)
+        return;
+
+    int cellWidth = LIBRARY_THUMB_WIDTH * BROWSER_ZOOM + 20;
+    int cellHeight = LIBRARY_THUMB_HEIGHT * BROWSER_ZOOM + 30;
+    int panelWidth = cellWidth * BROWSER_COLUMNS + 20;
+    int panelHeight = cellHeight * BROWSER_ROWS + 70;
+    int panelX = (screenWidth - panelWidth) / 2;
+    int panelY = (screenHeight - panelHeight) / 2;
+
+    // Only the page holding the selection is drawn
+    int perPage = BROWSER_COLUMNS * BROWSER_ROWS;
+    int firstShown = (browserSelected / perPage) * perPage;
+
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_SCISSOR_TEST);
+
+    fillWindowRect(panelX, panelY, panelWidth, panelHeight, 0.08f, 0.08f, 0.1f);
+
+    for (int i = firstShown; i < browserEntryCount && i < firstShown + perPage; i++)
+    {
+        int slot = i - firstShown;
+        int x = panelX + 10 + (slot % BROWSER_COLUMNS) * cellWidth + 10;
+        int y = panelY + panelHeight - 10 - (slot / BROWSER_COLUMNS + 1) * cellHeight + 25;
+
+        // Outline the selected entry
+        if (i == browserSelected)
+            fillWindowRect(x - 3, y - 3, LIBRARY_THUMB_WIDTH * BROWSER_ZOOM + 6,
+                           LIBRARY_THUMB_HEIGHT * BROWSER_ZOOM + 6, 1.0f, 0.85f, 0.2f);
+
+        // Read the thumbnail the first time it is needed, then keep it
+        if (!browserThumbs[i])
+        {
+            browserThumbs[i] = (unsigned char *)malloc(LIBRARY_THUMB_WIDTH * LIBRARY_THUMB_HEIGHT * 3);
+            if (browserThumbs[i] && library_read_thumb(LIBRARY_FILE, &browserEntries[i], browserThumbs[i]) != 0)
+                memset(browserThumbs[i], 0, LIBRARY_THUMB_WIDTH * LIBRARY_THUMB_HEIGHT * 3);
+        }
+
+        if (browserThumbs[i])
+        {
+            glWindowPos2i(x, y);
+            glPixelZoom(BROWSER_ZOOM, BROWSER_ZOOM);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glDrawPixels(LIBRARY_THUMB_WIDTH, LIBRARY_THUMB_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, browserThumbs[i]);
+            glPixelZoom(1, 1);
+        }
+
+        glColor3f(1, 1, 1);
+        glWindowPos2i(x, y - 16);
+        Print("%.14s", browserEntries[i].name + (strncmp(browserEntries[i].name, "Layout ", 7) == 0 ? 7 : 0));
+    }
+
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+
+    // Details of the selected entry
+    const LibraryEntry *entry = &browserEntries[browserSelected];
+    char savedText[32];
+    time_t savedTime = (time_t)entry->savedTime;
+    strftime(savedText, sizeof(savedText), "%Y-%m-%d %H:%M", localtime(&savedTime));
+
+    glColor3f(1, 1, 1);
+    glWindowPos2i(panelX + 10, panelY + 35);
+    Print("%d/%d  %s  saved %s  %u objects", browserSelected + 1, browserEntryCount,
+          entry->name, savedText, entry->objectCount);
+
+    glWindowPos2i(panelX + 10, panelY + 15);
+    for (int type = 0; type < SPAWN_TYPE_COUNT; type++)
+        if (entry->typeCounts[type] > 0)
+            Print("%s: %u  ", scene_spawn_type_name((SceneSpawnType)type), entry->typeCounts[type]);
+    Print("  (Enter: load, K: close)");
+
+    glEnable(GL_DEPTH_TEST);
+}
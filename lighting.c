@@ -26,6 +26,42 @@ float diffuse[] = {1.0f, 1.0f, 1.0f, 1.0f};
 float specular[] = {1.0f, 1.0f, 1.0f, 1.0f};
 float emission[] = {0.0f, 0.0f, 0.0f, 1.0f};
 
+// Lamp lights: every Lamp object is a point light in lamp mode. OpenGL only has 8 lights,
+// so the room floor is split into a grid of cells and each cell keeps the lamps nearest to it.
+// Floor tiles, walls and objects turn on the lamps of the cell they are in before drawing.
+#define LAMP_BULB_HEIGHT 5.45f // base + pole + bulb offset in drawLamp
+#define LAMP_RANGE 14.0f       // lamps farther away than this (across the floor) don't light a cell
+#define LAMP_CELL_SIZE 4.0f
+#define LAMP_GRID_MIN_X -20.0f
+#define LAMP_GRID_MIN_Z -30.0f
+#define LAMP_GRID_COLUMNS 10 // covers the room, 40 x 60
+#define LAMP_GRID_ROWS 15
+#define LAMP_CELL_LIGHTS 7 // GL_LIGHT1 - GL_LIGHT7 (GL_LIGHT0 is the moving light)
+
+typedef struct
+{
+    float x, y, z; // bulb position
+} LampLight;
+
+typedef struct
+{
+    int lampCount;
+    int lamps[LAMP_CELL_LIGHTS]; // nearest to the cell center first
+} LampCell;
+
+static LampLight lampLights[MAX_OBJECTS];
+static int lampLightCount = 0;
+static LampCell lampCells[LAMP_GRID_ROWS][LAMP_GRID_COLUMNS];
+static int lampCellsFull = 0;     // cells that had more lamps in range than lights to show them
+static const LampCell *activeCell = NULL; // cell whose lamps are switched on right now
+
+// Lamp light color; lamps add no ambient light of their own, the room gets it once instead
+static const float lampDiffuse[] = {0.80f, 0.90f, 1.00f, 1.0f};
+static const float lampSpecular[] = {1.0f, 1.0f, 0.95f, 1.0f};
+static const float lampAmbient[] = {0.0f, 0.0f, 0.0f, 1.0f};
+static const float lampRoomAmbient[] = {0.40f, 0.45f, 0.55f, 1.0f};
+static const float defaultRoomAmbient[] = {0.2f, 0.2f, 0.2f, 1.0f};
+
 // Initialize lighting
 void lighting_init(void)
 {
@@ -41,9 +77,152 @@ void lighting_init(void)
     // Smooth out the lighting
     glShadeModel(GL_SMOOTH);
 
-    // Enabling two lights
-    glEnable(GL_LIGHT0); // Moving light
-    glEnable(GL_LIGHT1); // Floor lamp
+    // Moving light; the lamp lights are switched on per cell in lamp mode
+    glEnable(GL_LIGHT0);
+
+    // Lamp lights fade with distance so far lamps can be left out
+    for (int i = 0; i < LAMP_CELL_LIGHTS; i++)
+    {
+        GLenum light = GL_LIGHT1 + i;
+        glLightfv(light, GL_AMBIENT, lampAmbient);
+        glLightfv(light, GL_DIFFUSE, lampDiffuse);
+        glLightfv(light, GL_SPECULAR, lampSpecular);
+        glLightf(light, GL_CONSTANT_ATTENUATION, 0.5f);
+        glLightf(light, GL_LINEAR_ATTENUATION, 0.0f);
+        glLightf(light, GL_QUADRATIC_ATTENUATION, 0.05f);
+    }
+}
+
+// Helper function to add a lamp to a cell, keeping the lamps nearest to the cell center
+static void addLampToCell(LampCell *cell, int lamp, float centerX, float centerZ)
+{
+    float dx = lampLights[lamp].x - centerX;
+    float dz = lampLights[lamp].z - centerZ;
+    float distance = dx * dx + dz * dz;
+
+    // Find where it goes in the sorted list
+    int position = cell->lampCount;
+    while (position > 0)
+    {
+        const LampLight *other = &lampLights[cell->lamps[position - 1]];
+        float ox = other->x - centerX;
+        float oz = other->z - centerZ;
+        if (ox * ox + oz * oz <= distance)
+            break;
+        position--;
+    }
+    if (position == LAMP_CELL_LIGHTS)
+        return;
+
+    int last = cell->lampCount < LAMP_CELL_LIGHTS ? cell->lampCount : LAMP_CELL_LIGHTS - 1;
+    for (int i = last; i > position; i--)
+        cell->lamps[i] = cell->lamps[i - 1];
+    cell->lamps[position] = lamp;
+    if (cell->lampCount < LAMP_CELL_LIGHTS)
+        cell->lampCount++;
+}
+
+// Finds the lamps and puts each one in every cell it reaches (done once per frame in lamp mode)
+void lighting_build_lamp_grid(void)
+{
+    lampLightCount = 0;
+    for (int i = 0; i < objectCount; i++)
+    {
+        const SceneObject *lamp = &objects[i];
+        if (lamp->drawFunc != drawLamp)
+            continue;
+        lampLights[lampLightCount].x = lamp->x;
+        lampLights[lampLightCount].y = lamp->y + LAMP_BULB_HEIGHT * lamp->scale;
+        lampLights[lampLightCount].z = lamp->z;
+        lampLightCount++;
+    }
+
+    memset(lampCells, 0, sizeof(lampCells));
+    int inRange[LAMP_GRID_ROWS][LAMP_GRID_COLUMNS] = {{0}};
+    for (int lamp = 0; lamp < lampLightCount; lamp++)
+    {
+        // Cells whose square comes within range of the lamp
+        float x = lampLights[lamp].x;
+        float z = lampLights[lamp].z;
+        int firstColumn = (int)floorf((x - LAMP_RANGE - LAMP_GRID_MIN_X) / LAMP_CELL_SIZE);
+        int lastColumn = (int)floorf((x + LAMP_RANGE - LAMP_GRID_MIN_X) / LAMP_CELL_SIZE);
+        int firstRow = (int)floorf((z - LAMP_RANGE - LAMP_GRID_MIN_Z) / LAMP_CELL_SIZE);
+        int lastRow = (int)floorf((z + LAMP_RANGE - LAMP_GRID_MIN_Z) / LAMP_CELL_SIZE);
+        if (firstColumn < 0)
+            firstColumn = 0;
+        if (lastColumn >= LAMP_GRID_COLUMNS)
+            lastColumn = LAMP_GRID_COLUMNS - 1;
+        if (firstRow < 0)
+            firstRow = 0;
+        if (lastRow >= LAMP_GRID_ROWS)
+            lastRow = LAMP_GRID_ROWS - 1;
+
+        for (int row = firstRow; row <= lastRow; row++)
+        {
+            for (int column = firstColumn; column <= lastColumn; column++)
+            {
+                float cellMinX = LAMP_GRID_MIN_X + column * LAMP_CELL_SIZE;
+                float cellMinZ = LAMP_GRID_MIN_Z + row * LAMP_CELL_SIZE;
+                float dx = fmaxf(fmaxf(cellMinX - x, 0.0f), x - (cellMinX + LAMP_CELL_SIZE));
+                float dz = fmaxf(fmaxf(cellMinZ - z, 0.0f), z - (cellMinZ + LAMP_CELL_SIZE));
+                if (dx * dx + dz * dz > LAMP_RANGE * LAMP_RANGE)
+                    continue;
+
+                inRange[row][column]++;
+                addLampToCell(&lampCells[row][column], lamp,
+                              cellMinX + 0.5f * LAMP_CELL_SIZE, cellMinZ + 0.5f * LAMP_CELL_SIZE);
+            }
+        }
+    }
+
+    lampCellsFull = 0;
+    for (int row = 0; row < LAMP_GRID_ROWS; row++)
+    {
+        for (int column = 0; column < LAMP_GRID_COLUMNS; column++)
+            lampCellsFull += inRange[row][column] > LAMP_CELL_LIGHTS;
+    }
+    activeCell = NULL;
+}
+
+// Switches on the lamps that light the cell holding (x, z), and switches off the others
+// Call it with only the camera on the modelview matrix, since that places the lights
+void lighting_select_lamps(float x, float z)
+{
+    if (lightState != 2)
+        return;
+
+    int column = (int)floorf((x - LAMP_GRID_MIN_X) / LAMP_CELL_SIZE);
+    int row = (int)floorf((z - LAMP_GRID_MIN_Z) / LAMP_CELL_SIZE);
+    column = column < 0 ? 0 : column >= LAMP_GRID_COLUMNS ? LAMP_GRID_COLUMNS - 1 : column;
+    row = row < 0 ? 0 : row >= LAMP_GRID_ROWS ? LAMP_GRID_ROWS - 1 : row;
+
+    const LampCell *cell = &lampCells[row][column];
+    if (cell == activeCell)
+        return;
+    activeCell = cell;
+
+    for (int i = 0; i < LAMP_CELL_LIGHTS; i++)
+    {
+        GLenum light = GL_LIGHT1 + i;
+        if (i >= cell->lampCount)
+        {
+            glDisable(light);
+            continue;
+        }
+
+        const LampLight *lamp = &lampLights[cell->lamps[i]];
+        float position[] = {lamp->x, lamp->y, lamp->z, 1.0f};
+        glLightfv(light, GL_POSITION, position);
+        glEnable(light);
+    }
+}
+
+// Number of lamps lighting the room; cellsFull gets how many cells had to leave lamps out
+int lighting_lamp_count(int *cellsFull)
+{
+    if (cellsFull)
+        *cellsFull = lampCellsFull;
+    return lightState == 2 ? lampLightCount : 0;
 }
 
 // Update lighting each frame
@@ -54,7 +233,9 @@ void lighting_update(void)
     {
         glDisable(GL_LIGHTING);
         glDisable(GL_LIGHT0);
-        glDisable(GL_LIGHT1);
+        for (int i = 0; i < LAMP_CELL_LIGHTS; i++)
+            glDisable(GL_LIGHT1 + i);
+        activeCell = NULL;
         return;
     }
 
@@ -88,24 +269,20 @@ void lighting_update(void)
         glDisable(GL_LIGHT0);
     }
 
-    // Mode 2: The Floor Lamp
+    // Mode 2: Every floor lamp is a light
     if (lightState == 2)
     {
-        glEnable(GL_LIGHT1);
         glDisable(GL_LIGHT0); // Turn off the moving light
-
-        float bulbAmb[] = {0.20f, 0.25f, 0.35f, 1.0f};
-        float bulbDif[] = {0.80f, 0.90f, 1.00f, 1.0f};
-        float bulbSpec[] = {1.0f, 1.0f, 0.95f, 1.0f};
-
-        glLightfv(GL_LIGHT1, GL_AMBIENT, bulbAmb);
-        glLightfv(GL_LIGHT1, GL_DIFFUSE, bulbDif);
-        glLightfv(GL_LIGHT1, GL_SPECULAR, bulbSpec);
+        glLightModelfv(GL_LIGHT_MODEL_AMBIENT, lampRoomAmbient);
+        lighting_build_lamp_grid();
     }
     else
     {
-        // If not in mode 2, disable light1
-        glDisable(GL_LIGHT1);
+        // If not in mode 2, the lamps are dark
+        glLightModelfv(GL_LIGHT_MODEL_AMBIENT, defaultRoomAmbient);
+        for (int i = 0; i < LAMP_CELL_LIGHTS; i++)
+            glDisable(GL_LIGHT1 + i);
+        activeCell = NULL;
     }
 
     // Apply the shininess settings to all objects
@@ -120,8 +297,8 @@ void lighting_update(void)
 // Draws a small white ball so we can see where the light is coming from
 void lighting_draw_debug_marker(void)
 {
-    // Only draw the ball for the moving light (Mode 1)
-    if (lightState != 1)
+    // Only draw the ball for the moving light (Mode 1), and never in offscreen images
+    if (lightState != 1 || offscreenRendering)
         return;
 
     // Turn off lighting temporarily so the ball is pure bright white
@@ -0,0 +1,561 @@
+#include "CSCIx229.h"
+#include <pthread.h>
+
+// Baked lightmaps for the room shell (floor, ceiling, walls, stage and screen)
+// The lights in the hall move (the orbiting light, the lamps), so what gets baked is how much of
+// the room's ambient light reaches each spot: rays are traced from every lightmap texel against
+// the shell and the fixed objects, and corners, the stage edge and the fireplace come out darker.
+// The shell is drawn with its lightmap multiplied in on texture unit 1. Furniture moves, so it
+// keeps plain real-time lighting and doesn't shadow the lightmaps.
+//
+// Lightmap file: header | every surface's texels (one byte each, rows packed, surfaces in order)
+// The key is a hash of every texel's position, the occluders and the bake settings, so a file
+// baked for a different room is ignored. Numbers are stored in the host's byte order.
+#define LIGHTMAP_VERSION 1
+#define LIGHTMAP_TEXELS_PER_METER 4.0f
+#define LIGHTMAP_RAYS_PER_SIDE 8        // rays per texel = 8 x 8
+#define LIGHTMAP_OCCLUSION_RANGE 4.0f   // geometry farther away than this doesn't darken a texel
+#define LIGHTMAP_STRENGTH 0.7f          // how dark a fully enclosed texel gets (0 = no effect)
+#define LIGHTMAP_RAY_OFFSET 0.02f       // start rays this far off the surface
+#define LIGHTMAP_BAKE_THREADS 4
+#define LIGHTMAP_MAX_SURFACES 16
+#define LIGHTMAP_MAX_OCCLUDERS 64
+static const char lightmapMagic[4] = {'E', 'H', 'L', 'M'};
+
+typedef struct
+{
+    char magic[4];
+    unsigned int version;
+    unsigned long long key;
+    unsigned int surfaceCount;
+    unsigned int texelCount;
+    unsigned int reserved[4];
+} LightmapHeader;
+
+typedef struct
+{
+    int width, height;
+    unsigned char *texels;
+    unsigned int texture;
+} Lightmap;
+
+int lightmapsEnabled = 1;
+
+// Surfaces and occluders of the bake (copied so the threads never look at the live scene)
+static const LightmapSurface *surfaces = NULL;
+static int surfaceCount = 0;
+static float occluders[LIGHTMAP_MAX_OCCLUDERS][6];
+static int occluderCount = 0;
+static Lightmap lightmaps[LIGHTMAP_MAX_SURFACES];
+static int lightmapsReady = 0; // uploaded and ready to draw with
+
+// Rows are handed out to the bake threads one at a time
+static pthread_mutex_t bakeMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bakeDoneCondition = PTHREAD_COND_INITIALIZER; // the last row is baked
+static int bakeRowCount = 0;
+static int nextBakeRow = 0;
+static int bakedRowCount = 0;
+static int backgroundBake = 0; // a bake is running behind the visualizer
+static double bakeStartTime = 0.0;
+static unsigned long long bakeKey = 0;
+
+// FNV-1a hash of a block of memory, continuing from hash
+static unsigned long long hashBytes(unsigned long long hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Helper function to find where a texel sits on its surface and which way the surface faces
+// Returns 0 when the texel is off a curved surface
+static int placeTexel(const LightmapSurface *surface, const Lightmap *lightmap, int column, int row,
+                      float position[3], float normal[3])
+{
+    // Texel centers, so linear filtering lands on the baked values
+    float u = (column + 0.5f) * surface->sizeU / lightmap->width;
+    float v = (row + 0.5f) * surface->sizeV / lightmap->height;
+    if (surface->place)
+        return surface->place(u, v, position, normal);
+
+    for (int i = 0; i < 3; i++)
+    {
+        position[i] = surface->origin[i] + u * surface->axisU[i] + v * surface->axisV[i];
+        normal[i] = surface->normal[i];
+    }
+    return 1;
+}
+
+// Helper function to find the nearest hit along a ray, up to maxDistance
+static float traceRay(const float origin[3], const float direction[3], float maxDistance)
+{
+    float nearest = maxDistance;
+
+    // Flat surfaces of the shell (curved ones are too thin and high up to matter)
+    for (int s = 0; s < surfaceCount; s++)
+    {
+        const LightmapSurface *surface = &surfaces[s];
+        if (surface->place)
+            continue;
+
+        const float *n = surface->normal;
+        float facing = n[0] * direction[0] + n[1] * direction[1] + n[2] * direction[2];
+        if (fabsf(facing) < 1e-6f)
+            continue;
+
+        float toPlane[3] = {surface->origin[0] - origin[0], surface->origin[1] - origin[1],
+                            surface->origin[2] - origin[2]};
+        float distance = (n[0] * toPlane[0] + n[1] * toPlane[1] + n[2] * toPlane[2]) / facing;
+        if (distance <= 1e-4f || distance >= nearest)
+            continue;
+
+        // Inside the rectangle?
+        float offset[3];
+        for (int i = 0; i < 3; i++)
+            offset[i] = origin[i] + distance * direction[i] - surface->origin[i];
+        const float *a = surface->axisU;
+        const float *b = surface->axisV;
+        float u = a[0] * offset[0] + a[1] * offset[1] + a[2] * offset[2];
+        float v = b[0] * offset[0] + b[1] * offset[1] + b[2] * offset[2];
+        if (u >= 0.0f && u <= surface->sizeU && v >= 0.0f && v <= surface->sizeV)
+            nearest = distance;
+    }
+
+    // Collision boxes of the fixed objects (a box the ray starts in is ignored)
+    for (int b = 0; b < occluderCount; b++)
+    {
+        const float *box = occluders[b];
+        float enter = 0.0f;
+        float leave = nearest;
+        int inside = 1;
+        for (int axis = 0; axis < 3 && enter <= leave; axis++)
+        {
+            float low = box[2 * axis];
+            float high = box[2 * axis + 1];
+            if (origin[axis] < low || origin[axis] > high)
+                inside = 0;
+            if (fabsf(direction[axis]) < 1e-8f)
+            {
+                if (origin[axis] < low || origin[axis] > high)
+                    enter = leave + 1.0f;
+                continue;
+            }
+            float t0 = (low - origin[axis]) / direction[axis];
+            float t1 = (high - origin[axis]) / direction[axis];
+            if (t0 > t1)
+            {
+                float swap = t0;
+                t0 = t1;
+                t1 = swap;
+            }
+            enter = fmaxf(enter, t0);
+            leave = fminf(leave, t1);
+        }
+        if (!inside && enter <= leave && enter > 1e-4f)
+            nearest = enter;
+    }
+
+    return nearest;
+}
+
+// Helper function to bake one row of a lightmap
+static void bakeRow(int surfaceIndex, int row)
+{
+    const LightmapSurface *surface = &surfaces[surfaceIndex];
+    Lightmap *lightmap = &lightmaps[surfaceIndex];
+    const int raysPerSide = LIGHTMAP_RAYS_PER_SIDE;
+    const float rayCount = (float)(raysPerSide * raysPerSide);
+
+    for (int column = 0; column < lightmap->width; column++)
+    {
+        float position[3], normal[3];
+        unsigned char *texel = &lightmap->texels[row * lightmap->width + column];
+        if (!placeTexel(surface, lightmap, column, row, position, normal))
+        {
+            *texel = 255;
+            continue;
+        }
+
+        // Two directions across the surface
+        float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        for (int i = 0; i < 3; i++)
+            normal[i] /= length;
+        float side[3] = {0.0f, 0.0f, 0.0f};
+        side[fabsf(normal[1]) < 0.9f ? 1 : 0] = 1.0f;
+        float tangent[3] = {side[1] * normal[2] - side[2] * normal[1],
+                            side[2] * normal[0] - side[0] * normal[2],
+                            side[0] * normal[1] - side[1] * normal[0]};
+        length = sqrtf(tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2]);
+        for (int i = 0; i < 3; i++)
+            tangent[i] /= length;
+        float bitangent[3] = {normal[1] * tangent[2] - normal[2] * tangent[1],
+                              normal[2] * tangent[0] - normal[0] * tangent[2],
+                              normal[0] * tangent[1] - normal[1] * tangent[0]};
+
+        float origin[3];
+        for (int i = 0; i < 3; i++)
+            origin[i] = position[i] + LIGHTMAP_RAY_OFFSET * normal[i];
+
+        // Rays spread over the half sphere the surface faces, more of them straight out
+        // (a jittered grid, seeded by the texel so a bake always gives the same result)
+        unsigned int seed = (unsigned int)(surfaceIndex * 7919 + row * 104729 + column * 1299709) | 1u;
+        float occlusion = 0.0f;
+        for (int ray = 0; ray < raysPerSide * raysPerSide; ray++)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            float jitterA = (seed & 0xffff) / 65536.0f;
+            float jitterB = (seed >> 16) / 65536.0f;
+            float a = (ray % raysPerSide + jitterA) / raysPerSide;
+            float b = (ray / raysPerSide + jitterB) / raysPerSide;
+
+            float radius = sqrtf(a);
+            float angle = 2.0f * (float)PI * b;
+            float across = radius * cosf(angle);
+            float along = radius * sinf(angle);
+            float out = sqrtf(fmaxf(0.0f, 1.0f - a));
+            float direction[3];
+            for (int i = 0; i < 3; i++)
+                direction[i] = across * tangent[i] + along * bitangent[i] + out * normal[i];
+
+            // Near hits block more of the light than far ones
+            float distance = traceRay(origin, direction, LIGHTMAP_OCCLUSION_RANGE);
+            if (distance < LIGHTMAP_OCCLUSION_RANGE)
+                occlusion += 1.0f - distance / LIGHTMAP_OCCLUSION_RANGE;
+        }
+
+        float light = 1.0f - LIGHTMAP_STRENGTH * occlusion / rayCount;
+        *texel = (unsigned char)(255.0f * light + 0.5f);
+    }
+}
+
+// Bake thread: takes rows until there are none left
+static void *bakeMain(void *unused)
+{
+    (void)unused;
+
+    pthread_mutex_lock(&bakeMutex);
+    while (nextBakeRow < bakeRowCount)
+    {
+        int row = nextBakeRow++;
+        pthread_mutex_unlock(&bakeMutex);
+
+        // Find the surface the row belongs to
+        int surfaceIndex = 0;
+        while (row >= lightmaps[surfaceIndex].height)
+            row -= lightmaps[surfaceIndex++].height;
+        bakeRow(surfaceIndex, row);
+
+        pthread_mutex_lock(&bakeMutex);
+        if (++bakedRowCount == bakeRowCount)
+            pthread_cond_broadcast(&bakeDoneCondition);
+    }
+    pthread_mutex_unlock(&bakeMutex);
+
+    return NULL;
+}
+
+// Helper function to size the lightmaps and collect what the rays can hit
+// Returns the key that identifies this bake
+static unsigned long long prepareBake(void)
+{
+    surfaces = scene_lightmap_surfaces(&surfaceCount);
+    if (surfaceCount > LIGHTMAP_MAX_SURFACES)
+        surfaceCount = LIGHTMAP_MAX_SURFACES;
+    occluderCount = scene_lightmap_occluders(occluders, LIGHTMAP_MAX_OCCLUDERS);
+
+    unsigned int settings[] = {LIGHTMAP_VERSION, LIGHTMAP_RAYS_PER_SIDE};
+    float tuning[] = {LIGHTMAP_TEXELS_PER_METER, LIGHTMAP_OCCLUSION_RANGE, LIGHTMAP_STRENGTH, LIGHTMAP_RAY_OFFSET};
+    unsigned long long key = hashBytes(14695981039346656037ull, settings, sizeof(settings));
+    key = hashBytes(key, tuning, sizeof(tuning));
+    key = hashBytes(key, occluders, occluderCount * sizeof(occluders[0]));
+
+    bakeRowCount = 0;
+    for (int s = 0; s < surfaceCount; s++)
+    {
+        Lightmap *lightmap = &lightmaps[s];
+        lightmap->width = (int)ceilf(surfaces[s].sizeU * LIGHTMAP_TEXELS_PER_METER);
+        lightmap->height = (int)ceilf(surfaces[s].sizeV * LIGHTMAP_TEXELS_PER_METER);
+        bakeRowCount += lightmap->height;
+
+        // Every texel's spot on the room, so moving a wall or bending the screen rebakes
+        for (int row = 0; row < lightmap->height; row++)
+        {
+            for (int column = 0; column < lightmap->width; column++)
+            {
+                float placed[7] = {0.0f};
+                placed[6] = (float)placeTexel(&surfaces[s], lightmap, column, row, placed, placed + 3);
+                key = hashBytes(key, placed, sizeof(placed));
+            }
+        }
+    }
+    return key;
+}
+
+// Helper function to allocate the texels of every lightmap
+static int allocateTexels(void)
+{
+    for (int s = 0; s < surfaceCount; s++)
+    {
+        free(lightmaps[s].texels);
+        lightmaps[s].texels = (unsigned char *)malloc((size_t)lightmaps[s].width * lightmaps[s].height);
+        if (!lightmaps[s].texels)
+            return 0;
+    }
+    return 1;
+}
+
+// Helper function to start the bake threads (the rows are baked here if none start)
+// Returns how many threads are running
+static int startBake(pthread_t *threads)
+{
+    bakeStartTime = timer_now_ms();
+    nextBakeRow = 0;
+    bakedRowCount = 0;
+
+    int threadCount = 0;
+    while (threadCount < LIGHTMAP_BAKE_THREADS && pthread_create(&threads[threadCount], NULL, bakeMain, NULL) == 0)
+        threadCount++;
+    if (threadCount == 0)
+        bakeMain(NULL);
+    return threadCount;
+}
+
+// Helper function to count the texels of every lightmap
+static size_t texelTotal(void)
+{
+    size_t total = 0;
+    for (int s = 0; s < surfaceCount; s++)
+        total += (size_t)lightmaps[s].width * lightmaps[s].height;
+    return total;
+}
+
+// Helper function to read the lightmaps from a file; returns 0 if the file doesn't match this room
+static int readLightmaps(const char *file, unsigned long long key)
+{
+    size_t fileSize = 0;
+    const unsigned char *data = file_map(file, &fileSize);
+    if (!data)
+        return 0;
+
+    LightmapHeader header;
+    int valid = fileSize >= sizeof(header);
+    if (valid)
+    {
+        memcpy(&header, data, sizeof(header));
+        valid = memcmp(header.magic, lightmapMagic, sizeof(header.magic)) == 0 &&
+                header.version == LIGHTMAP_VERSION && header.key == key &&
+                header.surfaceCount == (unsigned int)surfaceCount && header.texelCount == texelTotal() &&
+                fileSize == sizeof(header) + header.texelCount;
+    }
+
+    if (valid && allocateTexels())
+    {
+        const unsigned char *texels = data + sizeof(header);
+        for (int s = 0; s < surfaceCount; s++)
+        {
+            size_t size = (size_t)lightmaps[s].width * lightmaps[s].height;
+            memcpy(lightmaps[s].texels, texels, size);
+            texels += size;
+        }
+    }
+    else
+    {
+        valid = 0;
+    }
+
+    file_unmap(data, fileSize);
+    return valid;
+}
+
+// Helper function to write the lightmaps to a file (a temporary file is swapped in)
+// Returns 0 on success
+static int writeLightmaps(const char *file, unsigned long long key)
+{
+    LightmapHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, lightmapMagic, sizeof(header.magic));
+    header.version = LIGHTMAP_VERSION;
+    header.key = key;
+    header.surfaceCount = surfaceCount;
+    header.texelCount = texelTotal();
+
+    char tempFile[256];
+    snprintf(tempFile, sizeof(tempFile), "%s.tmp", file);
+    FILE *f = fopen(tempFile, "wb");
+    if (!f)
+        return -1;
+
+    int ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    for (int s = 0; ok && s < surfaceCount; s++)
+        ok = fwrite(lightmaps[s].texels, (size_t)lightmaps[s].width * lightmaps[s].height, 1, f) == 1;
+    if (fclose(f) != 0)
+        ok = 0;
+    if (ok)
+    {
+#ifdef _WIN32
+        // rename() won't replace an existing file on Windows
+        remove(file);
+#endif
+        ok = rename(tempFile, file) == 0;
+    }
+    if (!ok)
+        remove(tempFile);
+    return ok ? 0 : -1;
+}
+
+// Helper function to put the baked lightmaps on the graphics card
+static void uploadLightmaps(void)
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int s = 0; s < surfaceCount; s++)
+    {
+        Lightmap *lightmap = &lightmaps[s];
+        if (!lightmap->texture)
+            glGenTextures(1, &lightmap->texture);
+        glBindTexture(GL_TEXTURE_2D, lightmap->texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE8, lightmap->width, lightmap->height, 0,
+                     GL_LUMINANCE, GL_UNSIGNED_BYTE, lightmap->texels);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    ErrCheck("lightmap upload");
+    lightmapsReady = 1;
+}
+
+// Loads the lightmaps from LIGHTMAP_FILE, or bakes them behind the visualizer when the file is
+// missing or was baked for a different room (lightmap_update picks up the result)
+void lightmap_init(void)
+{
+    bakeKey = prepareBake();
+    if (readLightmaps(LIGHTMAP_FILE, bakeKey))
+    {
+        uploadLightmaps();
+        printf("Loaded lightmaps from %s (%d surfaces, %.1f KB)\n", LIGHTMAP_FILE, surfaceCount, texelTotal() / 1024.0);
+        return;
+    }
+
+    if (!allocateTexels())
+    {
+        printf("Cannot allocate lightmaps, the room is drawn without them\n");
+        return;
+    }
+
+    pthread_t threads[LIGHTMAP_BAKE_THREADS];
+    backgroundBake = 1;
+    int threadCount = startBake(threads);
+    for (int i = 0; i < threadCount; i++)
+        pthread_detach(threads[i]);
+    printf("Baking lightmaps in the background (run ./final --bake-lightmaps to bake them ahead)\n");
+}
+
+// Uploads and saves the lightmaps once a background bake finishes
+void lightmap_update(void)
+{
+    if (!backgroundBake)
+        return;
+
+    pthread_mutex_lock(&bakeMutex);
+    int finished = bakedRowCount == bakeRowCount;
+    pthread_mutex_unlock(&bakeMutex);
+    if (!finished)
+        return;
+
+    backgroundBake = 0;
+    uploadLightmaps();
+    printf("Baked lightmaps in %.0f ms\n", timer_now_ms() - bakeStartTime);
+
+    // Next time they load from the file
+    if (writeLightmaps(LIGHTMAP_FILE, bakeKey) != 0)
+        fprintf(stderr, "Cannot write %s\n", LIGHTMAP_FILE);
+}
+
+// Waits for a background bake to finish and uploads it, for renders that must not change midway
+void lightmap_wait(void)
+{
+    if (!backgroundBake)
+        return;
+
+    pthread_mutex_lock(&bakeMutex);
+    while (bakedRowCount < bakeRowCount)
+        pthread_cond_wait(&bakeDoneCondition, &bakeMutex);
+    pthread_mutex_unlock(&bakeMutex);
+    lightmap_update();
+}
+
+// Bakes the lightmaps on every bake thread and writes them to a file (no window needed)
+// Returns 0 on success
+int lightmap_bake_file(const char *file)
+{
+    unsigned long long key = prepareBake();
+    if (!allocateTexels())
+    {
+        fprintf(stderr, "Cannot allocate lightmaps\n");
+        return 1;
+    }
+
+    pthread_t threads[LIGHTMAP_BAKE_THREADS];
+    int threadCount = startBake(threads);
+    for (int i = 0; i < threadCount; i++)
+        pthread_join(threads[i], NULL);
+    double elapsed = timer_now_ms() - bakeStartTime;
+
+    if (writeLightmaps(file, key) != 0)
+    {
+        fprintf(stderr, "Cannot write %s\n", file);
+        return 1;
+    }
+    printf("Baked %d lightmaps (%.1f KB, %d rays per texel) into %s in %.0f ms on %d thread%s\n",
+           surfaceCount, texelTotal() / 1024.0, LIGHTMAP_RAYS_PER_SIDE * LIGHTMAP_RAYS_PER_SIDE, file, elapsed,
+           threadCount > 0 ? threadCount : 1, threadCount > 1 ? "s" : "");
+    return 0;
+}
+
+// Multiplies a surface's lightmap into what is drawn next, until lightmap_end
+// Call it with only the camera on the modelview matrix, since the lightmap is placed in world space
+void lightmap_begin(int surface)
+{
+    if (!lightmapsEnabled || !lightmapsReady || surface < 0 || surface >= surfaceCount)
+        return;
+
+    const LightmapSurface *s = &surfaces[surface];
+    float planeS[4] = {s->axisU[0] / s->sizeU, s->axisU[1] / s->sizeU, s->axisU[2] / s->sizeU, 0.0f};
+    float planeT[4] = {s->axisV[0] / s->sizeV, s->axisV[1] / s->sizeV, s->axisV[2] / s->sizeV, 0.0f};
+    planeS[3] = -(planeS[0] * s->origin[0] + planeS[1] * s->origin[1] + planeS[2] * s->origin[2]);
+    planeT[3] = -(planeT[0] * s->origin[0] + planeT[1] * s->origin[1] + planeT[2] * s->origin[2]);
+
+    // Texture unit 1 takes its coordinates from the world position
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, lightmaps[surface].texture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
+    glTexGeni(GL_T, GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
+    glTexGenfv(GL_S, GL_EYE_PLANE, planeS);
+    glTexGenfv(GL_T, GL_EYE_PLANE, planeT);
+    glEnable(GL_TEXTURE_GEN_S);
+    glEnable(GL_TEXTURE_GEN_T);
+    glEnable(GL_TEXTURE_2D);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+// Stops multiplying in the lightmap
+void lightmap_end(void)
+{
+    if (!lightmapsEnabled || !lightmapsReady)
+        return;
+
+    glActiveTexture(GL_TEXTURE1);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_TEXTURE_GEN_S);
+    glDisable(GL_TEXTURE_GEN_T);
+    glActiveTexture(GL_TEXTURE0);
+}
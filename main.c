@@ -19,6 +19,15 @@ double ph = 0;
 // camera mode
 int mode = 0;
 
+// time each frame may spend searching for spawn spots (ms)
+#define SPAWN_FRAME_BUDGET_MS 4.0
+// Time the layout optimizer may use per frame
+#define OPTIMIZE_FRAME_BUDGET_MS 12.0
+
+// smoothed time between frames (ms), shown with the texture stats
+static double frameMs = 0.0;
+static double lastFrameTime = 0.0;
+
 // set projection
 void Project(void)
 {
@@ -39,8 +48,8 @@ void Project(void)
     glMatrixMode(GL_MODELVIEW);
 }
 
-// display callback
-void display(void)
+// draws the scene from the current camera (mode, th, ph, fpv position...)
+void draw_view(void)
 {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glEnable(GL_DEPTH_TEST);
@@ -83,10 +92,44 @@ void display(void)
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    // draw scene
     scene_display();
+}
+
+// display callback
+void display(void)
+{
+    // time since the last frame, smoothed so the HUD number is readable
+    double now = timer_now_ms();
+    if (lastFrameTime > 0.0)
+        frameMs = frameMs > 0.0 ? 0.95 * frameMs + 0.05 * (now - lastFrameTime) : now - lastFrameTime;
+    lastFrameTime = now;
+    PROFILE_BEGIN(PROFILE_FRAME);
+
+    // continue any queued spawn searches
+    scene_spawn_update(SPAWN_FRAME_BUDGET_MS);
+
+    // continue the layout optimizer
+    layout_optimize_update(OPTIMIZE_FRAME_BUDGET_MS);
+
+    // pick up edited shader files
+    shader_poll_reload();
+
+    // upload the room lightmaps once a background bake is done
+    lightmap_update();
+
+    // start an autosave when one is due (written in the background), but not of a half built layout
+    if (!layout_optimize_running())
+        save_async_update();
+
+    // draw scene
+    draw_view();
+    int textureBinds = texture_take_bind_count();
+    texture_end_frame();
 
     // HUD overlay
+    PROFILE_BEGIN(PROFILE_HUD);
+    GPU_BEGIN(GPU_HUD);
+    DRAW_GROUP(DRAW_HUD);
     glMatrixMode(GL_PROJECTION);
     glPushMatrix();
     glLoadIdentity();
@@ -115,14 +158,29 @@ void display(void)
         break;
 
     case 2:
-        Print("Light Mode: Spotlight");
+    {
+        int cellsFull = 0;
+        int lampCount = lighting_lamp_count(&cellsFull);
+        Print("Light Mode: Lamps   %d lamp%s lit", lampCount, lampCount == 1 ? "" : "s");
+        if (cellsFull > 0)
+            Print(" (%d areas show only the nearest 7)", cellsFull);
         break;
+    }
 
     case 0:
         break;
     }
     glWindowPos2f(10, 60);
-    if (selectedObject)
+    char optimizeStatus[128];
+    if (layout_optimize_status(optimizeStatus, sizeof(optimizeStatus)))
+    {
+        Print("%s", optimizeStatus);
+    }
+    else if (scene_spawn_pending_count() > 0)
+    {
+        Print("Placing object... (%d queued)", scene_spawn_pending_count());
+    }
+    else if (selectedObject)
     {
         Print("Selected: %s", selectedObject->name);
         Print(" Angle: %.1f°", selectedObject->rotation);
@@ -132,12 +190,45 @@ void display(void)
         Print("Selected: None");
     }
 
+    // texture memory and filtering
+    if (textureStatsShown)
+    {
+        glWindowPos2f(10, 100);
+        int textureTotal = 0;
+        int texturesLoaded = texture_loaded_count(&textureTotal);
+        Print("Textures: %s, %d/%d loaded, %.1f MB, up to %d texel reads/pixel, %d binds   Frame: %.2f ms",
+              texture_filter_name(), texturesLoaded, textureTotal, texture_memory_bytes() / (1024.0 * 1024.0),
+              texture_samples_per_pixel(), textureBinds, frameMs);
+    }
+
+    // layout library browser
+    library_browser_draw();
+
+    // frame phase timings
+    profiler_draw();
+
+    // draw call counts of the last frame
+    draw_count_draw();
+
+    // result of the last save
+    char saveStatus[320];
+    if (save_async_status(saveStatus, sizeof(saveStatus)))
+    {
+        glWindowPos2f(10, 20);
+        Print("%s", saveStatus);
+    }
+
     glPopMatrix();
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
     glMatrixMode(GL_MODELVIEW);
+    GPU_END(GPU_HUD);
+    PROFILE_END(PROFILE_HUD);
 
     ErrCheck("display");
+    PROFILE_END(PROFILE_FRAME);
+    profiler_end_frame();
+    draw_count_end_frame();
     glutSwapBuffers();
 }
 
@@ -151,9 +242,41 @@ void reshape(int width, int height)
     Project();
 }
 
+// sets up the GL state, scene and lighting (the window or offscreen context must be current)
+void init_render(void)
+{
+    glEnable(GL_LIGHTING);
+    glEnable(GL_NORMALIZE);
+    glEnable(GL_COLOR_MATERIAL);
+    glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+    glLightModeli(GL_LIGHT_MODEL_LOCAL_VIEWER, GL_TRUE);
+    glDisable(GL_CULL_FACE);
+
+    scene_init();
+    initPlayerCollision();
+    lighting_init();
+}
+
 // main program
 int main(int argc, char *argv[])
 {
+    // command line tools run without opening a window
+    int toolResult = tools_main(argc, argv);
+    if (toolResult >= 0)
+        return toolResult;
+
+    // visualizer options
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--compress-textures") == 0)
+            textureCompression = 1;
+        else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc)
+            textureBudgetMB = atoi(argv[++i]);
+    }
+
+    // number the main thread for traces, and start one if EVENTHALL_TRACE is set
+    trace_init();
+
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_RGB | GLUT_DOUBLE | GLUT_DEPTH);
     glutInitWindowSize(screenWidth, screenHeight);
@@ -163,17 +286,11 @@ int main(int argc, char *argv[])
     glewInit();
 #endif
 
-    glEnable(GL_LIGHTING);
-    glEnable(GL_NORMALIZE);
-    glEnable(GL_COLOR_MATERIAL);
-    glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
-    glLightModeli(GL_LIGHT_MODEL_LOCAL_VIEWER, GL_TRUE);
-    glDisable(GL_CULL_FACE);
-
     // init scene and lighting
-    scene_init();
-    initPlayerCollision();
-    lighting_init();
+    init_render();
+
+    // journal edits (recovers the last session if it crashed)
+    journal_open();
 
     // callbacks
     glutDisplayFunc(display);
@@ -1,5 +1,8 @@
 #include "CSCIx229.h"
 
+// Where the dragged object was picked up, so only real moves get journaled
+static SceneTransform dragStart;
+
 // Check if the invisible line from the mouse hits a specific box part of an object
 static int rayIntersectsSubBoxWorld(
     float rayOriginX, float rayOriginY, float rayOriginZ,
@@ -150,6 +153,12 @@ SceneObject *pickObject3D(int mouseX, int mouseY)
 // Called by the system when the mouse button is clicked
 void mouse_button(int button, int state, int mouseX, int mouseY)
 {
+    double traceStart = TRACE_NOW();
+
+    // Nothing can be picked while the optimizer is filling the hall
+    if (layout_optimize_running())
+        return;
+
     // If left button is clicked
     if (button == GLUT_LEFT_BUTTON)
     {
@@ -173,6 +182,7 @@ void mouse_button(int button, int state, int mouseX, int mouseY)
                     dragging = 1;
                     printf("Selected object: %s\n", selectedObject->name);
                 }
+                scene_get_transform(selectedObject, &dragStart);
             }
             else
             {
@@ -185,11 +195,19 @@ void mouse_button(int button, int state, int mouseX, int mouseY)
         else if (state == GLUT_UP)
         {
             // When button is released, stop dragging
+            if (dragging && selectedObject &&
+                (selectedObject->x != dragStart.x || selectedObject->z != dragStart.z))
+            {
+                journal_move(selectedObject);
+                undo_record_transform(selectedObject, &dragStart);
+            }
             dragging = 0;
             printf("Object placed.\n");
         }
     }
 
+    TRACE_RECORD("mouse_button", "input", traceStart);
+
     // Redraw the screen
     glutPostRedisplay();
 }
@@ -218,6 +236,8 @@ static int rayPlaneIntersection(float rayOriginX, float rayOriginY, float rayOri
 // Called by system when the mouse moves
 void mouse_motion(int mouseX, int mouseY)
 {
+    double traceStart = TRACE_NOW();
+
     // Only move things if we are currently dragging a valid object
     if (dragging && selectedObject)
     {
@@ -263,6 +283,8 @@ void mouse_motion(int mouseX, int mouseY)
         }
     }
 
+    TRACE_RECORD("mouse_motion", "input", traceStart);
+
     // Redraw screen
     glutPostRedisplay();
 }
@@ -6,7 +6,7 @@ static void drawLeg(float legPosX, float legPosZ, float legHeight, float legRadi
     if (glIsEnabled(GL_LIGHTING))
     {
         glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, cocktailTableTex);
+        texture_bind(cocktailTableTex);
         glColor3f(1.0f, 1.0f, 1.0f);
     }
 
@@ -54,7 +54,7 @@ void drawTable(float posX, float posZ)
     if (glIsEnabled(GL_LIGHTING))
     {
         glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, tableTex);
+        texture_bind(tableTex);
         glColor3f(1, 1, 1);
     }
 
@@ -271,7 +271,7 @@ void drawCocktailTable(float x, float z)
     if (glIsEnabled(GL_LIGHTING))
     {
         glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, cocktailTableTex);
+        texture_bind(cocktailTableTex);
     }
 
     drawLeg(0.0f, 0.0f, height, legRadius);    // Center pole
@@ -295,7 +295,7 @@ void drawDoor(float x, float z, float width, float height)
     float nx = 0.0f, ny = 0.0f, nz = -1.0f;
 
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, doorFrameTex);
+    texture_bind(doorFrameTex);
 
     glBegin(GL_QUADS);
 
@@ -335,7 +335,7 @@ void drawDoor(float x, float z, float width, float height)
     glEnd();
 
     // Door panel
-    glBindTexture(GL_TEXTURE_2D, doorFrameTex);
+    texture_bind(doorFrameTex);
     glBegin(GL_QUADS);
 
     glNormal3f(nx, ny, nz);
@@ -356,7 +356,7 @@ void drawDoor(float x, float z, float width, float height)
     glTranslatef(x + halfW - 0.3f, yBottom + height * 0.5f, z + 0.05f);
 
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, doorKnobTex);
+    texture_bind(doorKnobTex);
 
     // Make knob look shiny/reflective
     glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_SPHERE_MAP);
@@ -391,7 +391,7 @@ void drawCurvedScreen(float wallX, float wallZ, float width, float height,
     glColor3f(1.0f, 1.0f, 1.0f);
 
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, screenTex);
+    texture_bind(screenTex);
 
     glBegin(GL_QUADS);
 
@@ -483,7 +483,7 @@ void drawLamp(float xPos, float zPos)
     if (glIsEnabled(GL_LIGHTING))
     {
         glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, lampRodTex);
+        texture_bind(lampRodTex);
         glColor3f(1, 1, 1);
     }
 
@@ -551,7 +551,7 @@ void drawLamp(float xPos, float zPos)
             glDisable(GL_BLEND);
             glColor4f(1, 1, 1, 1); // Opaque
         }
-        glBindTexture(GL_TEXTURE_2D, lampShadeTex);
+        texture_bind(lampShadeTex);
     }
 
     float shadeBottomY = poleHeight;
@@ -639,17 +639,7 @@ void drawLamp(float xPos, float zPos)
 
     glPopMatrix();
 
-    // If the lamp is ON, tell OpenGL to calculate light rays originating here
-    if (lightState == 2)
-    {
-        float bulbWorldX = xPos;
-        float bulbWorldY = baseHeight + bulbLocalY;
-        float bulbWorldZ = zPos;
-
-        float pos1[] = {bulbWorldX, bulbWorldY, bulbWorldZ, 1.0f};
-        glLightfv(GL_LIGHT1, GL_POSITION, pos1);
-    }
-
+    // The light itself comes from lighting_select_lamps (bulb at LAMP_BULB_HEIGHT in lighting.c)
     glPopMatrix();
 }
 
@@ -681,7 +671,7 @@ void drawBanquetChair(float x, float z)
     // Seat Cushion
     if (glIsEnabled(GL_LIGHTING))
     {
-        glBindTexture(GL_TEXTURE_2D, chairCushionTex);
+        texture_bind(chairCushionTex);
         glColor3f(1, 1, 1);
     }
 
@@ -761,7 +751,7 @@ void drawBanquetChair(float x, float z)
     // Legs
     if (glIsEnabled(GL_LIGHTING))
     {
-        glBindTexture(GL_TEXTURE_2D, chairLegTex);
+        texture_bind(chairLegTex);
     }
 
     float legOffsetX = seatW / 2 - 0.1f;
@@ -822,7 +812,7 @@ void drawBanquetChair(float x, float z)
     // Curved Backrest
     if (glIsEnabled(GL_LIGHTING))
     {
-        glBindTexture(GL_TEXTURE_2D, chairCushionTex);
+        texture_bind(chairCushionTex);
     }
 
     int backrestSegments = 20;
@@ -930,7 +920,7 @@ void drawCocktailTable2(float x, float z)
     glTranslatef(x, 0, z);
 
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, cocktail2Tex);
+    texture_bind(cocktail2Tex);
 
     // Draw table top surface
     glBegin(GL_TRIANGLES);
@@ -1039,7 +1029,7 @@ void drawCocktailTable2(float x, float z)
     glDisable(GL_TEXTURE_2D);
 
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, cocktail2LegTex);
+    texture_bind(cocktail2LegTex);
 
     // 3 Angled Legs
     for (int i = 0; i < 3; i++)
@@ -1095,7 +1085,7 @@ void drawCocktailTable3(float x, float z)
     glTranslatef(x, 0, z);
 
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, cocktail3LegTex);
+    texture_bind(cocktail3LegTex);
 
     // Bottom frustum
     drawFrustum(0.85f, 0.45f, bottomHeight, slices);
@@ -1104,13 +1094,13 @@ void drawCocktailTable3(float x, float z)
 
     // Top frustum
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, cocktail3Tex);
+    texture_bind(cocktail3Tex);
     drawFrustum(0.45f, 1.35f, topHeight, slices);
     glDisable(GL_TEXTURE_2D);
 
     // Top disk
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, cocktail3Tex);
+    texture_bind(cocktail3Tex);
 
     glBegin(GL_TRIANGLE_FAN);
     glNormal3f(0, 1, 0);
@@ -1149,7 +1139,7 @@ void drawMeetingTable(float x, float z)
     if (glIsEnabled(GL_LIGHTING))
     {
         glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, meetingTableLegTex);
+        texture_bind(meetingTableLegTex);
         glColor3f(1, 1, 1);
     }
 
@@ -1186,7 +1176,7 @@ void drawMeetingTable(float x, float z)
     if (glIsEnabled(GL_LIGHTING))
     {
         glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, meetingTableTex);
+        texture_bind(meetingTableTex);
         glColor3f(1, 1, 1);
     }
 
@@ -1279,7 +1269,7 @@ static void drawRope(float length)
     glColor3f(1, 1, 1);
     glPushMatrix();
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, threadTex);
+    texture_bind(threadTex);
 
     glTranslatef(0, -length / 2.0f, 0);
     glScalef(0.05f, length, 0.05f);
@@ -1299,7 +1289,7 @@ void drawStarShape(void)
     const int numPoints = 5;
 
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, starTex);
+    texture_bind(starTex);
     glColor3f(1, 1, 1);
 
     // Front Face
@@ -1371,7 +1361,7 @@ void drawStarShape(void)
 void drawCloudShape(void)
 {
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, cloudTex);
+    texture_bind(cloudTex);
     glColor3f(1, 1, 1);
 
     // Center puff
@@ -1438,7 +1428,7 @@ static void drawMoonShape(void)
     int steps = 300;
 
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, moonTex);
+    texture_bind(moonTex);
     glColor3f(1.0f, 1.0f, 1.0f);
 
     glPushMatrix();
@@ -1624,7 +1614,7 @@ void drawSeat(void)
     if (glIsEnabled(GL_LIGHTING))
     {
         glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, barChairCushionTex);
+        texture_bind(barChairCushionTex);
         glColor3f(1.0f, 1.0f, 1.0f);
     }
 
@@ -1824,7 +1814,7 @@ void drawCurvedBackrest(void)
     if (glIsEnabled(GL_LIGHTING))
     {
         glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, barChairBackTex);
+        texture_bind(barChairBackTex);
         glColor3f(1, 1, 1);
     }
 
@@ -1954,7 +1944,7 @@ void drawBarChair(void)
     if (glIsEnabled(GL_LIGHTING))
     {
         glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, barChairWoodTex);
+        texture_bind(barChairWoodTex);
     }
     drawSeatBase();
     if (glIsEnabled(GL_LIGHTING))
@@ -1967,7 +1957,7 @@ void drawBarChair(void)
     if (glIsEnabled(GL_LIGHTING))
     {
         glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, barChairWoodTex);
+        texture_bind(barChairWoodTex);
     }
     drawLegN(+LEG_OFFSET_X, +LEG_OFFSET_Z);
     drawLegN(-LEG_OFFSET_X, +LEG_OFFSET_Z);
@@ -1980,7 +1970,7 @@ void drawBarChair(void)
     if (glIsEnabled(GL_LIGHTING))
     {
         glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, barChairWoodTex);
+        texture_bind(barChairWoodTex);
     }
     drawBackrestRod(0.0f, -0.50f);
     drawBackrestRod(0.20f, -0.50f);
@@ -2018,7 +2008,7 @@ static void drawLog(float x, float y, float z, float rotY)
     if (glIsEnabled(GL_LIGHTING))
     {
         glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, barChairWoodTex);
+        texture_bind(barChairWoodTex);
         glColor3f(0.7f, 0.5f, 0.4f);
     }
 
@@ -2045,7 +2035,7 @@ void drawFireplace(float x, float z)
     if (glIsEnabled(GL_LIGHTING))
     {
         glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, fireplaceTex);
+        texture_bind(fireplaceTex);
         glColor3f(1.0f, 1.0f, 1.0f);
     }
 
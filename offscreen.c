@@ -0,0 +1,229 @@
+#include "CSCIx229.h"
+
+// Offscreen rendering: draws the hall into a framebuffer object and writes it out as a BMP file.
+// On Linux the GL context comes from EGL, so no display server is needed: the default display is
+// tried first (X11 or Wayland when there is one), then Mesa's surfaceless platform. Elsewhere the
+// context belongs to a hidden GLUT window. The scene and its textures are loaded once and reused
+// for every layout and view drawn in the process.
+#ifdef __linux__
+#define OFFSCREEN_EGL
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+// Window size GLUT is given when it only provides the context
+#define HIDDEN_WINDOW_SIZE 16
+
+int offscreenRendering = 0;
+
+static unsigned int framebuffer = 0;
+static unsigned int colorBuffer = 0;
+static unsigned int depthBuffer = 0;
+
+#ifdef OFFSCREEN_EGL
+static EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+static EGLContext eglContext = EGL_NO_CONTEXT;
+static EGLSurface eglSurface = EGL_NO_SURFACE;
+
+// Helper function to open an EGL display: the default one, or Mesa's surfaceless one without it
+static EGLDisplay openDisplay(void)
+{
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL))
+        return display;
+
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (!getPlatformDisplay)
+        return EGL_NO_DISPLAY;
+    display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL))
+        return display;
+    return EGL_NO_DISPLAY;
+}
+
+// Helper function to make a desktop GL context current with EGL
+// Returns 0 on success
+static int createContext(void)
+{
+    eglDisplay = openDisplay();
+    if (eglDisplay == EGL_NO_DISPLAY)
+    {
+        fprintf(stderr, "Cannot open an EGL display\n");
+        return 1;
+    }
+
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE};
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) || configCount == 0)
+    {
+        fprintf(stderr, "No EGL configuration can draw with OpenGL\n");
+        return 1;
+    }
+
+    // Drawing goes to the framebuffer object, the pbuffer only makes the context current
+    const EGLint surfaceAttributes[] = {EGL_WIDTH, HIDDEN_WINDOW_SIZE, EGL_HEIGHT, HIDDEN_WINDOW_SIZE, EGL_NONE};
+    eglSurface = eglCreatePbufferSurface(eglDisplay, config, surfaceAttributes);
+    eglBindAPI(EGL_OPENGL_API);
+    eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, NULL);
+    if (eglSurface == EGL_NO_SURFACE || eglContext == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext))
+    {
+        fprintf(stderr, "Cannot create an EGL context (error 0x%x)\n", eglGetError());
+        return 1;
+    }
+    return 0;
+}
+#else
+// Helper function to get a GL context from a GLUT window that is never shown
+// Returns 0 on success
+static int createContext(void)
+{
+    int argc = 1;
+    char program[] = "final";
+    char *argv[] = {program, NULL};
+    glutInit(&argc, argv);
+    glutInitDisplayMode(GLUT_RGB | GLUT_DEPTH);
+    glutInitWindowSize(HIDDEN_WINDOW_SIZE, HIDDEN_WINDOW_SIZE);
+    glutCreateWindow("offscreen");
+    glutHideWindow();
+#ifdef USEGLEW
+    glewInit();
+#endif
+    return 0;
+}
+#endif
+
+// Creates the GL context and a width x height framebuffer, then loads the scene
+// Returns 0 on success
+int offscreen_open(int width, int height)
+{
+    offscreenRendering = 1;
+    if (createContext() != 0)
+        return 1;
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        fprintf(stderr, "Cannot create a %dx%d framebuffer\n", width, height);
+        return 1;
+    }
+
+    reshape(width, height);
+    init_render();
+
+    // Every image should show the same lighting
+    lightmap_wait();
+    movingLightEnabled = 0;
+    return 0;
+}
+
+// Frees the framebuffer and the context
+void offscreen_close(void)
+{
+    glDeleteRenderbuffers(1, &depthBuffer);
+    glDeleteRenderbuffers(1, &colorBuffer);
+    glDeleteFramebuffers(1, &framebuffer);
+#ifdef OFFSCREEN_EGL
+    eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(eglDisplay, eglContext);
+    eglDestroySurface(eglDisplay, eglSurface);
+    eglTerminate(eglDisplay);
+#endif
+}
+
+// Short name of a view, used in image file names
+const char *view_preset_name(ViewPreset view)
+{
+    static const char *names[VIEW_COUNT] = {"perspective", "fpv", "orthogonal"};
+    return (view >= 0 && view < VIEW_COUNT) ? names[view] : "";
+}
+
+// Points the camera the way a view preset looks at the hall
+void view_preset_apply(ViewPreset view)
+{
+    th = ph = yaw = pitch = 0;
+    fpvX = 0;
+    fpvY = 3;
+    fpvZ = 24;
+    fov = 55;
+    dim = 20;
+
+    if (view == VIEW_FPV)
+        mode = 1;
+    else if (view == VIEW_ORTHOGONAL)
+    {
+        // Looking straight down, zoomed out to fit the 60 m long room
+        mode = 2;
+        ph = 90;
+        dim = 32;
+    }
+    else
+        mode = 0;
+}
+
+// Helper function to write a little endian number into a header
+static void putNumber(unsigned char *bytes, unsigned int value, int size)
+{
+    for (int i = 0; i < size; i++)
+        bytes[i] = (unsigned char)(value >> (8 * i));
+}
+
+// Draws the current view and writes it to a 24 bit BMP file
+// Returns 0 on success
+int offscreen_write_bmp(const char *file)
+{
+    draw_view();
+    texture_end_frame();
+
+    // BMP rows are bottom up and padded to 4 bytes, just like glReadPixels gives them
+    int rowBytes = (screenWidth * 3 + 3) & ~3;
+    unsigned int pixelBytes = (unsigned int)rowBytes * screenHeight;
+    unsigned char *pixels = (unsigned char *)malloc(pixelBytes);
+    if (!pixels)
+        return 1;
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, screenWidth, screenHeight, GL_BGR, GL_UNSIGNED_BYTE, pixels);
+    ErrCheck("offscreen_write_bmp");
+
+    unsigned char header[54] = {'B', 'M'};
+    putNumber(header + 2, sizeof(header) + pixelBytes, 4); // file size
+    putNumber(header + 10, sizeof(header), 4);             // pixel data offset
+    putNumber(header + 14, 40, 4);                         // info header size
+    putNumber(header + 18, screenWidth, 4);
+    putNumber(header + 22, screenHeight, 4);
+    putNumber(header + 26, 1, 2);  // planes
+    putNumber(header + 28, 24, 2); // bits per pixel
+    putNumber(header + 34, pixelBytes, 4);
+
+    FILE *f = fopen(file, "wb");
+    int result = 1;
+    if (f)
+    {
+        if (fwrite(header, sizeof(header), 1, f) == 1 && fwrite(pixels, pixelBytes, 1, f) == 1)
+            result = 0;
+        if (fclose(f) != 0)
+            result = 1;
+    }
+    if (result != 0)
+        fprintf(stderr, "Cannot write %s\n", file);
+
+    free(pixels);
+    return result;
+}
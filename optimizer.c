@@ -0,0 +1,519 @@
+#include "CSCIx229.h"
+
+// Chairs face +Z at rotation 0, so 180 turns them towards the stage
+#define FACE_STAGE_ROTATION 180.0f
+
+// How far an object is nudged during the compaction pass
+#define SLIDE_STEP 0.05f
+
+// Scan settings tried during the greedy phase (grid step and starting offsets)
+static const float scanSteps[] = {0.5f, 0.25f};
+static const float scanOffsets[][2] = {{0.0f, 0.0f}, {0.5f, 0.0f}, {0.0f, 0.5f}, {0.5f, 0.5f}};
+
+// Where a greedy fill is in its walk over the room, so it can carry on next frame
+typedef struct
+{
+    int itemIndex;
+    int started; // x and z hold the next spot to try
+    float x, z;
+    int done;
+} GreedyScan;
+
+typedef enum
+{
+    OPTIMIZE_IDLE,
+    OPTIMIZE_GREEDY,  // phase 1: greedy attempts with different grids
+    OPTIMIZE_COMPACT, // phase 2: sliding the objects together
+    OPTIMIZE_REFILL   // phase 2: filling the space the sliding opened up
+} OptimizePhase;
+
+// State of the search while it runs a slice per frame
+typedef struct
+{
+    OptimizePhase phase;
+    LayoutItem *items;
+    int itemCount;
+    LayoutConstraints constraints;
+    int *remaining;
+    int *bestRemaining;
+    SceneObject *bestObjects;
+    int baseCount;
+    int bestCount;
+    int bestSeats;
+    int attempt;
+    int attemptCount;
+    int seats; // seats of the current attempt, then of the final layout
+    GreedyScan scan;
+    int compactIndex;
+    int compactMoved;
+    int refillAdded;
+    double workMs;  // time spent in slices; only this counts towards the budget
+    double startMs; // wall clock start, for the messages
+    char saveFile[64];
+} OptimizeJob;
+
+static OptimizeJob optimizeJob;
+static int lastSeats = 0;
+
+// Checks if a spawn type is something people sit on
+static int isSeat(SceneSpawnType type)
+{
+    return type == SPAWN_BANQUET_CHAIR || type == SPAWN_BAR_CHAIR;
+}
+
+// Checks if two rectangles on the floor overlap
+static int rectsOverlap(float aMinX, float aMaxX, float aMinZ, float aMaxZ,
+                        float bMinX, float bMaxX, float bMinZ, float bMaxZ)
+{
+    return aMaxX > bMinX && aMinX < bMaxX && aMaxZ > bMinZ && aMinZ < bMaxZ;
+}
+
+// Checks if an object standing at (x, z) stays out of the aisle, the stage and the doorway
+static int footprintAllowed(const SceneObject *sceneObject, float x, float z,
+                            const LayoutConstraints *constraints)
+{
+    float minX, maxX, minZ, maxZ;
+    scene_object_footprint(sceneObject, x, z, &minX, &maxX, &minZ, &maxZ);
+
+    // Must be fully inside the room
+    if (minX < ROOM_MIN_X || maxX > ROOM_MAX_X || minZ < ROOM_MIN_Z || maxZ > ROOM_MAX_Z)
+        return 0;
+
+    // Center aisle from the stage to the door
+    float halfAisle = constraints->aisleWidth * 0.5f;
+    if (halfAisle > 0.0f &&
+        rectsOverlap(minX, maxX, minZ, maxZ,
+                     DOOR_POS_X - halfAisle, DOOR_POS_X + halfAisle, STAGE_MAX_Z, ROOM_MAX_Z))
+        return 0;
+
+    // Stage plus the empty strip in front of it
+    float stageGap = constraints->stageClearance;
+    if (rectsOverlap(minX, maxX, minZ, maxZ,
+                     STAGE_MIN_X - stageGap, STAGE_MAX_X + stageGap, STAGE_MIN_Z, STAGE_MAX_Z + stageGap))
+        return 0;
+
+    // Space just inside the door
+    float doorGap = constraints->doorClearance;
+    if (doorGap > 0.0f &&
+        rectsOverlap(minX, maxX, minZ, maxZ,
+                     DOOR_POS_X - doorGap, DOOR_POS_X + doorGap, ROOM_MAX_Z - doorGap, ROOM_MAX_Z + 2.0f))
+        return 0;
+
+    return 1;
+}
+
+// Builds the object used for testing, grown by the seat clearance so placed objects keep a gap
+static int buildTestObject(SceneSpawnType type, const LayoutConstraints *constraints, SceneObject *testObject)
+{
+    if (!scene_spawn_prototype(type, testObject))
+        return 0;
+
+    testObject->rotation = isSeat(type) ? FACE_STAGE_ROTATION : 0.0f;
+
+    float gap = constraints->seatClearance;
+    for (int boxIndex = 0; boxIndex < testObject->subBoxCount; boxIndex++)
+    {
+        testObject->subBox[boxIndex][0] -= gap;
+        testObject->subBox[boxIndex][1] += gap;
+        testObject->subBox[boxIndex][4] -= gap;
+        testObject->subBox[boxIndex][5] += gap;
+    }
+    return 1;
+}
+
+// Greedy pass: walks the room row by row starting at the stage and drops objects into every free spot
+// Picks up where the scan stopped last time and sets scan->done once the walk is over
+// Returns the number of seats placed during this call
+static int greedyFill(GreedyScan *scan, const LayoutItem *items, int itemCount, int *remaining,
+                      const LayoutConstraints *constraints,
+                      float step, float offsetX, float offsetZ, double deadline)
+{
+    int seats = 0;
+
+    for (; scan->itemIndex < itemCount; scan->itemIndex++, scan->started = 0)
+    {
+        int itemIndex = scan->itemIndex;
+        SceneSpawnType type = items[itemIndex].type;
+        SceneObject testObject;
+
+        if (remaining[itemIndex] == 0 || !buildTestObject(type, constraints, &testObject))
+            continue;
+
+        if (!scan->started)
+        {
+            scan->x = ROOM_MIN_X + offsetX * step;
+            scan->z = ROOM_MIN_Z + offsetZ * step;
+            scan->started = 1;
+        }
+
+        for (; scan->z <= ROOM_MAX_Z && remaining[itemIndex] != 0; scan->z += step, scan->x = ROOM_MIN_X + offsetX * step)
+        {
+            for (; scan->x <= ROOM_MAX_X && remaining[itemIndex] != 0; scan->x += step)
+            {
+                // Stop once the time is used up, the next call tries this spot again
+                if (timer_now_ms() > deadline)
+                    return seats;
+
+                float x = scan->x;
+                float z = scan->z;
+                if (!footprintAllowed(&testObject, x, z, constraints))
+                    continue;
+                if (collidesWithAnyObject(&testObject, x, z, false, true))
+                    continue;
+
+                if (!scene_spawn_at(type, x, z, testObject.rotation))
+                {
+                    scan->done = 1; // Object limit reached
+                    return seats;
+                }
+
+                if (remaining[itemIndex] > 0)
+                    remaining[itemIndex]--;
+                if (isSeat(type))
+                    seats++;
+            }
+        }
+    }
+
+    scan->done = 1;
+    return seats;
+}
+
+// Local search: slides every placed object towards the stage and the aisle to squeeze out gaps
+// Continues from *index and sets *moved if anything moved; returns 1 once every object had its turn
+static int compactPlaced(int *index, int *moved, const LayoutConstraints *constraints, double deadline)
+{
+    for (; *index < objectCount; (*index)++)
+    {
+        if (timer_now_ms() > deadline)
+            return 0;
+
+        SceneObject *sceneObject = &objects[*index];
+        SceneObject testObject = *sceneObject;
+        float gap = constraints->seatClearance;
+
+        for (int boxIndex = 0; boxIndex < testObject.subBoxCount; boxIndex++)
+        {
+            testObject.subBox[boxIndex][0] -= gap;
+            testObject.subBox[boxIndex][1] += gap;
+            testObject.subBox[boxIndex][4] -= gap;
+            testObject.subBox[boxIndex][5] += gap;
+        }
+
+        // Hide the real object so the grown copy doesn't hit it
+        sceneObject->solid = 0;
+
+        // Towards the stage first, then sideways towards the aisle
+        float directionX = (sceneObject->x > DOOR_POS_X) ? -SLIDE_STEP : SLIDE_STEP;
+        float slides[2][2] = {{0.0f, -SLIDE_STEP}, {directionX, 0.0f}};
+        int outOfTime = 0;
+
+        for (int s = 0; s < 2 && !outOfTime; s++)
+        {
+            while (1)
+            {
+                // A long slide can use up the time on its own; the same object carries on next call
+                if (timer_now_ms() > deadline)
+                {
+                    outOfTime = 1;
+                    break;
+                }
+
+                float newX = sceneObject->x + slides[s][0];
+                float newZ = sceneObject->z + slides[s][1];
+
+                if (!footprintAllowed(&testObject, newX, newZ, constraints) ||
+                    collidesWithAnyObject(&testObject, newX, newZ, false, true))
+                    break;
+
+                sceneObject->x = newX;
+                sceneObject->z = newZ;
+                *moved = 1;
+            }
+        }
+
+        sceneObject->solid = 1;
+        scene_apply_stage_height(sceneObject);
+
+        if (outOfTime)
+            return 0;
+    }
+
+    return 1;
+}
+
+// Clears the scene for the next greedy attempt
+static void startAttempt(OptimizeJob *job)
+{
+    for (int i = 0; i < job->itemCount; i++)
+        job->remaining[i] = job->items[i].count;
+
+    objectCount = job->baseCount;
+    scene_spawn_reset();
+    memset(&job->scan, 0, sizeof(job->scan));
+    job->seats = 0;
+}
+
+// Keeps a copy of the best layout so far, so it comes back exactly as it was found
+static void finishAttempt(OptimizeJob *job)
+{
+    if (job->seats > job->bestSeats)
+    {
+        job->bestSeats = job->seats;
+        job->bestCount = objectCount - job->baseCount;
+        memcpy(job->bestObjects, objects + job->baseCount, job->bestCount * sizeof(SceneObject));
+        memcpy(job->bestRemaining, job->remaining, job->itemCount * sizeof(int));
+    }
+
+    printf("Optimizer: attempt %d/%d, %d seats (best %d), %.0f ms\n",
+           job->attempt + 1, job->attemptCount, job->seats, job->bestSeats, job->workMs);
+}
+
+// Puts the winning attempt back (restoring names and counters like a loaded layout)
+static void restoreBest(OptimizeJob *job)
+{
+    objectCount = job->baseCount;
+    scene_spawn_reset();
+    for (int i = 0; i < job->bestCount; i++)
+    {
+        const SceneObject *placed = &job->bestObjects[i];
+        scene_spawn_restore((SceneSpawnType)layout_type_from_name(placed->name), placed->name,
+                            placed->x, placed->y, placed->z, placed->rotation, placed->scale);
+    }
+    memcpy(job->remaining, job->bestRemaining, job->itemCount * sizeof(int));
+    job->seats = job->bestSeats;
+}
+
+// Frees the search buffers
+static void releaseJob(OptimizeJob *job)
+{
+    free(job->items);
+    free(job->remaining);
+    free(job->bestRemaining);
+    free(job->bestObjects);
+    memset(job, 0, sizeof(*job));
+}
+
+// Closes the undo step, checkpoints the journal and saves the result
+static void finishJob(OptimizeJob *job)
+{
+    for (int i = job->baseCount; i < objectCount; i++)
+        undo_record_spawn(&objects[i]);
+    undo_end_edit();
+
+    // Spawns made by the search are not journaled one by one
+    journal_checkpoint();
+    if (job->saveFile[0])
+        save_scene_async(job->saveFile);
+
+    printf("Optimizer: %d seats, %d objects in %.0f ms (%.0f ms of search)\n",
+           job->seats, objectCount - job->baseCount, timer_now_ms() - job->startMs, job->workMs);
+    lastSeats = job->seats;
+    releaseJob(job);
+}
+
+// Starts the search for a furniture layout that fits the most seats
+// The current furniture is cleared right away; layout_optimize_update then works on it a slice per frame
+int layout_optimize_start(const LayoutItem *items, int itemCount, const LayoutConstraints *constraints,
+                          const char *saveFile)
+{
+    OptimizeJob *job = &optimizeJob;
+
+    if (!items || itemCount <= 0 || !constraints || job->phase != OPTIMIZE_IDLE)
+        return 0;
+
+    job->items = (LayoutItem *)malloc(itemCount * sizeof(LayoutItem));
+    job->remaining = (int *)malloc(itemCount * sizeof(int));
+    job->bestRemaining = (int *)malloc(itemCount * sizeof(int));
+    job->bestObjects = (SceneObject *)malloc(MAX_OBJECTS * sizeof(SceneObject));
+    if (!job->items || !job->remaining || !job->bestRemaining || !job->bestObjects)
+    {
+        releaseJob(job);
+        return 0;
+    }
+
+    memcpy(job->items, items, itemCount * sizeof(LayoutItem));
+    job->itemCount = itemCount;
+    job->constraints = *constraints;
+    snprintf(job->saveFile, sizeof(job->saveFile), "%s", saveFile ? saveFile : "");
+    job->startMs = timer_now_ms();
+
+    // The old furniture and the new layout undo as one step
+    undo_begin_edit();
+    for (int i = 0; i < objectCount; i++)
+        if (objects[i].movable)
+            undo_record_remove(&objects[i]);
+    scene_clear_movable_objects();
+    job->baseCount = objectCount;
+    job->bestSeats = -1;
+
+    job->attemptCount = (int)(sizeof(scanSteps) / sizeof(scanSteps[0]) * sizeof(scanOffsets) / sizeof(scanOffsets[0]));
+    job->phase = OPTIMIZE_GREEDY;
+    startAttempt(job);
+    return 1;
+}
+
+// Works on the running search until the time budget for this frame is used up
+void layout_optimize_update(double budgetMs)
+{
+    OptimizeJob *job = &optimizeJob;
+
+    if (job->phase == OPTIMIZE_IDLE)
+        return;
+
+    double traceStart = TRACE_NOW();
+    double sliceStart = timer_now_ms();
+    double sliceEnd = sliceStart + budgetMs;
+
+    // Most of the budget goes to the greedy attempts, the rest to the local search
+    double greedyBudget = job->constraints.timeBudgetMs * 0.6;
+    double totalBudget = job->constraints.timeBudgetMs;
+
+    while (job->phase != OPTIMIZE_IDLE)
+    {
+        double now = timer_now_ms();
+        double used = job->workMs + (now - sliceStart);
+        if (now >= sliceEnd)
+            break;
+
+        if (job->phase == OPTIMIZE_GREEDY)
+        {
+            float step = scanSteps[job->attempt / 4];
+            const float *offset = scanOffsets[job->attempt % 4];
+            double deadline = fmin(sliceEnd, now + greedyBudget - used);
+
+            job->seats += greedyFill(&job->scan, job->items, job->itemCount, job->remaining, &job->constraints,
+                                     step, offset[0], offset[1], deadline);
+
+            int outOfTime = job->workMs + (timer_now_ms() - sliceStart) >= greedyBudget;
+            if (!job->scan.done && !outOfTime)
+                continue;
+
+            job->workMs += timer_now_ms() - sliceStart;
+            sliceStart = timer_now_ms();
+            finishAttempt(job);
+
+            if (outOfTime || ++job->attempt >= job->attemptCount)
+            {
+                restoreBest(job);
+                job->compactIndex = job->baseCount;
+                job->compactMoved = 0;
+                job->phase = OPTIMIZE_COMPACT;
+            }
+            else
+            {
+                startAttempt(job);
+            }
+            continue;
+        }
+
+        // Phase 2: squeeze the layout together and fill whatever space opened up
+        if (used >= totalBudget)
+        {
+            job->workMs = used;
+            finishJob(job);
+            break;
+        }
+        double deadline = fmin(sliceEnd, now + totalBudget - used);
+
+        if (job->phase == OPTIMIZE_COMPACT)
+        {
+            if (!compactPlaced(&job->compactIndex, &job->compactMoved, &job->constraints, deadline))
+                continue;
+
+            if (!job->compactMoved)
+            {
+                job->workMs += timer_now_ms() - sliceStart;
+                finishJob(job);
+                break;
+            }
+            memset(&job->scan, 0, sizeof(job->scan));
+            job->refillAdded = 0;
+            job->phase = OPTIMIZE_REFILL;
+        }
+        else
+        {
+            int added = greedyFill(&job->scan, job->items, job->itemCount, job->remaining, &job->constraints,
+                                   scanSteps[1], 0.0f, 0.0f, deadline);
+            job->seats += added;
+            job->refillAdded += added;
+            if (!job->scan.done)
+                continue;
+
+            printf("Optimizer: local search added %d seats, %.0f ms\n",
+                   job->refillAdded, job->workMs + (timer_now_ms() - sliceStart));
+            if (job->refillAdded == 0)
+            {
+                job->workMs += timer_now_ms() - sliceStart;
+                finishJob(job);
+                break;
+            }
+            job->compactIndex = job->baseCount;
+            job->compactMoved = 0;
+            job->phase = OPTIMIZE_COMPACT;
+        }
+    }
+
+    if (job->phase != OPTIMIZE_IDLE)
+        job->workMs += timer_now_ms() - sliceStart;
+    TRACE_RECORD("layout optimize", "optimizer", traceStart);
+}
+
+// Checks if a search is still running
+int layout_optimize_running(void)
+{
+    return optimizeJob.phase != OPTIMIZE_IDLE;
+}
+
+// Writes a one line progress message for the HUD; returns 0 when no search is running
+int layout_optimize_status(char *text, int size)
+{
+    const OptimizeJob *job = &optimizeJob;
+
+    if (job->phase == OPTIMIZE_IDLE || !text || size <= 0)
+        return 0;
+
+    int percent = (int)(100.0 * job->workMs / job->constraints.timeBudgetMs);
+    if (percent > 100)
+        percent = 100;
+
+    if (job->phase == OPTIMIZE_GREEDY)
+        snprintf(text, size, "Optimizing layout... attempt %d/%d, %d seats (best %d), %d%%",
+                 job->attempt + 1, job->attemptCount, job->seats, job->bestSeats < 0 ? 0 : job->bestSeats, percent);
+    else
+        snprintf(text, size, "Optimizing layout... compacting, %d seats, %d%%", job->seats, percent);
+    return 1;
+}
+
+// Runs the whole search at once; used by tools that don't draw frames in between
+// Leaves the best layout in the scene and returns its seat count
+int layout_optimize(const LayoutItem *items, int itemCount, const LayoutConstraints *constraints)
+{
+    if (!layout_optimize_start(items, itemCount, constraints, NULL))
+        return 0;
+
+    while (layout_optimize_running())
+        layout_optimize_update(constraints->timeBudgetMs);
+    return lastSeats;
+}
+
+// Starts filling the hall with as many banquet chairs as fit; the result is saved as a normal layout
+void layout_optimize_default(void)
+{
+    const LayoutItem items[] = {{SPAWN_BANQUET_CHAIR, -1}};
+    const LayoutConstraints constraints = {2.0f, 2.0f, 4.0f, 0.2f, 3000};
+
+    if (layout_optimize_running())
+    {
+        printf("Optimizer is already running.\n");
+        return;
+    }
+    if (scene_spawn_pending_count() > 0)
+    {
+        printf("Wait for the queued objects to be placed first.\n");
+        return;
+    }
+
+    if (layout_optimize_start(items, 1, &constraints, "layout_optimized.csv"))
+        printf("Optimizer: searching for %d ms, the hall is locked until it is done.\n", constraints.timeBudgetMs);
+}
@@ -0,0 +1,221 @@
+#include "CSCIx229.h"
+
+// Distance from a round table's center to its chairs
+#define ROUND_CHAIR_RADIUS 2.3f
+
+// Chairs face +Z at rotation 0, so 180 turns them towards the stage
+#define FACE_STAGE_ROTATION 180.0f
+
+// Ready made patterns used by the keyboard controls
+static const ScenePattern defaultPatterns[PATTERN_TYPE_COUNT] = {
+    // 8 rows of 12 chairs with an aisle down the middle
+    [PATTERN_THEATRE] = {PATTERN_THEATRE, 0.0f, -6.0f, 8, 12, 1.4f, 2.0f, 6, 2.0f, 0},
+    // 2 x 3 round tables with 6 chairs each
+    [PATTERN_ROUNDS] = {PATTERN_ROUNDS, 0.0f, 8.0f, 2, 3, 9.0f, 8.0f, 0, 0.0f, 6},
+    // 4 rows of 3 desks, 2 chairs behind each desk
+    [PATTERN_CLASSROOM] = {PATTERN_CLASSROOM, 0.0f, 0.0f, 4, 3, 6.0f, 4.5f, 0, 0.0f, 2}};
+
+// Names used when printing the patterns
+static const char *patternNames[PATTERN_TYPE_COUNT] = {
+    [PATTERN_THEATRE] = "Theatre rows",
+    [PATTERN_ROUNDS] = "Round tables",
+    [PATTERN_CLASSROOM] = "Classroom block"};
+
+// Pattern currently picked with the keyboard
+static ScenePatternType activePattern = PATTERN_THEATRE;
+
+// Helper function to add one slot to the list
+static void addSlot(ScenePatternSlot *slots, int maxSlots, int *slotCount,
+                    SceneSpawnType type, float x, float z, float rotation)
+{
+    // Keep counting even when the list is full so the caller knows
+    if (*slotCount < maxSlots)
+    {
+        ScenePatternSlot *slot = &slots[*slotCount];
+        slot->type = type;
+        slot->x = x;
+        slot->z = z;
+        slot->rotation = rotation;
+        slot->status = SLOT_PENDING;
+    }
+    (*slotCount)++;
+}
+
+// Calculates how far a column sits from the left edge, including any aisles before it
+static float columnOffset(const ScenePattern *pattern, int col)
+{
+    float offset = col * pattern->spacingX;
+    if (pattern->aisleEvery > 0)
+        offset += (col / pattern->aisleEvery) * pattern->aisleWidth;
+    return offset;
+}
+
+// Works out every position in the pattern without touching the scene
+int scene_pattern_build(const ScenePattern *pattern, ScenePatternSlot *slots, int maxSlots)
+{
+    if (!pattern || pattern->rows <= 0 || pattern->cols <= 0)
+        return 0;
+
+    int slotCount = 0;
+
+    // Total width of the block so it can be centered on the origin
+    float width = columnOffset(pattern, pattern->cols - 1);
+    float depth = (pattern->rows - 1) * pattern->spacingZ;
+    float startX = pattern->originX - width * 0.5f;
+    float startZ = pattern->originZ - depth * 0.5f;
+
+    // Rows run front (near the stage) to back
+    for (int row = 0; row < pattern->rows; row++)
+    {
+        float rowZ = startZ + row * pattern->spacingZ;
+
+        for (int col = 0; col < pattern->cols; col++)
+        {
+            float colX = startX + columnOffset(pattern, col);
+
+            switch (pattern->type)
+            {
+            // A single chair facing the stage
+            case PATTERN_THEATRE:
+                addSlot(slots, maxSlots, &slotCount, SPAWN_BANQUET_CHAIR, colX, rowZ, FACE_STAGE_ROTATION);
+                break;
+
+            // A round table with chairs evenly spaced around it
+            case PATTERN_ROUNDS:
+                addSlot(slots, maxSlots, &slotCount, SPAWN_COCKTAIL_1, colX, rowZ, 0.0f);
+                for (int seat = 0; seat < pattern->seatsPerTable; seat++)
+                {
+                    float angle = 360.0f * seat / pattern->seatsPerTable;
+                    float chairX = colX + ROUND_CHAIR_RADIUS * Cos(angle);
+                    float chairZ = rowZ + ROUND_CHAIR_RADIUS * Sin(angle);
+
+                    // Turn the chair so its front points at the table
+                    float facing = atan2f(-Cos(angle), -Sin(angle)) * 180.0f / PI;
+                    if (facing < 0.0f)
+                        facing += 360.0f;
+                    addSlot(slots, maxSlots, &slotCount, SPAWN_BANQUET_CHAIR, chairX, chairZ, facing);
+                }
+                break;
+
+            // A desk with its chairs lined up behind it
+            case PATTERN_CLASSROOM:
+                addSlot(slots, maxSlots, &slotCount, SPAWN_EVENT_TABLE, colX, rowZ, 0.0f);
+                for (int seat = 0; seat < pattern->seatsPerTable; seat++)
+                {
+                    float seatOffset = (seat - 0.5f * (pattern->seatsPerTable - 1)) * 1.6f;
+                    addSlot(slots, maxSlots, &slotCount, SPAWN_BANQUET_CHAIR,
+                            colX + seatOffset, rowZ + 1.8f, FACE_STAGE_ROTATION);
+                }
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+
+    return slotCount;
+}
+
+// Checks and places every slot of a pattern in one pass
+// Slots placed earlier in the batch are already in the scene, so later slots are tested against them too
+int scene_spawn_pattern(const ScenePattern *pattern, ScenePatternSlot *slots, int maxSlots, int *slotCountOut)
+{
+    int slotCount = scene_pattern_build(pattern, slots, maxSlots);
+    if (slotCount > maxSlots)
+    {
+        printf("Pattern needs %d slots, only %d checked.\n", slotCount, maxSlots);
+        slotCount = maxSlots;
+    }
+
+    int placed = 0;
+
+    // The whole pattern is undone in one step
+    undo_begin_edit();
+
+    for (int i = 0; i < slotCount; i++)
+    {
+        ScenePatternSlot *slot = &slots[i];
+
+        // The center must be inside the room walls
+        if (slot->x < ROOM_MIN_X || slot->x > ROOM_MAX_X ||
+            slot->z < ROOM_MIN_Z || slot->z > ROOM_MAX_Z)
+        {
+            slot->status = SLOT_OUTSIDE_ROOM;
+            continue;
+        }
+
+        // Build a test object turned the same way as the final one
+        SceneObject prototype;
+        if (!scene_spawn_prototype(slot->type, &prototype))
+        {
+            slot->status = SLOT_COLLISION;
+            continue;
+        }
+        prototype.rotation = slot->rotation;
+
+        // Check against the room and everything placed so far
+        if (collidesWithAnyObject(&prototype, slot->x, slot->z, false, true))
+        {
+            slot->status = SLOT_COLLISION;
+            continue;
+        }
+
+        SceneObject *placedObject = scene_spawn_at(slot->type, slot->x, slot->z, slot->rotation);
+        if (!placedObject)
+        {
+            slot->status = SLOT_NO_CAPACITY;
+            continue;
+        }
+        undo_record_spawn(placedObject);
+
+        slot->status = SLOT_PLACED;
+        placed++;
+    }
+
+    undo_end_edit();
+
+    if (slotCountOut)
+        *slotCountOut = slotCount;
+    return placed;
+}
+
+// Picks the next ready made pattern
+void scene_pattern_cycle(void)
+{
+    activePattern = (activePattern + 1) % PATTERN_TYPE_COUNT;
+    printf("Pattern: %s.\n", patternNames[activePattern]);
+}
+
+// Stamps the currently picked pattern and prints which slots failed
+void scene_spawn_active_pattern(void)
+{
+    static ScenePatternSlot slots[MAX_PATTERN_SLOTS];
+    int slotCount = 0;
+
+    int placed = scene_spawn_pattern(&defaultPatterns[activePattern], slots, MAX_PATTERN_SLOTS, &slotCount);
+
+    // Report every slot that could not be used
+    for (int i = 0; i < slotCount; i++)
+    {
+        const char *reason = NULL;
+        if (slots[i].status == SLOT_OUTSIDE_ROOM)
+            reason = "outside room";
+        else if (slots[i].status == SLOT_COLLISION)
+            reason = "collision";
+        else if (slots[i].status == SLOT_NO_CAPACITY)
+            reason = "object limit reached";
+
+        if (reason)
+            printf("  Slot %d at (%.1f, %.1f): %s\n", i, slots[i].x, slots[i].z, reason);
+    }
+
+    printf("%s: placed %d of %d slots.\n", patternNames[activePattern], placed, slotCount);
+
+    // One checkpoint for the whole batch instead of a journal line per slot
+    if (placed > 0)
+        journal_checkpoint();
+
+    selectedObject = NULL;
+    dragging = 0;
+}
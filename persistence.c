@@ -1,7 +1,13 @@
 #include "CSCIx229.h"
 
+// Files ending in this are saved and loaded in the binary layout format
+#define LAYOUT_BIN_EXTENSION ".ehl"
+
+// stdio buffer used when writing CSV layouts (1 MB)
+#define LAYOUT_WRITE_BUFFER (1 << 20)
+
 // Helper function to check which spawn type matches a given name
-static int get_type_from_name(const char *name)
+int layout_type_from_name(const char *name)
 {
     // Check if the object name contains specific words
     if (strstr(name, "Lamp"))
@@ -24,18 +30,24 @@ static int get_type_from_name(const char *name)
     return -1; // Could not identify the object type
 }
 
-// Helper function to save the current room setup to a text file
-void save_scene(const char *filename)
+// Checks if a file name uses the binary layout format
+int layout_is_binary(const char *filename)
 {
-    // Create a new file or overwrite existing one
-    FILE *sceneFile = fopen(filename, "w");
-    if (!sceneFile)
-    {
-        printf("Error: Could not save to %s\n", filename);
-        return;
-    }
+    size_t nameLength = strlen(filename);
+    size_t extLength = strlen(LAYOUT_BIN_EXTENSION);
+
+    return nameLength >= extLength && strcmp(filename + nameLength - extLength, LAYOUT_BIN_EXTENSION) == 0;
+}
+
+// Copies every movable object into a new list of records (caller frees it)
+// Returns the number of records, or -1 if memory ran out
+int scene_snapshot_layout(LayoutRecord **recordsOut)
+{
+    LayoutRecord *records = (LayoutRecord *)malloc((objectCount > 0 ? objectCount : 1) * sizeof(LayoutRecord));
+    if (!records)
+        return -1;
 
-    // Loop through every object currently in the scene
+    int recordCount = 0;
     for (int i = 0; i < objectCount; i++)
     {
         SceneObject *sceneObject = &objects[i];
@@ -44,91 +56,260 @@ void save_scene(const char *filename)
         if (!sceneObject->movable)
             continue;
 
-        // Format: O,Name,X,Y,Z,Rotation,Scale
-        fprintf(sceneFile, "O,%s,%.4f,%.4f,%.4f,%.4f,%.4f\n",
-                sceneObject->name,
-                sceneObject->x,
-                sceneObject->y,
-                sceneObject->z,
-                sceneObject->rotation,
-                sceneObject->scale);
+        LayoutRecord *record = &records[recordCount++];
+        memcpy(record->name, sceneObject->name, sizeof(record->name));
+        record->type = layout_type_from_name(sceneObject->name);
+        record->x = sceneObject->x;
+        record->y = sceneObject->y;
+        record->z = sceneObject->z;
+        record->rotation = sceneObject->rotation;
+        record->scale = sceneObject->scale;
     }
 
-    // Close the file (gets saved)
-    fclose(sceneFile);
-    printf("Scene saved to %s\n", filename);
+    *recordsOut = records;
+    return recordCount;
 }
 
-// Helper function to load room setup from a text file
-void load_scene(const char *filename)
+// Writes records to a CSV text file
+// Returns 0 on success, -1 on failure
+int layout_write_csv(const char *filename, const LayoutRecord *records, int recordCount)
 {
-    // Open file
-    FILE *sceneFile = fopen(filename, "r");
+    // Create a new file or overwrite existing one
+    FILE *sceneFile = fopen(filename, "w");
     if (!sceneFile)
+        return -1;
+
+    // Large buffer so the file is written in a few big chunks
+    setvbuf(sceneFile, NULL, _IOFBF, LAYOUT_WRITE_BUFFER);
+
+    for (int i = 0; i < recordCount; i++)
     {
-        printf("Error: Could not load %s\n", filename);
-        return;
+        // Format: O,Name,X,Y,Z,Rotation,Scale
+        fprintf(sceneFile, "O,%s,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+                records[i].name,
+                records[i].x,
+                records[i].y,
+                records[i].z,
+                records[i].rotation,
+                records[i].scale);
     }
 
-    // Delete all current furniture
-    for (int i = objectCount - 1; i >= 0; i--)
+    // Close the file (gets saved)
+    return fclose(sceneFile) == 0 ? 0 : -1;
+}
+
+// Reads a CSV layout and hands every object record to recordFunc
+// Malformed object lines are reported with their line and column and skipped
+// Returns the number of records read, or -1 if the file could not be opened
+int layout_read_csv(const char *filename, LayoutRecordFunc recordFunc, void *userData)
+{
+    CsvReader reader;
+    if (csv_open(&reader, filename) != 0)
+        return -1;
+
+    int recordCount = 0;
+
+    // Read the file line by line
+    while (csv_next_record(&reader) >= 0)
     {
-        if (objects[i].movable)
+        // Check if this line describes an Object (first field is just "O")
+        if (strcmp(reader.fields[0], "O") != 0)
+            continue;
+
+        // Format: O,Name,X,Y,Z,Rotation,Scale
+        if (reader.fieldCount < 7)
         {
-            // To remove an object, we shift everything after it down by one slot
-            for (int j = i; j < objectCount - 1; j++)
-            {
-                objects[j] = objects[j + 1];
-                objects[j].id = j;
-            }
-            objectCount--; // Reduce the total count of objects
+            printf("%s:%d: expected 7 fields, found %d\n", filename, reader.line, reader.fieldCount);
+            continue;
         }
-    }
-    selectedObject = NULL;
 
-    // Buffer to hold each line of text we read from the file
-    char line[256];
-    
-    // Read the file line by line
-    while (fgets(line, sizeof(line), sceneFile))
-    {
-        // Check if this line describes an Object (starts with 'O')
-        if (line[0] == 'O') 
+        LayoutRecord record;
+        memset(&record, 0, sizeof(record));
+
+        const char *name = reader.fields[1];
+        if (name[0] == '\0' || strlen(name) >= sizeof(record.name))
         {
-            char nameBuffer[64];
-            float savedX, savedY, savedZ, savedRotation, savedScale;
+            printf("%s:%d:%d: bad object name\n", filename, reader.line, reader.fieldColumns[1]);
+            continue;
+        }
+        strcpy(record.name, name);
 
-            // Extract the numbers and name
-            if (sscanf(line, "O,%[^,],%f,%f,%f,%f,%f",
-                       nameBuffer, &savedX, &savedY, &savedZ, &savedRotation, &savedScale) == 6)
+        // Extract the numbers
+        float *values[5] = {&record.x, &record.y, &record.z, &record.rotation, &record.scale};
+        int valid = 1;
+        for (int i = 0; i < 5 && valid; i++)
+        {
+            if (!csv_parse_float(reader.fields[i + 2], values[i]))
             {
-                // Figure out which type of furniture this name corresponds to
-                int spawnType = get_type_from_name(nameBuffer);
-                
-                // If it is a valid type, create it
-                if (spawnType >= 0)
-                {
-                    // Create the new object in the scene
-                    SceneObject *spawnedObject = scene_spawn_object((SceneSpawnType)spawnType);
-                    
-                    // Update its position and rotation to match what was in the file
-                    if (spawnedObject)
-                    {
-                        spawnedObject->x = savedX;
-                        spawnedObject->y = savedY;
-                        spawnedObject->z = savedZ;
-                        spawnedObject->rotation = savedRotation;
-                        spawnedObject->scale = savedScale;
-                    }
-                }
+                printf("%s:%d:%d: expected a number, found \"%s\"\n",
+                       filename, reader.line, reader.fieldColumns[i + 2], reader.fields[i + 2]);
+                valid = 0;
             }
         }
+        if (!valid)
+            continue;
+
+        // Figure out which type of furniture this name corresponds to
+        record.type = layout_type_from_name(record.name);
+        recordCount++;
+
+        if (!recordFunc(&record, userData))
+            break;
     }
 
     // Done reading, close the file
-    fclose(sceneFile);
-    printf("Scene loaded from %s\n", filename);
-    
+    csv_close(&reader);
+    return recordCount;
+}
+
+// Reads a layout in either format
+int layout_read(const char *filename, LayoutRecordFunc recordFunc, void *userData)
+{
+    if (layout_is_binary(filename))
+        return layout_read_bin(filename, recordFunc, userData);
+    return layout_read_csv(filename, recordFunc, userData);
+}
+
+// Writes a layout in the format picked by the file name
+int layout_write(const char *filename, const LayoutRecord *records, int recordCount)
+{
+    if (layout_is_binary(filename))
+        return layout_write_bin(filename, records, recordCount);
+    return layout_write_csv(filename, records, recordCount);
+}
+
+// Writes a layout to a temporary file and renames it over the real one,
+// so a crash never leaves a half written layout behind
+int layout_write_atomic(const char *filename, const LayoutRecord *records, int recordCount)
+{
+    char tempFile[272];
+    snprintf(tempFile, sizeof(tempFile), "%s.tmp", filename);
+
+    // The format comes from the real name, not the ".tmp" one
+    int result = layout_is_binary(filename) ? layout_write_bin(tempFile, records, recordCount)
+                                            : layout_write_csv(tempFile, records, recordCount);
+    if (result != 0)
+    {
+        remove(tempFile);
+        return -1;
+    }
+
+#ifdef _WIN32
+    // rename() won't replace an existing file on Windows
+    remove(filename);
+#endif
+    return rename(tempFile, filename) == 0 ? 0 : -1;
+}
+
+// Helper function to save the current room setup to a file
+void save_scene(const char *filename)
+{
+    LayoutRecord *records = NULL;
+    int recordCount = scene_snapshot_layout(&records);
+
+    if (recordCount < 0 || layout_write(filename, records, recordCount) != 0)
+        printf("Error: Could not save to %s\n", filename);
+    else
+        printf("Scene saved to %s\n", filename);
+
+    free(records);
+}
+
+// Puts one loaded record back into the scene (userData is the name of the source for messages)
+int scene_restore_record(const LayoutRecord *record, void *userData)
+{
+    const char *filename = (const char *)userData;
+
+    // Skip names we don't recognise
+    if (record->type < 0 || record->type >= SPAWN_TYPE_COUNT)
+        return 1;
+
+    // Put it straight back where it was saved
+    if (!scene_spawn_restore((SceneSpawnType)record->type, record->name,
+                             record->x, record->y, record->z, record->rotation, record->scale))
+    {
+        printf("Maximum object count reached, rest of %s skipped.\n", filename);
+        return 0;
+    }
+    return 1;
+}
+
+// Clears the furniture before a layout is loaded
+// Returns the index the loaded objects start at
+int scene_begin_load(void)
+{
+    scene_clear_movable_objects();
+    scene_spawn_reset();
+
+    // The old history points at objects that are gone
+    undo_clear();
+    return objectCount;
+}
+
+// Checks and reports a layout loaded since scene_begin_load
+void scene_finish_load(const char *sourceName, int firstLoaded, double startTime)
+{
+    // Check the whole layout for overlaps at once
+    int overlapCount = scene_check_overlaps(firstLoaded);
+    if (overlapCount > 0)
+        printf("Warning: %d overlapping pairs in %s\n", overlapCount, sourceName);
+
+    printf("Scene loaded from %s (%d objects, %.1f ms)\n", sourceName, objectCount - firstLoaded, timer_now_ms() - startTime);
+
+    // The whole layout changed, so start the journal over from here
+    journal_checkpoint();
+
     // Redraw the screen with the new objects
-    glutPostRedisplay();
+    if (!offscreenRendering)
+        glutPostRedisplay();
+}
+
+// Helper function to load room setup from a file
+// Returns 0 on success
+int load_scene(const char *filename)
+{
+    // A missing or broken file must leave the current layout alone, so everything is checked
+    // before the furniture is cleared
+    double startTime = timer_now_ms();
+    int firstLoaded;
+    if (layout_is_binary(filename))
+    {
+        // Check the mapped file, then restore straight from the mapping
+        size_t fileSize = 0;
+        const unsigned char *data = file_map(filename, &fileSize);
+        if (!data || layout_bin_validate(data, fileSize, filename) < 0)
+        {
+            printf("Error: Could not load %s\n", filename);
+            if (data)
+                file_unmap(data, fileSize);
+            return -1;
+        }
+
+        firstLoaded = scene_begin_load();
+        layout_bin_decode(data, fileSize, filename, scene_restore_record, (void *)filename);
+        file_unmap(data, fileSize);
+    }
+    else
+    {
+        // A CSV file can only be checked by reading all of it
+        LayoutRecordList list = {NULL, 0, 0};
+        int recordCount = layout_read_csv(filename, layout_collect_record, &list);
+        if (recordCount < 0 || list.count != recordCount)
+        {
+            printf("Error: Could not load %s%s\n", filename, recordCount >= 0 ? " (out of memory)" : "");
+            free(list.records);
+            return -1;
+        }
+
+        // Swap the furniture for the loaded records
+        firstLoaded = scene_begin_load();
+        for (int i = 0; i < list.count; i++)
+            if (!scene_restore_record(&list.records[i], (void *)filename))
+                break;
+        free(list.records);
+    }
+
+    scene_finish_load(filename, firstLoaded, startTime);
+    TRACE_RECORD("load_scene", "io", startTime);
+    return 0;
 }
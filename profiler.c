@@ -0,0 +1,256 @@
+#include "CSCIx229.h"
+
+// Frame profiler: CPU time of each phase of a frame over the last PROFILE_HISTORY frames
+// Phases are timed with PROFILE_BEGIN / PROFILE_END, which compile to nothing with -DNO_PROFILER.
+// A phase may run several times in a frame; its times add up.
+// While the overlay is shown, GPU_BEGIN / GPU_END also time the main render passes on the graphics
+// card with GL_TIME_ELAPSED queries. Each frame uses its own set of queries and a set is read back
+// GPU_QUERY_FRAMES frames later, so reading the results never waits for the card.
+#define PROFILE_HISTORY 120
+#define GPU_QUERY_FRAMES 3
+#define GPU_QUERIES_PER_FRAME 64
+
+int profilerShown = 0;
+
+#ifndef NO_PROFILER
+// Names shown in the overlay, in ProfilePhase order
+static const char *phaseNames[PROFILE_PHASE_COUNT] = {
+    "Frame", "Lighting", "Floor/walls", "Stage", "Objects", "Fire", "Ceiling", "HUD"};
+
+static double phaseStart[PROFILE_PHASE_COUNT];
+static double phaseTotal[PROFILE_PHASE_COUNT]; // this frame so far
+static float history[PROFILE_PHASE_COUNT][PROFILE_HISTORY];
+static int historyCount = 0;
+static int historyNext = 0;
+
+// GPU pass timing
+static const char *gpuPassNames[GPU_PASS_COUNT] = {
+    "Room shell", "Furniture", "Outline", "Fire", "Ceiling", "HUD"};
+
+static int gpuTimersSupported = -1; // not checked yet
+static unsigned int gpuQueries[GPU_QUERY_FRAMES][GPU_QUERIES_PER_FRAME];
+static int gpuQueryPass[GPU_QUERY_FRAMES][GPU_QUERIES_PER_FRAME];
+static int gpuQueryCount[GPU_QUERY_FRAMES];
+static int gpuFrame = 0;       // query set of this frame
+static int gpuActivePass = -1; // pass being timed (GL can only time one at a time)
+static float gpuHistory[GPU_PASS_COUNT][PROFILE_HISTORY];
+static int gpuHistoryCount = 0;
+static int gpuHistoryNext = 0;
+static int gpuFramesDropped = 0; // results that weren't ready in time
+
+// Starts timing a phase
+void profiler_begin(ProfilePhase phase)
+{
+    phaseStart[phase] = timer_now_ms();
+}
+
+// Stops timing a phase
+void profiler_end(ProfilePhase phase)
+{
+    double now = timer_now_ms();
+    phaseTotal[phase] += now - phaseStart[phase];
+    if (traceRecording)
+        trace_record(phaseNames[phase], "frame", phaseStart[phase], now);
+}
+
+// Helper function to check for timer queries (GL 3.3 or ARB_timer_query) and make the query objects
+static int gpuTimersReady(void)
+{
+    if (gpuTimersSupported >= 0)
+        return gpuTimersSupported;
+
+    gpuTimersSupported = 0;
+#ifdef GL_TIME_ELAPSED
+    int major = 0, minor = 0;
+    const char *version = (const char *)glGetString(GL_VERSION);
+    const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    if (version)
+        sscanf(version, "%d.%d", &major, &minor);
+    if (major > 3 || (major == 3 && minor >= 3) || (extensions && strstr(extensions, "GL_ARB_timer_query")))
+    {
+        for (int frame = 0; frame < GPU_QUERY_FRAMES; frame++)
+            glGenQueries(GPU_QUERIES_PER_FRAME, gpuQueries[frame]);
+        gpuTimersSupported = 1;
+    }
+#endif
+    return gpuTimersSupported;
+}
+
+// Starts timing a render pass on the graphics card (only while the overlay is shown)
+void profiler_gpu_begin(GpuPass pass)
+{
+#ifdef GL_TIME_ELAPSED
+    if (!profilerShown || gpuActivePass >= 0 || gpuQueryCount[gpuFrame] == GPU_QUERIES_PER_FRAME || !gpuTimersReady())
+        return;
+
+    int query = gpuQueryCount[gpuFrame];
+    gpuQueryPass[gpuFrame][query] = pass;
+    glBeginQuery(GL_TIME_ELAPSED, gpuQueries[gpuFrame][query]);
+    gpuActivePass = pass;
+#else
+    (void)pass;
+#endif
+}
+
+// Stops timing a render pass
+void profiler_gpu_end(GpuPass pass)
+{
+#ifdef GL_TIME_ELAPSED
+    if (gpuActivePass != (int)pass)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    gpuQueryCount[gpuFrame]++;
+    gpuActivePass = -1;
+#else
+    (void)pass;
+#endif
+}
+
+// Helper function to read back the oldest query set, if the card has finished with it, and reuse it
+static void collectGpuFrame(int frame)
+{
+#ifdef GL_TIME_ELAPSED
+    int count = gpuQueryCount[frame];
+    gpuQueryCount[frame] = 0;
+    if (count == 0)
+        return;
+
+    // Results that aren't in yet are dropped rather than waited for
+    for (int query = 0; query < count; query++)
+    {
+        unsigned int available = 0;
+        glGetQueryObjectuiv(gpuQueries[frame][query], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            gpuFramesDropped++;
+            return;
+        }
+    }
+
+    double passTotal[GPU_PASS_COUNT] = {0.0};
+    for (int query = 0; query < count; query++)
+    {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(gpuQueries[frame][query], GL_QUERY_RESULT, &nanoseconds);
+        passTotal[gpuQueryPass[frame][query]] += nanoseconds / 1.0e6;
+    }
+
+    for (int pass = 0; pass < GPU_PASS_COUNT; pass++)
+        gpuHistory[pass][gpuHistoryNext] = (float)passTotal[pass];
+    gpuHistoryNext = (gpuHistoryNext + 1) % PROFILE_HISTORY;
+    if (gpuHistoryCount < PROFILE_HISTORY)
+        gpuHistoryCount++;
+#else
+    (void)frame;
+#endif
+}
+
+// Files the phase times of the frame that just ended
+void profiler_end_frame(void)
+{
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++)
+    {
+        history[phase][historyNext] = (float)phaseTotal[phase];
+        phaseTotal[phase] = 0.0;
+    }
+    historyNext = (historyNext + 1) % PROFILE_HISTORY;
+    if (historyCount < PROFILE_HISTORY)
+        historyCount++;
+
+    // Move on to the next query set, reading what it timed GPU_QUERY_FRAMES frames ago
+    if (gpuTimersSupported == 1)
+    {
+        gpuFrame = (gpuFrame + 1) % GPU_QUERY_FRAMES;
+        collectGpuFrame(gpuFrame);
+    }
+}
+
+// Helper function for qsort to sort times
+static int compareTimes(const void *a, const void *b)
+{
+    float timeA = *(const float *)a;
+    float timeB = *(const float *)b;
+    return (timeA > timeB) - (timeA < timeB);
+}
+
+// Helper function to draw the min, average and 99th percentile of each row, starting at y
+// Returns the y of the last line drawn
+static int drawTimes(int y, const char *title, const char **names, const float rows[][PROFILE_HISTORY],
+                     int rowCount, int frameCount)
+{
+    glWindowPos2i(10, y);
+    Print("%s ms, last %d frames", title, frameCount);
+    glWindowPos2i(200, y);
+    Print("min");
+    glWindowPos2i(270, y);
+    Print("avg");
+    glWindowPos2i(340, y);
+    Print("p99");
+
+    for (int row = 0; row < rowCount; row++)
+    {
+        float times[PROFILE_HISTORY];
+        float sum = 0.0f;
+        for (int i = 0; i < frameCount; i++)
+        {
+            times[i] = rows[row][i];
+            sum += times[i];
+        }
+        qsort(times, frameCount, sizeof(float), compareTimes);
+        int p99 = (99 * frameCount + 99) / 100 - 1;
+
+        y -= 20;
+        glWindowPos2i(10, y);
+        Print("%s", names[row]);
+        glWindowPos2i(200, y);
+        Print("%.2f", times[0]);
+        glWindowPos2i(270, y);
+        Print("%.2f", sum / frameCount);
+        glWindowPos2i(340, y);
+        Print("%.2f", times[p99]);
+    }
+    return y;
+}
+
+// Draws the CPU phase times in the top left corner, with the GPU pass times under them
+// Call it with the HUD's projection set up
+void profiler_draw(void)
+{
+    if (!profilerShown || historyCount == 0)
+        return;
+
+    int y = drawTimes(screenHeight - 25, "CPU", phaseNames, (const float(*)[PROFILE_HISTORY])history,
+                      PROFILE_PHASE_COUNT, historyCount);
+
+    y -= 30;
+    if (gpuTimersSupported == 0)
+    {
+        glWindowPos2i(10, y);
+        Print("GPU timers are not supported by this driver");
+    }
+    else if (gpuHistoryCount > 0)
+    {
+        y = drawTimes(y, "GPU", gpuPassNames, (const float(*)[PROFILE_HISTORY])gpuHistory,
+                      GPU_PASS_COUNT, gpuHistoryCount);
+        if (gpuFramesDropped > 0)
+        {
+            glWindowPos2i(10, y - 20);
+            Print("%d frame(s) dropped, results not ready in time", gpuFramesDropped);
+        }
+    }
+}
+#else
+// The profiler is compiled out; the overlay says so
+void profiler_end_frame(void)
+{
+}
+
+void profiler_draw(void)
+{
+    if (!profilerShown)
+        return;
+    glWindowPos2i(10, screenHeight - 25);
+    Print("Profiler left out of this build (-DNO_PROFILER)");
+}
+#endif
@@ -0,0 +1,182 @@
+#include "CSCIx229.h"
+#include <pthread.h>
+
+// How often autosave runs when enabled (ms)
+#define AUTOSAVE_INTERVAL_MS 60000.0
+#define AUTOSAVE_FILE "autosave.csv"
+
+// How long the last save result stays in the HUD (ms)
+#define STATUS_DISPLAY_MS 4000.0
+
+// Autosave toggle
+int autosaveEnabled = 0;
+
+// Files that can be waiting for the writer at once
+#define PENDING_SAVE_MAX 4
+
+// One snapshot waiting for the writer thread
+typedef struct
+{
+    LayoutRecord *records;
+    int recordCount;
+    char file[256];
+} PendingSave;
+
+// Snapshots waiting for the writer thread, oldest first
+// A newer save replaces an older one of the same file that hasn't started; other files keep their turn
+static pthread_mutex_t saveMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t saveCondition = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t idleCondition = PTHREAD_COND_INITIALIZER;
+static PendingSave pendingSaves[PENDING_SAVE_MAX];
+static int pendingSaveCount = 0;
+static int writerBusy = 0;
+static int writerStarted = 0;
+static pthread_t writerThread;
+
+// Result of the last finished save, shown in the HUD
+static char statusText[320] = "";
+static double statusTime = -1e9;
+static double lastAutosave = 0.0;
+
+// Writer thread: waits for snapshots and writes them out
+static void *writerMain(void *unused)
+{
+    (void)unused;
+
+    pthread_mutex_lock(&saveMutex);
+    while (1)
+    {
+        while (pendingSaveCount == 0)
+            pthread_cond_wait(&saveCondition, &saveMutex);
+
+        // Take the oldest snapshot so the UI can queue the next one
+        LayoutRecord *records = pendingSaves[0].records;
+        int recordCount = pendingSaves[0].recordCount;
+        char filename[256];
+        strcpy(filename, pendingSaves[0].file);
+        pendingSaveCount--;
+        memmove(pendingSaves, pendingSaves + 1, pendingSaveCount * sizeof(PendingSave));
+        writerBusy = 1;
+        pthread_cond_broadcast(&idleCondition); // a slot is free again
+        pthread_mutex_unlock(&saveMutex);
+
+        double startTime = timer_now_ms();
+        int result = layout_write_atomic(filename, records, recordCount);
+        double elapsed = timer_now_ms() - startTime;
+        TRACE_RECORD("save", "io", startTime);
+        free(records);
+
+        pthread_mutex_lock(&saveMutex);
+        if (result == 0)
+            snprintf(statusText, sizeof(statusText), "Saved %s (%d objects, %.1f ms)", filename, recordCount, elapsed);
+        else
+            snprintf(statusText, sizeof(statusText), "Error: could not save %s", filename);
+        statusTime = timer_now_ms();
+        writerBusy = 0;
+        pthread_cond_broadcast(&idleCondition);
+    }
+
+    return NULL;
+}
+
+// Takes a snapshot of the furniture and hands it to the writer thread
+// Returns right away; the result appears in the HUD
+void save_scene_async(const char *filename)
+{
+    LayoutRecord *records = NULL;
+    int recordCount = scene_snapshot_layout(&records);
+    if (recordCount < 0)
+    {
+        printf("Error: Could not save to %s\n", filename);
+        return;
+    }
+
+    pthread_mutex_lock(&saveMutex);
+
+    // Start the writer the first time it is needed
+    if (!writerStarted)
+    {
+        if (pthread_create(&writerThread, NULL, writerMain, NULL) != 0)
+        {
+            pthread_mutex_unlock(&saveMutex);
+            free(records);
+            save_scene(filename); // No thread, save the slow way
+            return;
+        }
+        pthread_detach(writerThread);
+        writerStarted = 1;
+
+        // Every normal exit (ESC, closing the window) waits for the saves already queued
+        atexit(save_async_flush);
+    }
+
+    // Replace a snapshot of the same file that hasn't been picked up yet
+    PendingSave *slot = NULL;
+    for (int i = 0; i < pendingSaveCount && !slot; i++)
+        if (strcmp(pendingSaves[i].file, filename) == 0)
+            slot = &pendingSaves[i];
+
+    if (slot)
+        free(slot->records);
+    else
+    {
+        // Otherwise queue it behind the others, waiting for a free slot if every one is taken
+        while (pendingSaveCount == PENDING_SAVE_MAX)
+            pthread_cond_wait(&idleCondition, &saveMutex);
+        slot = &pendingSaves[pendingSaveCount++];
+        snprintf(slot->file, sizeof(slot->file), "%s", filename);
+    }
+    slot->records = records;
+    slot->recordCount = recordCount;
+
+    pthread_cond_signal(&saveCondition);
+    pthread_mutex_unlock(&saveMutex);
+}
+
+// Waits until the writer has finished everything it was given (used before quitting)
+void save_async_flush(void)
+{
+    pthread_mutex_lock(&saveMutex);
+    while (writerStarted && (pendingSaveCount > 0 || writerBusy))
+        pthread_cond_wait(&idleCondition, &saveMutex);
+    pthread_mutex_unlock(&saveMutex);
+}
+
+// Called every frame: runs autosave when it is due
+void save_async_update(void)
+{
+    double now = timer_now_ms();
+
+    if (!autosaveEnabled)
+    {
+        lastAutosave = now;
+        return;
+    }
+
+    if (now - lastAutosave >= AUTOSAVE_INTERVAL_MS)
+    {
+        lastAutosave = now;
+        save_scene_async(AUTOSAVE_FILE);
+    }
+}
+
+// Copies the save status for the HUD; returns 0 if there is nothing to show
+int save_async_status(char *text, int textSize)
+{
+    int shown = 0;
+
+    pthread_mutex_lock(&saveMutex);
+    if (pendingSaveCount > 0 || writerBusy)
+    {
+        snprintf(text, textSize, "Saving...");
+        shown = 1;
+    }
+    else if (timer_now_ms() - statusTime < STATUS_DISPLAY_MS)
+    {
+        snprintf(text, textSize, "%s", statusText);
+        shown = 1;
+    }
+    pthread_mutex_unlock(&saveMutex);
+
+    return shown;
+}
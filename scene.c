@@ -3,13 +3,6 @@
 // Grid snapping settings
 const float GRID_SNAP_SIZE = 5.0f;
 
-// Stage dimensions
-static const float STAGE_MIN_X = -10.0f;
-static const float STAGE_MAX_X = 10.0f;
-static const float STAGE_MIN_Z = -30.0f;
-static const float STAGE_MAX_Z = -20.0f;
-static const float STAGE_HEIGHT = 2.0f;
-
 // Door dimensions
 #define DOOR_WIDTH 3.0f
 #define DOOR_HEIGHT 7.0f
@@ -21,12 +14,20 @@ static const float STAGE_HEIGHT = 2.0f;
 #define CURVED_SCREEN_RADIUS_H 25.0f
 #define CURVED_SCREEN_RADIUS_V 35.0f
 #define CURVED_SCREEN_Z_OFFSET 0.5f
+#define CURVED_SCREEN_X 0.0f
+#define CURVED_SCREEN_Z -30.0f
+
+// Fire animation time in offscreen renders (seconds), so every image shows the same flames
+#define OFFSCREEN_FIRE_TIME 1.0f
 
 // Toggle to enable/disable highlight on bounding boxes
 bool bboxHighlightEnabled = false;
 
 SceneObject objects[MAX_OBJECTS];
 int objectCount = 0;
+static int nextObjectId = 0; // ids stay with an object even when it moves to another slot
+static int *objectSlots = NULL; // slot in objects[] of each id, so lookups by id don't search
+static int objectSlotCapacity = 0;
 SceneObject *selectedObject = NULL;
 SceneObject playerObj;
 int dragging = 0;
@@ -182,7 +183,8 @@ void drawTiledSurface(
                 float tileMinZ = z;
                 float tileMaxZ = fminf(z + tileSize, zmax);
 
-                // Draw the tile
+                // Draw the tile, lit by the lamps near it
+                lighting_select_lamps(0.5f * (tileMinX + tileMaxX), 0.5f * (tileMinZ + tileMaxZ));
                 glBegin(GL_QUADS);
                 glTexCoord2f(0, 0);
                 glVertex3f(tileMinX, y, tileMinZ);
@@ -216,7 +218,8 @@ void drawTiledSurface(
                 float tileMinY = y;
                 float tileMaxY = fminf(y + tileSize, ymax);
 
-                // Draw the tile
+                // Draw the tile, lit by the lamps near it
+                lighting_select_lamps(0.5f * (tileMinX + tileMaxX), z);
                 glBegin(GL_QUADS);
                 glTexCoord2f(0, 0);
                 glVertex3f(tileMinX, tileMinY, z);
@@ -250,7 +253,8 @@ void drawTiledSurface(
                 float tileMinY = y;
                 float tileMaxY = fminf(y + tileSize, ymax);
 
-                // Draw the tile
+                // Draw the tile, lit by the lamps near it
+                lighting_select_lamps(x, 0.5f * (tileMinZ + tileMaxZ));
                 glBegin(GL_QUADS);
                 glTexCoord2f(0, 0);
                 glVertex3f(x, tileMinY, tileMinZ);
@@ -347,6 +351,23 @@ void drawBBox(SceneObject *sceneObject)
     glPopMatrix();
 }
 
+// Helper function to remember which slot of objects[] holds an id
+static void setObjectSlot(int id, int slot)
+{
+    if (id >= objectSlotCapacity)
+    {
+        int newCapacity = objectSlotCapacity ? objectSlotCapacity : MAX_OBJECTS;
+        while (newCapacity <= id)
+            newCapacity *= 2;
+        int *grown = (int *)realloc(objectSlots, newCapacity * sizeof(int));
+        if (!grown)
+            return; // scene_find_object_id searches for ids past the end
+        objectSlots = grown;
+        objectSlotCapacity = newCapacity;
+    }
+    objectSlots[id] = slot;
+}
+
 // Creates a new object and puts it in the list
 SceneObject *addObject(const char *name,
                        float positionX, float positionZ,
@@ -359,7 +380,8 @@ SceneObject *addObject(const char *name,
 
     SceneObject *newObject = &objects[objectCount];
 
-    newObject->id = objectCount;
+    newObject->id = nextObjectId++;
+    setObjectSlot(newObject->id, objectCount);
 
     // Set Name
     strncpy(newObject->name, name, sizeof(newObject->name) - 1);
@@ -388,46 +410,153 @@ SceneObject *addObject(const char *name,
     return newObject;
 }
 
+// Textures the scene draws: file, handle, packed into the furniture atlas, loaded at startup
+// The room is always drawn so it loads up front; furniture loads when a piece is first drawn.
+// The meeting table top reaches past 0-1 and relies on the texture repeating, so it stays out of the atlas
+static const TextureRequest sceneTextures[] = {
+    {"textures/wall.bmp", &wallTex, 0, 1},
+    {"textures/carpet.bmp", &floorTex, 0, 1},
+    {"textures/screen.bmp", &screenTex, 0, 1},
+    {"textures/cocktail.bmp", &cocktailTableTex, 1, 0},
+    {"textures/table.bmp", &tableTex, 1, 0},
+    {"textures/stage.bmp", &stageTex, 0, 1},
+    {"textures/lamprod.bmp", &lampRodTex, 1, 0},
+    {"textures/lampshade.bmp", &lampShadeTex, 1, 0},
+    {"textures/chaircushion.bmp", &chairCushionTex, 1, 0},
+    {"textures/chairleg.bmp", &chairLegTex, 1, 0},
+    {"textures/door.bmp", &doorFrameTex, 0, 1},
+    {"textures/doorknob.bmp", &doorKnobTex, 0, 1},
+    {"textures/cloud.bmp", &cloudTex, 0, 1},
+    {"textures/moon.bmp", &moonTex, 0, 1},
+    {"textures/star.bmp", &starTex, 0, 1},
+    {"textures/thread.bmp", &threadTex, 0, 1},
+    {"textures/meetingtable.bmp", &meetingTableTex, 0, 0},
+    {"textures/meetingtableleg.bmp", &meetingTableLegTex, 1, 0},
+    {"textures/cocktail2.bmp", &cocktail2Tex, 1, 0},
+    {"textures/cocktail2leg.bmp", &cocktail2LegTex, 1, 0},
+    {"textures/cocktail3.bmp", &cocktail3Tex, 1, 0},
+    {"textures/cocktail3leg.bmp", &cocktail3LegTex, 1, 0},
+    {"textures/barchairbackrest.bmp", &barChairBackTex, 1, 0},
+    {"textures/barchaircushion.bmp", &barChairCushionTex, 1, 0},
+    {"textures/barchairwood.bmp", &barChairWoodTex, 1, 0},
+    {"textures/brick.bmp", &fireplaceTex, 0, 1},
+    {"textures/cloud.bmp", &fireNoiseTex, 0, 1},
+};
+
+// Gives the startup texture list to tools that work on the texture files
+const TextureRequest *scene_texture_list(int *count)
+{
+    *count = sizeof(sceneTextures) / sizeof(sceneTextures[0]);
+    return sceneTextures;
+}
+
+// Parts of the room that get a baked lightmap (in the order of sceneLightmaps)
+enum
+{
+    LIGHTMAP_FLOOR,
+    LIGHTMAP_CEILING,
+    LIGHTMAP_WALL_BACK,
+    LIGHTMAP_WALL_FRONT,
+    LIGHTMAP_WALL_LEFT,
+    LIGHTMAP_WALL_RIGHT,
+    LIGHTMAP_STAGE_TOP,
+    LIGHTMAP_STAGE_FRONT,
+    LIGHTMAP_STAGE_LEFT,
+    LIGHTMAP_STAGE_RIGHT,
+    LIGHTMAP_SCREEN
+};
+
+// Finds the spot on the curved screen in front of (u, v) on the wall behind it
+// This follows the curve drawCurvedScreen draws, with the screen standing at (CURVED_SCREEN_X, CURVED_SCREEN_Z)
+static int placeOnCurvedScreen(float u, float v, float position[3], float normal[3])
+{
+    float x = u - 0.5f * CURVED_SCREEN_WIDTH;
+    float y = v - 0.5f * CURVED_SCREEN_HEIGHT;
+    float halfAngleH = 0.5f * CURVED_SCREEN_WIDTH / CURVED_SCREEN_RADIUS_H;
+    float halfAngleV = 0.5f * CURVED_SCREEN_HEIGHT / CURVED_SCREEN_RADIUS_V;
+    if (fabsf(x) > CURVED_SCREEN_RADIUS_H * sinf(halfAngleH) || fabsf(y) > CURVED_SCREEN_RADIUS_V * sinf(halfAngleV))
+        return 0;
+
+    float theta = asinf(x / CURVED_SCREEN_RADIUS_H);
+    float phi = asinf(y / CURVED_SCREEN_RADIUS_V);
+    position[0] = CURVED_SCREEN_X + x;
+    position[1] = CURVED_SCREEN_Y_BASE + 0.5f * CURVED_SCREEN_HEIGHT + y;
+    position[2] = CURVED_SCREEN_Z - CURVED_SCREEN_RADIUS_H * cosf(theta) + CURVED_SCREEN_RADIUS_H + CURVED_SCREEN_Z_OFFSET;
+    normal[0] = sinf(theta);
+    normal[1] = sinf(phi);
+    normal[2] = cosf(theta);
+    return 1;
+}
+
+// The room shell as scene_display draws it: name, corner, directions across, size, facing
+// The screen's lightmap is laid flat on the back wall and projected forward onto the curve
+static const LightmapSurface sceneLightmaps[] = {
+    {"floor", {-20, 0, -30}, {1, 0, 0}, {0, 0, 1}, 40, 60, {0, 1, 0}, NULL},
+    {"ceiling", {-20, 15, -30}, {1, 0, 0}, {0, 0, 1}, 40, 60, {0, -1, 0}, NULL},
+    {"back wall", {-20, 0, -30}, {1, 0, 0}, {0, 1, 0}, 40, 15, {0, 0, 1}, NULL},
+    {"front wall", {-20, 0, 30}, {1, 0, 0}, {0, 1, 0}, 40, 15, {0, 0, -1}, NULL},
+    {"left wall", {-20, 0, -30}, {0, 0, 1}, {0, 1, 0}, 60, 15, {1, 0, 0}, NULL},
+    {"right wall", {20, 0, -30}, {0, 0, 1}, {0, 1, 0}, 60, 15, {-1, 0, 0}, NULL},
+    {"stage top", {STAGE_MIN_X, STAGE_HEIGHT, STAGE_MIN_Z}, {1, 0, 0}, {0, 0, 1},
+     STAGE_MAX_X - STAGE_MIN_X, STAGE_MAX_Z - STAGE_MIN_Z, {0, 1, 0}, NULL},
+    {"stage front", {STAGE_MIN_X, 0, STAGE_MAX_Z}, {1, 0, 0}, {0, 1, 0},
+     STAGE_MAX_X - STAGE_MIN_X, STAGE_HEIGHT, {0, 0, 1}, NULL},
+    {"stage left", {STAGE_MIN_X, 0, STAGE_MIN_Z}, {0, 0, 1}, {0, 1, 0},
+     STAGE_MAX_Z - STAGE_MIN_Z, STAGE_HEIGHT, {-1, 0, 0}, NULL},
+    {"stage right", {STAGE_MAX_X, 0, STAGE_MIN_Z}, {0, 0, 1}, {0, 1, 0},
+     STAGE_MAX_Z - STAGE_MIN_Z, STAGE_HEIGHT, {1, 0, 0}, NULL},
+    {"screen", {CURVED_SCREEN_X - 0.5f * CURVED_SCREEN_WIDTH, CURVED_SCREEN_Y_BASE, CURVED_SCREEN_Z}, {1, 0, 0}, {0, 1, 0},
+     CURVED_SCREEN_WIDTH, CURVED_SCREEN_HEIGHT, {0, 0, 1}, placeOnCurvedScreen},
+};
+
+// Gives the lightmap baker the room shell
+const LightmapSurface *scene_lightmap_surfaces(int *count)
+{
+    *count = sizeof(sceneLightmaps) / sizeof(sceneLightmaps[0]);
+    return sceneLightmaps;
+}
+
+// Gives the lightmap baker the collision boxes of the fixed objects drawn in the room
+// The screen is left out: its box reaches down to the floor to cover the whole curve
+int scene_lightmap_occluders(float boxes[][6], int maxBoxes)
+{
+    int boxCount = 0;
+    for (int i = 0; i < objectCount; i++)
+    {
+        const SceneObject *sceneObject = &objects[i];
+        if (sceneObject->movable || !sceneObject->drawFunc || sceneObject->drawFunc == drawCurvedScreenObject)
+            continue;
+        for (int b = 0; b < sceneObject->subBoxCount && boxCount < maxBoxes; b++)
+            scene_object_box_bounds(sceneObject, b, boxes[boxCount++]);
+    }
+    return boxCount;
+}
+
 void scene_init(void)
 {
-    // Load Textures
-    wallTex = LoadTexBMP("textures/wall.bmp");
-    floorTex = LoadTexBMP("textures/carpet.bmp");
-    screenTex = LoadTexBMP("textures/screen.bmp");
-    cocktailTableTex = LoadTexBMP("textures/cocktail.bmp");
-    tableTex = LoadTexBMP("textures/table.bmp");
-    stageTex = LoadTexBMP("textures/stage.bmp");
-    lampRodTex = LoadTexBMP("textures/lamprod.bmp");
-    lampShadeTex = LoadTexBMP("textures/lampshade.bmp");
-    chairCushionTex = LoadTexBMP("textures/chaircushion.bmp");
-    chairLegTex = LoadTexBMP("textures/chairleg.bmp");
-    doorFrameTex = LoadTexBMP("textures/door.bmp");
-    doorKnobTex = LoadTexBMP("textures/doorknob.bmp");
-    cloudTex = LoadTexBMP("textures/cloud.bmp");
-    moonTex = LoadTexBMP("textures/moon.bmp");
-    starTex = LoadTexBMP("textures/star.bmp");
-    threadTex = LoadTexBMP("textures/thread.bmp");
-    meetingTableTex = LoadTexBMP("textures/meetingtable.bmp");
-    meetingTableLegTex = LoadTexBMP("textures/meetingtableleg.bmp");
-    cocktail2Tex = LoadTexBMP("textures/cocktail2.bmp");
-    cocktail2LegTex = LoadTexBMP("textures/cocktail2leg.bmp");
-    cocktail3Tex = LoadTexBMP("textures/cocktail3.bmp");
-    cocktail3LegTex = LoadTexBMP("textures/cocktail3leg.bmp");
-    barChairBackTex = LoadTexBMP("textures/barchairbackrest.bmp");
-    barChairCushionTex = LoadTexBMP("textures/barchaircushion.bmp");
-    barChairWoodTex = LoadTexBMP("textures/barchairwood.bmp");
-    fireplaceTex = LoadTexBMP("textures/brick.bmp");
-    fireNoiseTex = LoadTexBMP("textures/cloud.bmp");
-
-    // Load the fire animation shader
-    fireShader = CreateShaderProg("fire.vert", "fire.frag");
+    // Textures: the room's are loaded now (decoded in parallel), furniture's when first drawn
+    int textureCount = 0;
+    const TextureRequest *textures = scene_texture_list(&textureCount);
+    texture_register_batch(textures, textureCount);
+
+    // Load the fire animation shader (from its cached binary when the sources haven't changed)
+    fireShader = shader_load("fire.vert", "fire.frag");
+
+    scene_init_objects();
+
+    // Room lighting baked ahead, or baked in the background when it's missing
+    lightmap_init();
+}
 
+// Builds the room and the starting furniture (no OpenGL calls, so tools can use it without a window)
+void scene_init_objects(void)
+{
     objectCount = 0;
     scene_spawn_reset();
 
     // Spawn fixed objects
-    addObject("Door", 0.0f, 29.9f, drawDoorObject, 0);
-    addObject("CurvedScreen", 0.0f, -30.0f, drawCurvedScreenObject, 0);
+    addObject("Door", DOOR_POS_X, DOOR_POS_Z, drawDoorObject, 0);
+    addObject("CurvedScreen", CURVED_SCREEN_X, CURVED_SCREEN_Z, drawCurvedScreenObject, 0);
     SceneObject *fireplaceObject = addObject("Fireplace", 19.5f, -18.0f, drawFireplace, 0);
     if (fireplaceObject)
     {
@@ -580,6 +709,97 @@ void scene_init(void)
         scene_snap_all_objects();
 }
 
+// Removes every movable object in a single pass, keeping the fixed ones in order
+void scene_clear_movable_objects(void)
+{
+    int keptCount = 0;
+
+    for (int i = 0; i < objectCount; i++)
+    {
+        // Furniture gets dropped
+        if (objects[i].movable)
+            continue;
+
+        // Fixed objects slide down into the next free slot
+        if (keptCount != i)
+        {
+            objects[keptCount] = objects[i];
+            setObjectSlot(objects[keptCount].id, keptCount);
+        }
+        keptCount++;
+    }
+
+    objectCount = keptCount;
+    selectedObject = NULL;
+    dragging = 0;
+}
+
+// Takes an object out of the array; the last object moves into its slot
+void scene_remove_object(SceneObject *sceneObject)
+{
+    int index = (int)(sceneObject - objects);
+    if (index < 0 || index >= objectCount)
+        return;
+
+    objectCount--;
+    if (index != objectCount)
+    {
+        objects[index] = objects[objectCount];
+        setObjectSlot(objects[index].id, index);
+    }
+}
+
+// Gives an object a different id (used to bring back a removed object under its old one)
+void scene_set_object_id(SceneObject *sceneObject, int id)
+{
+    sceneObject->id = id;
+    setObjectSlot(id, (int)(sceneObject - objects));
+}
+
+// Finds an object by its id
+SceneObject *scene_find_object_id(int id)
+{
+    if (id < 0)
+        return NULL;
+
+    if (id < objectSlotCapacity)
+    {
+        // The slot may be stale if the object is gone; then it holds another id or is past the end
+        int slot = objectSlots[id];
+        if (slot >= 0 && slot < objectCount && objects[slot].id == id)
+            return &objects[slot];
+        return NULL;
+    }
+
+    // Only when the slot table couldn't grow
+    for (int i = 0; i < objectCount; i++)
+    {
+        if (objects[i].id == id)
+            return &objects[i];
+    }
+    return NULL;
+}
+
+// Copies an object's position, rotation and scale
+void scene_get_transform(const SceneObject *sceneObject, SceneTransform *transform)
+{
+    transform->x = sceneObject->x;
+    transform->y = sceneObject->y;
+    transform->z = sceneObject->z;
+    transform->rotation = sceneObject->rotation;
+    transform->scale = sceneObject->scale;
+}
+
+// Puts an object back to a saved position, rotation and scale
+void scene_set_transform(SceneObject *sceneObject, const SceneTransform *transform)
+{
+    sceneObject->x = transform->x;
+    sceneObject->y = transform->y;
+    sceneObject->z = transform->z;
+    sceneObject->rotation = transform->rotation;
+    sceneObject->scale = transform->scale;
+}
+
 // Deletes currently selected object
 void scene_remove_selected_object(void)
 {
@@ -613,31 +833,35 @@ void scene_remove_selected_object(void)
         return;
     }
 
-    printf("Removed %s.\n", objects[index].name);
-
-    // Delete it by shifting all subsequent objects left by one slot
-    for (int i = index; i < objectCount - 1; i++)
-    {
-        objects[i] = objects[i + 1];
-        objects[i].id = i;
-    }
+    char name[32];
+    memcpy(name, objects[index].name, sizeof(name));
+    printf("Removed %s.\n", name);
+    undo_record_remove(&objects[index]);
 
-    objectCount--;
+    scene_remove_object(&objects[index]);
     selectedObject = NULL; // Clear selection
     dragging = 0;
+    journal_remove(name);
 }
 
 // The Main Drawing Loop: Renders the scene
 void scene_display(void)
 {
     glPushMatrix();
+    PROFILE_BEGIN(PROFILE_LIGHTING);
     lighting_update();
+    PROFILE_END(PROFILE_LIGHTING);
     glEnable(GL_LIGHTING);
 
     // Floor
+    PROFILE_BEGIN(PROFILE_ROOM);
+    GPU_BEGIN(GPU_ROOM);
+    DRAW_GROUP(DRAW_ROOM);
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, floorTex);
+    texture_bind(floorTex);
+    lightmap_begin(LIGHTMAP_FLOOR);
     drawTiledSurface(-20, 0, -30, 20, 0, 30, 0, 1, 0, 2.0);
+    lightmap_end();
     glDisable(GL_TEXTURE_2D);
 
     // Draw grid (if enabled)
@@ -687,13 +911,15 @@ void scene_display(void)
 
     // Draw ceiling (translucent in orthogonal mode)
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, wallTex);
+    texture_bind(wallTex);
     if (orthoView)
     {
         glColor4f(1.0f, 1.0f, 1.0f, 0.25f);
         glDepthMask(GL_FALSE);
     }
+    lightmap_begin(LIGHTMAP_CEILING);
     drawTiledSurface(-20, 15, -30, 20, 15, 30, 0, -1, 0, 2.0);
+    lightmap_end();
     if (orthoView)
     {
         glDepthMask(GL_TRUE);
@@ -703,7 +929,7 @@ void scene_display(void)
 
     // Draw walls (translucent in orthogonal mode)
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, wallTex);
+    texture_bind(wallTex);
     if (orthoView)
     {
         glColor4f(1.0f, 1.0f, 1.0f, 0.25f);
@@ -711,13 +937,18 @@ void scene_display(void)
     }
 
     // Back
+    lightmap_begin(LIGHTMAP_WALL_BACK);
     drawTiledSurface(-20, 0, -30, 20, 15, -30, 0, 0, 1, 2.0);
     // Front
+    lightmap_begin(LIGHTMAP_WALL_FRONT);
     drawTiledSurface(-20, 0, 30, 20, 15, 30, 0, 0, -1, 2.0);
     // Left
+    lightmap_begin(LIGHTMAP_WALL_LEFT);
     drawTiledSurface(-20, 0, -30, -20, 15, 30, 1, 0, 0, 2.0);
     // Right
+    lightmap_begin(LIGHTMAP_WALL_RIGHT);
     drawTiledSurface(20, 0, -30, 20, 15, 30, -1, 0, 0, 2.0);
+    lightmap_end();
 
     if (orthoView)
     {
@@ -726,17 +957,21 @@ void scene_display(void)
     }
 
     glDisable(GL_TEXTURE_2D);
+    PROFILE_END(PROFILE_ROOM);
 
     // Draw stage
+    PROFILE_BEGIN(PROFILE_STAGE);
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, stageTex);
+    texture_bind(stageTex);
 
     float stageTop = 2.0f;
     float stageBack = -30.0f;
     float stageFront = stageBack + 10.0f;
     float stageWidth = 10.0f;
+    lighting_select_lamps(0.0f, 0.5f * (stageBack + stageFront));
 
     // Stage Top
+    lightmap_begin(LIGHTMAP_STAGE_TOP);
     drawQuadN(
         -stageWidth, stageTop, stageBack,
         stageWidth, stageTop, stageBack,
@@ -745,6 +980,7 @@ void scene_display(void)
         0, 1, 0, 1, 1, 1);
 
     // Stage Front Face
+    lightmap_begin(LIGHTMAP_STAGE_FRONT);
     drawQuadN(
         -stageWidth, 0, stageFront,
         stageWidth, 0, stageFront,
@@ -753,6 +989,7 @@ void scene_display(void)
         0, 0, -1, 1, 1, 1);
 
     // Stage Left Face
+    lightmap_begin(LIGHTMAP_STAGE_LEFT);
     drawQuadN(
         -stageWidth, 0, stageBack,
         -stageWidth, 0, stageFront,
@@ -761,6 +998,7 @@ void scene_display(void)
         -1, 0, 0, 1, 1, 1);
 
     // Stage Right Face
+    lightmap_begin(LIGHTMAP_STAGE_RIGHT);
     drawQuadN(
         stageWidth, 0, stageFront,
         stageWidth, 0, stageBack,
@@ -768,7 +1006,8 @@ void scene_display(void)
         stageWidth, stageTop, stageFront,
         1, 0, 0, 1, 1, 1);
 
-    // Stage Back Face
+    // Stage Back Face (against the wall, no lightmap)
+    lightmap_end();
     drawQuadN(
         -stageWidth, 0, stageBack,
         stageWidth, 0, stageBack,
@@ -777,12 +1016,22 @@ void scene_display(void)
         0, 0, 1, 1, 1, 1);
 
     glDisable(GL_TEXTURE_2D);
+    GPU_END(GPU_ROOM);
+    PROFILE_END(PROFILE_STAGE);
 
     // Draw objects
+    PROFILE_BEGIN(PROFILE_OBJECTS);
+    GPU_BEGIN(GPU_FURNITURE);
     for (int i = 0; i < objectCount; i++)
     {
         SceneObject *sceneObject = &objects[i];
 
+        // Lamps near the object (before its transform, lights are placed in world space)
+        DRAW_OBJECT(sceneObject);
+        lighting_select_lamps(sceneObject->x, sceneObject->z);
+        if (sceneObject->drawFunc == drawCurvedScreenObject)
+            lightmap_begin(LIGHTMAP_SCREEN);
+
         glPushMatrix();
         // Move to object location
         glTranslatef(sceneObject->x, sceneObject->y, sceneObject->z);
@@ -797,6 +1046,16 @@ void scene_display(void)
         }
 
         glPopMatrix();
+        if (sceneObject->drawFunc == drawCurvedScreenObject)
+            lightmap_end();
+
+        // The selection is timed as its own pass
+        if (selectedObject == sceneObject)
+        {
+            GPU_END(GPU_FURNITURE);
+            GPU_BEGIN(GPU_OUTLINE);
+            DRAW_GROUP(DRAW_OUTLINE);
+        }
 
         // Highlight boundingbox if enabled
         if (bboxHighlightEnabled && selectedObject == sceneObject)
@@ -839,27 +1098,43 @@ void scene_display(void)
             glEnable(GL_LIGHTING);
 
             glPopMatrix();
+
+            GPU_END(GPU_OUTLINE);
+            GPU_BEGIN(GPU_FURNITURE);
         }
     }
+    GPU_END(GPU_FURNITURE);
+
+    // Outline of a spawn that is still looking for a spot
+    GPU_BEGIN(GPU_OUTLINE);
+    DRAW_GROUP(DRAW_OUTLINE);
+    scene_spawn_draw_pending();
+    GPU_END(GPU_OUTLINE);
+    PROFILE_END(PROFILE_OBJECTS);
 
     // Draw fire
-    if (fireShader > 0)
+    PROFILE_BEGIN(PROFILE_FIRE);
+    GPU_BEGIN(GPU_FIRE);
+    DRAW_GROUP(DRAW_FIRE);
+    if (shader_use(fireShader))
     {
-        glUseProgram(fireShader);
-
-        // Get time
-        float time = glutGet(GLUT_ELAPSED_TIME) * 0.001f;
-        int timeLoc = glGetUniformLocation(fireShader, "time");
+        // Seconds since the fire was first drawn, or a fixed moment when rendering offscreen
+        static double fireStartMs = -1.0;
+        double nowMs = timer_now_ms();
+        if (fireStartMs < 0.0)
+            fireStartMs = nowMs;
+        float time = offscreenRendering ? OFFSCREEN_FIRE_TIME : (float)((nowMs - fireStartMs) * 0.001);
+        int timeLoc = shader_uniform(fireShader, "time");
         if (timeLoc >= 0)
             glUniform1f(timeLoc, time);
 
         // Bind noise texture
-        int noiseLoc = glGetUniformLocation(fireShader, "noiseTex");
+        int noiseLoc = shader_uniform(fireShader, "noiseTex");
         if (noiseLoc >= 0)
             glUniform1i(noiseLoc, 0);
 
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, fireNoiseTex);
+        texture_bind(fireNoiseTex);
 
         // Make fire semi-transparent
         glEnable(GL_BLEND);
@@ -883,13 +1158,24 @@ void scene_display(void)
         glEnable(GL_LIGHTING);
         glUseProgram(0);
     }
+    GPU_END(GPU_FIRE);
+    PROFILE_END(PROFILE_FIRE);
 
     // Draw ceiling shapes
+    PROFILE_BEGIN(PROFILE_CEILING);
+    GPU_BEGIN(GPU_CEILING);
+    DRAW_GROUP(DRAW_CEILING);
     glPushMatrix();
     drawCeilingShapes();
     glPopMatrix();
+    GPU_END(GPU_CEILING);
+    PROFILE_END(PROFILE_CEILING);
 
     // Draw light position marker
+    DRAW_GROUP(DRAW_OTHER);
     lighting_draw_debug_marker();
     glPopMatrix();
+
+    // Unbind so no atlas tile's texture matrix is left behind
+    texture_bind(0);
 }
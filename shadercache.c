@@ -0,0 +1,409 @@
+#include "CSCIx229.h"
+#include <sys/stat.h>
+
+// Shader programs built from a vertex and a fragment shader file.
+// Linked programs are saved to disk and loaded back on the next launch when the sources and
+// the driver are the same, uniform locations are looked up once per program, and edited
+// shader files are rebuilt while the program runs.
+#define SHADER_MAX 8
+#define SHADER_UNIFORMS 16
+#define SHADER_POLL_MS 500.0
+
+// Program cache file:
+//   header | program binary as the driver returned it
+#define SHADER_CACHE_VERSION 1
+static const char shaderCacheMagic[4] = {'E', 'H', 'S', 'B'};
+
+typedef struct
+{
+    char magic[4];
+    unsigned int version;
+    unsigned long long sourceHash; // both shader sources
+    unsigned long long driverHash; // vendor, renderer and version strings
+    unsigned int binaryFormat;
+    unsigned int binarySize;
+} ShaderCacheHeader;
+
+typedef struct
+{
+    char name[32];
+    int location; // -1 when the program has no such uniform
+} ShaderUniform;
+
+typedef struct
+{
+    char vertFile[64];
+    char fragFile[64];
+    char cacheFile[72];
+    unsigned int program;
+    long long vertTime, fragTime; // file times the program was built from
+    ShaderUniform uniforms[SHADER_UNIFORMS];
+    int uniformCount;
+} ShaderProgram;
+
+static ShaderProgram shaders[SHADER_MAX];
+static int shaderCount = 0;
+static double lastPoll = 0.0;
+
+// FNV-1a hash of a string, continuing from hash
+static unsigned long long hashText(unsigned long long hash, const char *text)
+{
+    for (; text && *text; text++)
+    {
+        hash ^= (unsigned char)*text;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Helper function to get a file's modification time, 0 if it can't be read
+static long long fileTime(const char *file)
+{
+    struct stat fileInfo;
+    return stat(file, &fileInfo) == 0 ? (long long)fileInfo.st_mtime : 0;
+}
+
+// Helper function to read a text file into a malloc'd string, NULL if it can't be read
+static char *readSource(const char *file)
+{
+    FILE *f = fopen(file, "rb");
+    if (!f)
+        return NULL;
+
+    long size = -1;
+    if (fseek(f, 0, SEEK_END) == 0)
+        size = ftell(f);
+    char *text = size >= 0 && fseek(f, 0, SEEK_SET) == 0 ? (char *)malloc(size + 1) : NULL;
+    if (text && fread(text, 1, size, f) != (size_t)size)
+    {
+        free(text);
+        text = NULL;
+    }
+    fclose(f);
+
+    if (text)
+        text[size] = '\0';
+    return text;
+}
+
+// Helper function to print a shader or program log (they may hold warnings even when things worked)
+static void printLog(unsigned int object, int isProgram, const char *what)
+{
+    int length = 0;
+    if (isProgram)
+        glGetProgramiv(object, GL_INFO_LOG_LENGTH, &length);
+    else
+        glGetShaderiv(object, GL_INFO_LOG_LENGTH, &length);
+    if (length <= 1)
+        return;
+
+    char *log = (char *)malloc(length);
+    if (!log)
+        return;
+    if (isProgram)
+        glGetProgramInfoLog(object, length, NULL, log);
+    else
+        glGetShaderInfoLog(object, length, NULL, log);
+    fprintf(stderr, "%s:\n%s\n", what, log);
+    free(log);
+}
+
+// Helper function to compile one shader; returns 0 (after printing the log) if it doesn't compile
+static unsigned int compileShader(GLenum type, const char *file, const char *source)
+{
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    printLog(shader, 0, file);
+
+    int compiled = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled)
+    {
+        fprintf(stderr, "Error compiling %s\n", file);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+#ifdef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+// Helper function to check that the driver can hand out program binaries
+static int binariesSupported(void)
+{
+    int formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    while (glGetError() != GL_NO_ERROR)
+        ;
+    return formatCount > 0;
+}
+
+// Helper function to make a program from the cache file; returns 0 if the cache doesn't match
+static unsigned int loadBinary(const char *cacheFile, unsigned long long sourceHash, unsigned long long driverHash)
+{
+    size_t fileSize = 0;
+    const unsigned char *data = file_map(cacheFile, &fileSize);
+    if (!data)
+        return 0;
+
+    ShaderCacheHeader header;
+    int valid = fileSize >= sizeof(header);
+    if (valid)
+    {
+        memcpy(&header, data, sizeof(header));
+        valid = memcmp(header.magic, shaderCacheMagic, sizeof(header.magic)) == 0 &&
+                header.version == SHADER_CACHE_VERSION &&
+                header.sourceHash == sourceHash && header.driverHash == driverHash &&
+                header.binarySize == fileSize - sizeof(header);
+    }
+
+    unsigned int program = 0;
+    if (valid)
+    {
+        program = glCreateProgram();
+        glProgramBinary(program, header.binaryFormat, data + sizeof(header), header.binarySize);
+
+        // The driver may still turn a binary down, after an update say
+        int linked = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    while (glGetError() != GL_NO_ERROR)
+        ;
+
+    file_unmap(data, fileSize);
+    return program;
+}
+
+// Helper function to save a linked program to the cache file (a temporary file is swapped in)
+static void saveBinary(unsigned int program, const char *cacheFile,
+                       unsigned long long sourceHash, unsigned long long driverHash)
+{
+    int size = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+    void *binary = size > 0 ? malloc(size) : NULL;
+    if (!binary)
+        return;
+
+    ShaderCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, shaderCacheMagic, sizeof(header.magic));
+    header.version = SHADER_CACHE_VERSION;
+    header.sourceHash = sourceHash;
+    header.driverHash = driverHash;
+
+    GLenum format = 0;
+    int length = 0;
+    glGetProgramBinary(program, size, &length, &format, binary);
+    header.binaryFormat = format;
+    header.binarySize = length;
+
+    char tempFile[80];
+    snprintf(tempFile, sizeof(tempFile), "%s.tmp", cacheFile);
+    FILE *f = glGetError() == GL_NO_ERROR && length > 0 ? fopen(tempFile, "wb") : NULL;
+    if (f)
+    {
+        int ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(binary, length, 1, f) == 1;
+        if (fclose(f) != 0)
+            ok = 0;
+        if (ok)
+        {
+#ifdef _WIN32
+            // rename() won't replace an existing file on Windows
+            remove(cacheFile);
+#endif
+            ok = rename(tempFile, cacheFile) == 0;
+        }
+        if (!ok)
+        {
+            remove(tempFile);
+            fprintf(stderr, "Cannot write %s\n", cacheFile);
+        }
+    }
+    free(binary);
+}
+#endif
+
+// Helper function to build a shader's program, from the cache file if it matches
+// Returns 0 (after printing what went wrong) if the sources are missing or don't compile
+static unsigned int buildProgram(ShaderProgram *shader)
+{
+    double startTime = timer_now_ms();
+    shader->vertTime = fileTime(shader->vertFile);
+    shader->fragTime = fileTime(shader->fragFile);
+
+    char *vertSource = readSource(shader->vertFile);
+    char *fragSource = readSource(shader->fragFile);
+    if (!vertSource || !fragSource)
+    {
+        fprintf(stderr, "Cannot open text file %s\n", vertSource ? shader->fragFile : shader->vertFile);
+        free(vertSource);
+        free(fragSource);
+        return 0;
+    }
+
+    // The cache is only good for the same sources on the same driver
+    unsigned long long sourceHash = hashText(hashText(14695981039346656037ull, vertSource), "\n--\n");
+    sourceHash = hashText(sourceHash, fragSource);
+    unsigned long long driverHash = hashText(14695981039346656037ull, (const char *)glGetString(GL_VENDOR));
+    driverHash = hashText(driverHash, (const char *)glGetString(GL_RENDERER));
+    driverHash = hashText(driverHash, (const char *)glGetString(GL_VERSION));
+
+    unsigned int program = 0;
+#ifdef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+    int useBinaries = binariesSupported();
+    if (useBinaries)
+        program = loadBinary(shader->cacheFile, sourceHash, driverHash);
+    if (program)
+    {
+        printf("Shader %s + %s from %s (%.2f ms)\n", shader->vertFile, shader->fragFile, shader->cacheFile,
+               timer_now_ms() - startTime);
+        free(vertSource);
+        free(fragSource);
+        return program;
+    }
+#endif
+
+    unsigned int vert = compileShader(GL_VERTEX_SHADER, shader->vertFile, vertSource);
+    unsigned int frag = vert ? compileShader(GL_FRAGMENT_SHADER, shader->fragFile, fragSource) : 0;
+    free(vertSource);
+    free(fragSource);
+    if (!vert || !frag)
+    {
+        if (vert)
+            glDeleteShader(vert);
+        return 0;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vert);
+    glAttachShader(program, frag);
+#ifdef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+    if (useBinaries)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+    glLinkProgram(program);
+    printLog(program, 1, shader->fragFile);
+
+    // The program keeps what it needs from the shaders
+    glDetachShader(program, vert);
+    glDetachShader(program, frag);
+    glDeleteShader(vert);
+    glDeleteShader(frag);
+
+    int linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        fprintf(stderr, "Error linking %s + %s\n", shader->vertFile, shader->fragFile);
+        glDeleteProgram(program);
+        return 0;
+    }
+
+#ifdef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+    if (useBinaries)
+        saveBinary(program, shader->cacheFile, sourceHash, driverHash);
+#endif
+    printf("Shader %s + %s compiled (%.2f ms)\n", shader->vertFile, shader->fragFile, timer_now_ms() - startTime);
+    return program;
+}
+
+// Loads a shader program from a vertex and a fragment shader file
+// The linked program is cached next to the vertex shader (fire.vert -> fire.ehsb)
+// Returns a shader number for shader_use and shader_uniform, or 0 if it can't be built
+int shader_load(const char *vertFile, const char *fragFile)
+{
+    if (shaderCount == SHADER_MAX || strlen(vertFile) >= sizeof(shaders[0].vertFile) ||
+        strlen(fragFile) >= sizeof(shaders[0].fragFile))
+    {
+        fprintf(stderr, "Cannot load shader %s + %s\n", vertFile, fragFile);
+        return 0;
+    }
+
+    ShaderProgram *shader = &shaders[shaderCount];
+    memset(shader, 0, sizeof(ShaderProgram));
+    strcpy(shader->vertFile, vertFile);
+    strcpy(shader->fragFile, fragFile);
+
+    // Cache file: the vertex shader's name with its extension swapped
+    strcpy(shader->cacheFile, vertFile);
+    char *extension = strrchr(shader->cacheFile, '.');
+    char *slash = strrchr(shader->cacheFile, '/');
+    if (extension && (!slash || extension > slash))
+        *extension = '\0';
+    strcat(shader->cacheFile, ".ehsb");
+
+    shader->program = buildProgram(shader);
+    if (!shader->program)
+        return 0;
+
+    shaderCount++;
+    return shaderCount;
+}
+
+// Makes a shader program current; returns 0 (and changes nothing) for an unknown shader
+int shader_use(int shader)
+{
+    if (shader < 1 || shader > shaderCount)
+        return 0;
+    glUseProgram(shaders[shader - 1].program);
+    return 1;
+}
+
+// Location of a uniform in a shader program, -1 if it has none
+// Each name is looked up in the driver once; later calls find it in the shader's own list
+int shader_uniform(int shader, const char *name)
+{
+    if (shader < 1 || shader > shaderCount)
+        return -1;
+
+    ShaderProgram *program = &shaders[shader - 1];
+    for (int i = 0; i < program->uniformCount; i++)
+    {
+        if (strcmp(program->uniforms[i].name, name) == 0)
+            return program->uniforms[i].location;
+    }
+
+    int location = glGetUniformLocation(program->program, name);
+    if (program->uniformCount < SHADER_UNIFORMS && strlen(name) < sizeof(program->uniforms[0].name))
+    {
+        ShaderUniform *uniform = &program->uniforms[program->uniformCount++];
+        strcpy(uniform->name, name);
+        uniform->location = location;
+    }
+    return location;
+}
+
+// Rebuilds shader programs whose files changed since they were built (checked twice a second)
+// A program that no longer compiles keeps running the old version until the files are fixed
+void shader_poll_reload(void)
+{
+    double now = timer_now_ms();
+    if (now - lastPoll < SHADER_POLL_MS)
+        return;
+    lastPoll = now;
+
+    for (int i = 0; i < shaderCount; i++)
+    {
+        ShaderProgram *shader = &shaders[i];
+        if (fileTime(shader->vertFile) == shader->vertTime && fileTime(shader->fragFile) == shader->fragTime)
+            continue;
+
+        unsigned int program = buildProgram(shader);
+        if (!program)
+        {
+            printf("Shader %s + %s has errors, still using the last version\n", shader->vertFile, shader->fragFile);
+            continue;
+        }
+
+        glUseProgram(0);
+        glDeleteProgram(shader->program);
+        shader->program = program;
+        shader->uniformCount = 0; // locations can move
+        printf("Reloaded shader %s + %s\n", shader->vertFile, shader->fragFile);
+    }
+}
@@ -62,6 +62,9 @@ void scene_snap_position(float *x, float *z)
 // Loops through every object in the scene and tries to snap them to the grid
 void scene_snap_all_objects(void)
 {
+    // Undo puts every object back in one step
+    undo_begin_edit();
+
     for (int i = 0; i < objectCount; i++)
     {
         SceneObject *sceneObject = &objects[i];
@@ -88,12 +91,20 @@ void scene_snap_all_objects(void)
         // Only move the object if the new spot is empty
         if (!collidesWithAnyObject(sceneObject, snappedX, snappedZ, false, true))
         {
+            SceneTransform before;
+            scene_get_transform(sceneObject, &before);
+
             // Apply the new coordinates
             sceneObject->x = snappedX;
             sceneObject->z = snappedZ;
 
             // Adjust height in case it snapped onto a stage
             scene_apply_stage_height(sceneObject);
+
+            if (sceneObject->x != before.x || sceneObject->z != before.z)
+                undo_record_transform(sceneObject, &before);
         }
     }
+
+    undo_end_edit();
 }
@@ -24,75 +24,126 @@ static const ObjectTemplate spawnTemplates[SPAWN_TYPE_COUNT] = {
 // Keeps track of how many of each item we have made
 static int spawnCounters[SPAWN_TYPE_COUNT] = {0};
 
+// Queue of spawn requests waiting for a free spot
+#define SPAWN_QUEUE_SIZE 32
+
+// A placement search that can be paused and picked up again on the next frame
+typedef struct
+{
+    SceneSpawnType type;
+    SceneObject prototype;
+    int snapCandidate;
+    float step;
+    float scanX, scanZ;   // next grid point to test
+    float bestX, bestZ;   // closest free spot found so far
+    float bestDist;
+    int found;
+} SpawnJob;
+
+static SpawnJob spawnQueue[SPAWN_QUEUE_SIZE];
+static int spawnQueueHead = 0;
+static int spawnQueueCount = 0;
+
 // Resets the counter
 void scene_spawn_reset(void)
 {
     memset(spawnCounters, 0, sizeof(spawnCounters));
 }
 
-// Scans the room to find a place to put the new object where it won't hit anything
-static int findFreeGroundSpot(SceneObject *prototype, float *outX, float *outZ)
-{
-    // Need a valid object with boundingbox
-    if (!prototype || prototype->subBoxCount == 0)
-        return 0;
-
-    const float margin = 0.5f;
+// Room area that spawned objects may use
+static const float spawnMargin = 0.5f;
+#define SPAWN_MIN_X (ROOM_MIN_X + spawnMargin)
+#define SPAWN_MAX_X (ROOM_MAX_X - spawnMargin)
+#define SPAWN_MIN_Z (ROOM_MIN_Z + spawnMargin)
+#define SPAWN_MAX_Z (ROOM_MAX_Z - spawnMargin)
 
+// Rewinds a search to the first grid point
+static void spawnJobRestart(SpawnJob *job)
+{
     // If Grid Snap is on, we only check grid points, else we check every 1 unit
-    const int snapCandidate = snapToGridEnabled && scene_object_supports_snap(prototype);
-    const float step = snapCandidate ? GRID_SNAP_SIZE : 1.0f;
+    job->snapCandidate = snapToGridEnabled && scene_object_supports_snap(&job->prototype);
+    job->step = job->snapCandidate ? GRID_SNAP_SIZE : 1.0f;
 
-    float minX = ROOM_MIN_X + margin;
-    float maxX = ROOM_MAX_X - margin;
-    float minZ = ROOM_MIN_Z + margin;
-    float maxZ = ROOM_MAX_Z - margin;
-
-    float bestDist = 1e9f; // Used to find the spot closest to center (0,0)
-    int found = 0;
+    job->scanX = SPAWN_MIN_X;
+    job->scanZ = SPAWN_MIN_Z;
+    job->bestDist = 1e9f; // Used to find the spot closest to center (0,0)
+    job->found = 0;
+}
 
+// Scans the room to find a place to put the new object where it won't hit anything
+// Stops once the deadline passes and returns 0, or returns 1 when the whole room has been checked
+static int spawnJobStep(SpawnJob *job, double deadline)
+{
     // Scan Z rows
-    for (float z = minZ; z <= maxZ; z += step)
+    for (; job->scanZ <= SPAWN_MAX_Z; job->scanZ += job->step, job->scanX = SPAWN_MIN_X)
     {
         // Scan X columns
-        for (float x = minX; x <= maxX; x += step)
+        for (; job->scanX <= SPAWN_MAX_X; job->scanX += job->step)
         {
-            float testX = x;
-            float testZ = z;
+            float testX = job->scanX;
+            float testZ = job->scanZ;
 
             // Align to grid if needed
-            if (snapCandidate)
+            if (job->snapCandidate)
                 scene_snap_position(&testX, &testZ);
 
             // Double check bounds after snapping
-            if (testX < minX)
-                testX = minX;
-            if (testX > maxX)
-                testX = maxX;
-            if (testZ < minZ)
-                testZ = minZ;
-            if (testZ > maxZ)
-                testZ = maxZ;
+            if (testX < SPAWN_MIN_X)
+                testX = SPAWN_MIN_X;
+            if (testX > SPAWN_MAX_X)
+                testX = SPAWN_MAX_X;
+            if (testZ < SPAWN_MIN_Z)
+                testZ = SPAWN_MIN_Z;
+            if (testZ > SPAWN_MAX_Z)
+                testZ = SPAWN_MAX_Z;
 
             // Check if this spot is empty without any collisions
-            if (!collidesWithAnyObject(prototype, testX, testZ, false, true))
+            if (!collidesWithAnyObject(&job->prototype, testX, testZ, false, true))
             {
                 // Valid spot, calculate distance to center of room
                 float dist = testX * testX + testZ * testZ;
 
                 // If this spot is closer to the center than our previous best, take it
-                if (!found || dist < bestDist)
+                if (!job->found || dist < job->bestDist)
                 {
-                    bestDist = dist;
-                    *outX = testX;
-                    *outZ = testZ;
-                    found = 1;
+                    job->bestDist = dist;
+                    job->bestX = testX;
+                    job->bestZ = testZ;
+                    job->found = 1;
                 }
             }
         }
+
+        // Out of time, carry on from the next row later
+        if (timer_now_ms() > deadline)
+        {
+            job->scanZ += job->step;
+            job->scanX = SPAWN_MIN_X;
+            return job->scanZ > SPAWN_MAX_Z;
+        }
     }
 
-    return found; // Return 1 if we found a spot, 0 if room is full
+    return 1;
+}
+
+// Runs a full search in one go
+static int findFreeGroundSpot(SceneObject *prototype, float *outX, float *outZ)
+{
+    // Need a valid object with boundingbox
+    if (!prototype || prototype->subBoxCount == 0)
+        return 0;
+
+    SpawnJob job;
+    job.prototype = *prototype;
+    spawnJobRestart(&job);
+    spawnJobStep(&job, 1e300);
+
+    if (job.found)
+    {
+        *outX = job.bestX;
+        *outZ = job.bestZ;
+    }
+    return job.found; // Return 1 if we found a spot, 0 if room is full
 }
 
 // Helper funciton to check if a text string starts with a specific word
@@ -527,44 +578,43 @@ void configureObjectBounds(SceneObject *sceneObject)
     sceneObject->subBox[0][5] = 0.8f;
 }
 
-// Creates a new object from the list
-SceneObject *scene_spawn_object(SceneSpawnType type)
+// Fills in a temporary object for a spawn type so it can be collision tested
+int scene_spawn_prototype(SceneSpawnType type, SceneObject *prototype)
 {
     // Validate the requested type
-    if (type < 0 || type >= SPAWN_TYPE_COUNT)
-        return NULL;
+    if (type < 0 || type >= SPAWN_TYPE_COUNT || !prototype)
+        return 0;
 
     // Get the template for this object type
     const ObjectTemplate *tmpl = &spawnTemplates[type];
 
-    // Create a temporary object to test collisions
-    SceneObject prototype;
-    memset(&prototype, 0, sizeof(SceneObject));
-    strncpy(prototype.name, tmpl->baseName, sizeof(prototype.name) - 1);
-    prototype.name[sizeof(prototype.name) - 1] = '\0';
+    memset(prototype, 0, sizeof(SceneObject));
+    strncpy(prototype->name, tmpl->baseName, sizeof(prototype->name) - 1);
+    prototype->name[sizeof(prototype->name) - 1] = '\0';
 
     // Set default properties
-    prototype.x = 0.0f;
-    prototype.y = 0.0f;
-    prototype.z = 0.0f;
-    prototype.drawFunc = tmpl->drawFunc;
-    prototype.movable = tmpl->movable;
-    prototype.scale = tmpl->defaultScale;
-    prototype.rotation = tmpl->defaultRotation;
-    prototype.solid = 1;
+    prototype->x = 0.0f;
+    prototype->y = 0.0f;
+    prototype->z = 0.0f;
+    prototype->drawFunc = tmpl->drawFunc;
+    prototype->movable = tmpl->movable;
+    prototype->scale = tmpl->defaultScale;
+    prototype->rotation = tmpl->defaultRotation;
+    prototype->solid = 1;
 
     // Generate the bounding boxes
-    configureObjectBounds(&prototype);
-
-    float spawnX = 0.0f;
-    float spawnZ = 0.0f;
+    configureObjectBounds(prototype);
+    return 1;
+}
 
-    // Find a free spot on the floor
-    if (!findFreeGroundSpot(&prototype, &spawnX, &spawnZ))
-    {
-        printf("No available space for %s.\n", tmpl->baseName);
+// Adds a new object of the given type at an exact spot (no searching)
+SceneObject *scene_spawn_at(SceneSpawnType type, float x, float z, float rotation)
+{
+    // Validate the requested type
+    if (type < 0 || type >= SPAWN_TYPE_COUNT)
         return NULL;
-    }
+
+    const ObjectTemplate *tmpl = &spawnTemplates[type];
 
     // Create a unique name
     char uniqueName[32];
@@ -572,16 +622,15 @@ SceneObject *scene_spawn_object(SceneSpawnType type)
     snprintf(uniqueName, sizeof(uniqueName), "%s_New%d", tmpl->baseName, count);
 
     // Add the object to the scene
-    SceneObject *spawnedObject = addObject(uniqueName, spawnX, spawnZ, tmpl->drawFunc, tmpl->movable);
-
+    SceneObject *spawnedObject = addObject(uniqueName, x, z, tmpl->drawFunc, tmpl->movable);
     if (!spawnedObject)
     {
-        printf("Maximum object count reached.\n");
+        spawnCounters[type]--;
         return NULL;
     }
 
     // Apply the settings to the real object
-    spawnedObject->rotation = tmpl->defaultRotation;
+    spawnedObject->rotation = rotation;
     spawnedObject->scale = tmpl->defaultScale;
 
     // Add bounding boxes to the real object
@@ -589,11 +638,195 @@ SceneObject *scene_spawn_object(SceneSpawnType type)
 
     // If it spawned on a stage, lift it up
     scene_apply_stage_height(spawnedObject);
+    return spawnedObject;
+}
+
+// Base name of a spawn type ("Lamp", "EventTable", ...)
+const char *scene_spawn_type_name(SceneSpawnType type)
+{
+    if (type < 0 || type >= SPAWN_TYPE_COUNT)
+        return "";
+    return spawnTemplates[type].baseName;
+}
+
+// Puts a saved object straight back where it was, skipping the free spot search
+SceneObject *scene_spawn_restore(SceneSpawnType type, const char *name,
+                                 float x, float y, float z, float rotation, float scale)
+{
+    if (type < 0 || type >= SPAWN_TYPE_COUNT || !name)
+        return NULL;
+
+    const ObjectTemplate *tmpl = &spawnTemplates[type];
+
+    SceneObject *restoredObject = addObject(name, x, z, tmpl->drawFunc, tmpl->movable);
+    if (!restoredObject)
+        return NULL;
+
+    restoredObject->y = y;
+    restoredObject->rotation = rotation;
+    restoredObject->scale = scale;
+    configureObjectBounds(restoredObject);
+
+    // Keep the counter ahead of restored "<Type>_New<N>" names so new spawns stay unique
+    size_t baseLength = strlen(tmpl->baseName);
+    int number = 0;
+    if (strncmp(name, tmpl->baseName, baseLength) == 0 &&
+        sscanf(name + baseLength, "_New%d", &number) == 1 &&
+        number > spawnCounters[type])
+        spawnCounters[type] = number;
+
+    return restoredObject;
+}
+
+// Creates a new object from the list
+SceneObject *scene_spawn_object(SceneSpawnType type)
+{
+    // Create a temporary object to test collisions
+    SceneObject prototype;
+    if (!scene_spawn_prototype(type, &prototype))
+        return NULL;
+
+    const ObjectTemplate *tmpl = &spawnTemplates[type];
+
+    float spawnX = 0.0f;
+    float spawnZ = 0.0f;
+
+    // Find a free spot on the floor
+    if (!findFreeGroundSpot(&prototype, &spawnX, &spawnZ))
+    {
+        printf("No available space for %s.\n", tmpl->baseName);
+        return NULL;
+    }
+
+    // Add the object to the scene
+    SceneObject *spawnedObject = scene_spawn_at(type, spawnX, spawnZ, tmpl->defaultRotation);
+
+    if (!spawnedObject)
+    {
+        printf("Maximum object count reached.\n");
+        return NULL;
+    }
 
     // Automatically select the new object for the user
     selectedObject = spawnedObject;
     dragging = 0;
+    journal_spawn(spawnedObject);
+    undo_record_spawn(spawnedObject);
 
     printf("Spawned %s at (%.1f, %.1f).\n", spawnedObject->name, spawnX, spawnZ);
     return spawnedObject;
 }
+
+// Adds a spawn to the queue; the search runs a little each frame in scene_spawn_update
+int scene_spawn_request(SceneSpawnType type)
+{
+    if (type < 0 || type >= SPAWN_TYPE_COUNT)
+        return 0;
+
+    if (spawnQueueCount >= SPAWN_QUEUE_SIZE)
+    {
+        printf("Spawn queue is full.\n");
+        return 0;
+    }
+
+    SpawnJob *job = &spawnQueue[(spawnQueueHead + spawnQueueCount) % SPAWN_QUEUE_SIZE];
+    job->type = type;
+    if (!scene_spawn_prototype(type, &job->prototype) || job->prototype.subBoxCount == 0)
+        return 0;
+    spawnJobRestart(job);
+
+    spawnQueueCount++;
+    return 1;
+}
+
+// Number of spawns still searching for a spot
+int scene_spawn_pending_count(void)
+{
+    return spawnQueueCount;
+}
+
+// Works on queued spawns until the time budget for this frame is used up
+void scene_spawn_update(double budgetMs)
+{
+    double deadline = timer_now_ms() + budgetMs;
+
+    while (spawnQueueCount > 0 && timer_now_ms() < deadline)
+    {
+        SpawnJob *job = &spawnQueue[spawnQueueHead];
+        const ObjectTemplate *tmpl = &spawnTemplates[job->type];
+
+        // Not done yet, continue next frame
+        double traceStart = TRACE_NOW();
+        int finished = spawnJobStep(job, deadline);
+        TRACE_RECORD("spawn search", "spawn", traceStart);
+        if (!finished)
+            return;
+
+        if (job->found)
+        {
+            // The scene may have changed while we were searching, so check the spot again
+            if (collidesWithAnyObject(&job->prototype, job->bestX, job->bestZ, false, true))
+            {
+                spawnJobRestart(job);
+                continue;
+            }
+
+            SceneObject *spawnedObject = scene_spawn_at(job->type, job->bestX, job->bestZ, tmpl->defaultRotation);
+            if (spawnedObject)
+            {
+                // Automatically select the new object for the user
+                selectedObject = spawnedObject;
+                dragging = 0;
+                journal_spawn(spawnedObject);
+                undo_record_spawn(spawnedObject);
+                printf("Spawned %s at (%.1f, %.1f).\n", spawnedObject->name, job->bestX, job->bestZ);
+            }
+            else
+            {
+                printf("Maximum object count reached.\n");
+            }
+        }
+        else
+        {
+            printf("No available space for %s.\n", tmpl->baseName);
+        }
+
+        // Move on to the next request
+        spawnQueueHead = (spawnQueueHead + 1) % SPAWN_QUEUE_SIZE;
+        spawnQueueCount--;
+    }
+}
+
+// Draws an outline where the current spawn is heading while its search is still running
+void scene_spawn_draw_pending(void)
+{
+    if (spawnQueueCount == 0)
+        return;
+
+    SpawnJob *job = &spawnQueue[spawnQueueHead];
+    if (!job->prototype.drawFunc)
+        return;
+
+    // Show the best spot so far, or the scan position if nothing is free yet
+    float ghostX = job->found ? job->bestX : fminf(job->scanX, SPAWN_MAX_X);
+    float ghostZ = job->found ? job->bestZ : fminf(job->scanZ, SPAWN_MAX_Z);
+
+    glPushMatrix();
+    glTranslatef(ghostX, 0.0f, ghostZ);
+    glRotatef(job->prototype.rotation, 0, 1, 0);
+    glScalef(job->prototype.scale, job->prototype.scale, job->prototype.scale);
+
+    glDisable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    glLineWidth(1.0f);
+    glColor3f(0.3f, 0.8f, 1.0f);
+
+    job->prototype.drawFunc(0, 0);
+
+    // Restore normal drawing mode
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glEnable(GL_LIGHTING);
+
+    glPopMatrix();
+}
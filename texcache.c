@@ -0,0 +1,308 @@
+#include "CSCIx229.h"
+#include <sys/stat.h>
+
+// Baked texture cache:
+//   header | entryCount entries | per texture: RGB mipmap chain, full size first, rows packed
+// Each entry remembers the size, change time and hash of the BMP it was made from.
+// All numbers are stored in the host's (little endian) byte order
+#define TEXTURE_CACHE_VERSION 1
+#define TEXTURE_CACHE_ALIGN 16
+static const char textureCacheMagic[4] = {'E', 'H', 'T', 'C'};
+
+typedef struct
+{
+    char magic[4];
+    unsigned int version;
+    unsigned int entryCount;
+    unsigned int entrySize;
+    unsigned int reserved[4];
+} TextureCacheHeader;
+
+typedef struct
+{
+    char file[64];                 // BMP path as the program asks for it
+    long long sourceTime;          // BMP modification time (seconds since 1970)
+    unsigned long long sourceHash; // FNV-1a hash of the BMP file
+    unsigned int sourceSize;       // BMP size in bytes
+    unsigned int width, height;
+    unsigned int channels; // always 3 (RGB)
+    unsigned int levelCount;
+    unsigned int dataOffset, dataSize;
+    unsigned int reserved[5];
+} TextureCacheEntry;
+
+// The open cache (read only, so the decode threads can share it)
+static const unsigned char *cacheData = NULL;
+static size_t cacheSize = 0;
+static const TextureCacheEntry *cacheEntries = NULL;
+static int cacheEntryCount = 0;
+
+// FNV-1a hash of a block of memory
+static unsigned long long hashBytes(const unsigned char *data, size_t size)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Maps the cache file; entries are checked against their BMPs when they are looked up
+// Returns the number of entries, or -1 if there is no usable cache
+int texture_cache_open(const char *cacheFile)
+{
+    texture_cache_close();
+
+    size_t fileSize = 0;
+    const unsigned char *data = file_map(cacheFile, &fileSize);
+    if (!data)
+        return -1;
+
+    // Check the header and that every texture lies inside the file
+    TextureCacheHeader header;
+    int valid = fileSize >= sizeof(header);
+    if (valid)
+    {
+        memcpy(&header, data, sizeof(header));
+        valid = memcmp(header.magic, textureCacheMagic, sizeof(header.magic)) == 0 &&
+                header.version == TEXTURE_CACHE_VERSION &&
+                header.entrySize == sizeof(TextureCacheEntry) &&
+                header.entryCount <= (fileSize - sizeof(header)) / sizeof(TextureCacheEntry);
+    }
+
+    const TextureCacheEntry *entries = (const TextureCacheEntry *)(data + sizeof(TextureCacheHeader));
+    for (unsigned int i = 0; valid && i < header.entryCount; i++)
+    {
+        const TextureCacheEntry *entry = &entries[i];
+        valid = entry->channels == 3 && entry->width > 0 && entry->height > 0 &&
+                entry->width <= 65536 && entry->height <= 65536 &&
+                entry->file[sizeof(entry->file) - 1] == '\0' &&
+                entry->dataSize == texture_mip_chain_size(entry->width, entry->height) &&
+                entry->dataOffset <= fileSize && entry->dataSize <= fileSize - entry->dataOffset;
+    }
+
+    if (!valid)
+    {
+        printf("Texture cache %s is damaged or from another version, ignored\n", cacheFile);
+        file_unmap(data, fileSize);
+        return -1;
+    }
+
+    cacheData = data;
+    cacheSize = fileSize;
+    cacheEntries = entries;
+    cacheEntryCount = header.entryCount;
+    return cacheEntryCount;
+}
+
+// Unmaps the cache (textures taken from it must be uploaded first)
+void texture_cache_close(void)
+{
+    if (cacheData)
+        file_unmap(cacheData, cacheSize);
+    cacheData = NULL;
+    cacheSize = 0;
+    cacheEntries = NULL;
+    cacheEntryCount = 0;
+}
+
+// Looks up a BMP in the open cache; safe to call from several threads at once
+// The entry is used when the BMP's size and time still match. If only the time changed
+// (a fresh checkout, say) the BMP is hashed and the entry is used when the contents are the same.
+// Returns 1 and fills image when the cached copy is up to date, otherwise 0
+int texture_cache_find(const char *file, TextureCacheImage *image)
+{
+    const TextureCacheEntry *entry = NULL;
+    for (int i = 0; i < cacheEntryCount && !entry; i++)
+    {
+        if (strcmp(cacheEntries[i].file, file) == 0)
+            entry = &cacheEntries[i];
+    }
+    if (!entry)
+        return 0;
+
+    struct stat fileInfo;
+    if (stat(file, &fileInfo) != 0 || (unsigned long long)fileInfo.st_size != entry->sourceSize)
+        return 0;
+
+    if ((long long)fileInfo.st_mtime != entry->sourceTime)
+    {
+        size_t sourceSize = 0;
+        const unsigned char *source = file_map(file, &sourceSize);
+        if (!source)
+            return 0;
+        unsigned long long hash = hashBytes(source, sourceSize);
+        file_unmap(source, sourceSize);
+        if (hash != entry->sourceHash)
+            return 0;
+    }
+
+    image->width = entry->width;
+    image->height = entry->height;
+    image->levelCount = entry->levelCount;
+    image->levels = cacheData + entry->dataOffset;
+    return 1;
+}
+
+// Converts a list of BMP files into a new cache file with full mipmap chains
+// Files listed twice are stored once. Returns 0 on success
+int texture_cache_bake(const char *cacheFile, const char *const *files, int count)
+{
+    TextureCacheEntry *entries = (TextureCacheEntry *)calloc(count > 0 ? count : 1, sizeof(TextureCacheEntry));
+    unsigned char **chains = (unsigned char **)calloc(count > 0 ? count : 1, sizeof(unsigned char *));
+    if (!entries || !chains)
+    {
+        free(entries);
+        free(chains);
+        fprintf(stderr, "Out of memory\n");
+        return -1;
+    }
+
+    int entryCount = 0;
+    int result = 0;
+    size_t dataEnd = sizeof(TextureCacheHeader);
+
+    for (int i = 0; i < count && result == 0; i++)
+    {
+        // Skip repeats
+        int repeated = 0;
+        for (int j = 0; j < entryCount && !repeated; j++)
+            repeated = strcmp(entries[j].file, files[i]) == 0;
+        if (repeated)
+            continue;
+
+        TextureCacheEntry *entry = &entries[entryCount];
+        if (strlen(files[i]) >= sizeof(entry->file))
+        {
+            fprintf(stderr, "Texture path too long for the cache: %s\n", files[i]);
+            result = -1;
+            break;
+        }
+
+        // Remember what the BMP looked like
+        struct stat fileInfo;
+        size_t sourceSize = 0;
+        const unsigned char *source = file_map(files[i], &sourceSize);
+        if (!source || stat(files[i], &fileInfo) != 0)
+        {
+            if (source)
+                file_unmap(source, sourceSize);
+            fprintf(stderr, "Cannot read %s\n", files[i]);
+            result = -1;
+            break;
+        }
+        entry->sourceHash = hashBytes(source, sourceSize);
+        entry->sourceSize = (unsigned int)sourceSize;
+        entry->sourceTime = (long long)fileInfo.st_mtime;
+        file_unmap(source, sourceSize);
+
+        // Decode it and build the mipmaps
+        TextureImage image;
+        char error[256];
+        if (texture_decode_bmp(files[i], 0, &image, error, sizeof(error)) != 0)
+        {
+            fprintf(stderr, "%s\n", error);
+            result = -1;
+            break;
+        }
+
+        size_t chainSize = texture_mip_chain_size(image.width, image.height);
+        chains[entryCount] = (unsigned char *)malloc(chainSize);
+        if (!chains[entryCount])
+        {
+            texture_free_image(&image);
+            fprintf(stderr, "Out of memory\n");
+            result = -1;
+            break;
+        }
+        memcpy(chains[entryCount], image.pixels, (size_t)3 * image.width * image.height);
+        texture_build_mipmaps(chains[entryCount], image.width, image.height);
+
+        strcpy(entry->file, files[i]);
+        entry->width = image.width;
+        entry->height = image.height;
+        entry->channels = 3;
+        entry->levelCount = texture_mip_count(image.width, image.height);
+        entry->dataSize = (unsigned int)chainSize;
+        texture_free_image(&image);
+        entryCount++;
+    }
+
+    // Lay out the file: header, entries, then each chain on a 16 byte boundary
+    dataEnd += (size_t)entryCount * sizeof(TextureCacheEntry);
+    for (int i = 0; i < entryCount; i++)
+    {
+        dataEnd = (dataEnd + TEXTURE_CACHE_ALIGN - 1) & ~(size_t)(TEXTURE_CACHE_ALIGN - 1);
+        entries[i].dataOffset = (unsigned int)dataEnd;
+        dataEnd += entries[i].dataSize;
+    }
+    if (dataEnd > 0xffffffffu)
+    {
+        fprintf(stderr, "Textures too large for one cache file\n");
+        result = -1;
+    }
+
+    // Write a temporary file and swap it in, so a failed bake leaves the old cache alone
+    char tempFile[272];
+    snprintf(tempFile, sizeof(tempFile), "%s.tmp", cacheFile);
+    FILE *f = result == 0 ? fopen(tempFile, "wb") : NULL;
+    if (result == 0 && !f)
+    {
+        fprintf(stderr, "Cannot write %s\n", tempFile);
+        result = -1;
+    }
+
+    if (f)
+    {
+        TextureCacheHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, textureCacheMagic, sizeof(header.magic));
+        header.version = TEXTURE_CACHE_VERSION;
+        header.entryCount = entryCount;
+        header.entrySize = sizeof(TextureCacheEntry);
+
+        int ok = fwrite(&header, sizeof(header), 1, f) == 1;
+        if (ok && entryCount > 0)
+            ok = fwrite(entries, sizeof(TextureCacheEntry), entryCount, f) == (size_t)entryCount;
+
+        static const unsigned char padding[TEXTURE_CACHE_ALIGN] = {0};
+        for (int i = 0; i < entryCount && ok; i++)
+        {
+            long position = ftell(f);
+            if (position < 0 || (unsigned long)position > entries[i].dataOffset)
+                ok = 0;
+            else if ((unsigned long)position < entries[i].dataOffset)
+                ok = fwrite(padding, entries[i].dataOffset - position, 1, f) == 1;
+            if (ok)
+                ok = fwrite(chains[i], entries[i].dataSize, 1, f) == 1;
+        }
+
+        if (fclose(f) != 0)
+            ok = 0;
+        if (ok)
+        {
+#ifdef _WIN32
+            // rename() won't replace an existing file on Windows
+            remove(cacheFile);
+#endif
+            ok = rename(tempFile, cacheFile) == 0;
+        }
+        if (!ok)
+        {
+            remove(tempFile);
+            fprintf(stderr, "Cannot write %s\n", cacheFile);
+            result = -1;
+        }
+    }
+
+    if (result == 0)
+        printf("Baked %d textures into %s (%.1f MB)\n", entryCount, cacheFile, dataEnd / (1024.0 * 1024.0));
+
+    for (int i = 0; i < entryCount; i++)
+        free(chains[i]);
+    free(chains);
+    free(entries);
+    return result;
+}
@@ -0,0 +1,959 @@
+#include "CSCIx229.h"
+#include <pthread.h>
+
+// Threads that read and convert BMP files while the main thread uploads
+#define TEXTURE_DECODE_THREADS 4
+
+// Byte order of the BMP header fields
+#define BMP_MAGIC 0x4D42
+#define BMP_MAGIC_SWAPPED 0x424D
+
+// Smallest tile size in the furniture atlas's mipmaps; the tiles keep half a texel of this
+// level away from their edges so filtering never reaches into the next tile
+#define ATLAS_MIN_TILE 32
+
+// Anisotropic filtering level asked for (the driver may allow less)
+#define TEXTURE_ANISOTROPY 8.0f
+
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT 0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+#endif
+
+// Filtering and storage options
+TextureFilter textureFilter = TEXTURE_FILTER_TRILINEAR;
+int textureCompression = 0; // let the driver compress textures as they are uploaded
+int textureStatsShown = 0;  // texture line in the HUD
+int textureBudgetMB = 128;  // texture memory kept before unused textures are unloaded, 0 for no limit
+
+// Every texture the program can load: one BMP file, or the furniture atlas made of several.
+// Textures are loaded the first time they are bound and unloaded again, least recently
+// used first, when the loaded ones need more memory than the budget
+typedef struct
+{
+    const char *file;      // NULL for the atlas
+    unsigned int texture;  // GL texture, 0 while it isn't loaded
+    int width, height;
+    int levelCount;
+    size_t bytes;          // GPU memory used by all levels, as the driver reports it
+    int compressed;
+    unsigned int lastUsed; // frame it was last bound in
+} TextureSource;
+
+static TextureSource *sources = NULL;
+static int sourceCount = 0;
+static int sourceCapacity = 0;
+static int atlasSource = -1;    // the furniture atlas, -1 until a request asks for it
+static int atlasSlotCount = 0;  // tiles in the atlas grid
+static unsigned int frameNumber = 0;
+static int unloadCount = 0;     // textures unloaded to stay inside the budget
+static float maxAnisotropy = 0.0f; // 0 when the driver has no anisotropic filtering
+
+// What the draw code holds: handle h is handles[h - 1], 0 means no texture.
+// Atlas tiles share one GL texture and pick their tile with the texture matrix
+typedef struct
+{
+    const char *file;
+    int source;
+    int atlasSlot; // -1 when the texture has a GL texture of its own
+    float offsetU, offsetV, scaleU, scaleV;
+} TextureHandle;
+
+static TextureHandle *handles = NULL;
+static int handleCount = 0;
+static int handleCapacity = 0;
+
+// What texture_bind last set, so repeated binds cost nothing
+#define BINDING_UNKNOWN 0xffffffffu
+static unsigned int boundTexture = BINDING_UNKNOWN;
+static int boundSlot = -1;
+static int bindCount = 0; // real glBindTexture calls since texture_take_bind_count
+
+// One file being loaded
+typedef struct
+{
+    const char *file;
+    int handle; // index into handles
+    TextureImage image;
+    TextureCacheImage cached; // used instead of image when the cache has this file
+    int fromCache;
+    unsigned char *chain; // mipmap chain built from image when there is no cached one
+    int width, height;
+    const unsigned char *levels; // mipmap chain to upload (cached or chain)
+    char error[256];
+    double decodeMs;
+} TextureJob;
+
+// Work shared with the decode threads
+static pthread_mutex_t jobMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t doneCondition = PTHREAD_COND_INITIALIZER;
+static TextureJob *jobs = NULL;
+static int jobCount = 0;
+static int nextJob = 0;
+static int *doneOrder = NULL; // jobs in the order they finished decoding
+static int doneCount = 0;
+static int maxTextureSize = 0;
+static int cacheEntries = -1;  // entries in the open texture cache, -1 if there is none
+static int cacheWarned = 0;
+
+// Helper function to read a little endian number from the BMP header
+static unsigned int readNumber(const unsigned char *data, int bytes, int swapped)
+{
+    unsigned int value = 0;
+    for (int i = 0; i < bytes; i++)
+    {
+        int shift = swapped ? 8 * (bytes - 1 - i) : 8 * i;
+        value |= (unsigned int)data[i] << shift;
+    }
+    return value;
+}
+
+// Helper function to check a BMP that is in memory and convert its pixels to packed RGB in place
+static int parseBmp(const char *file, unsigned char *data, long fileSize, int maxSize,
+                    TextureImage *image, char *error, int errorSize)
+{
+    // Check image magic (backwards magic means big endian header fields)
+    unsigned int magic = data[0] | (data[1] << 8);
+    if (magic != BMP_MAGIC && magic != BMP_MAGIC_SWAPPED)
+    {
+        snprintf(error, errorSize, "Image magic not BMP in %s", file);
+        return -1;
+    }
+    if (fileSize < 34)
+    {
+        snprintf(error, errorSize, "Cannot read header from %s", file);
+        return -1;
+    }
+    int swapped = (magic == BMP_MAGIC_SWAPPED);
+
+    unsigned int offset = readNumber(data + 10, 4, swapped);
+    unsigned int dx = readNumber(data + 18, 4, swapped);
+    unsigned int dy = readNumber(data + 22, 4, swapped);
+    unsigned int planes = readNumber(data + 26, 2, swapped);
+    unsigned int bpp = readNumber(data + 28, 2, swapped);
+    unsigned int compression = readNumber(data + 30, 4, swapped);
+    unsigned int limit = maxSize > 0 ? (unsigned int)maxSize : 65536;
+
+    // Check image parameters
+    error[0] = '\0';
+    if (dx < 1 || dx > limit)
+        snprintf(error, errorSize, "%s image width %u out of range 1-%u", file, dx, limit);
+    else if (dy < 1 || dy > limit)
+        snprintf(error, errorSize, "%s image height %u out of range 1-%u", file, dy, limit);
+    else if (planes != 1)
+        snprintf(error, errorSize, "%s bit planes is not 1: %u", file, planes);
+    else if (bpp != 24)
+        snprintf(error, errorSize, "%s bits per pixel is not 24: %u", file, bpp);
+    else if (compression != 0)
+        snprintf(error, errorSize, "%s compressed files not supported", file);
+#ifndef GL_VERSION_2_0
+    // OpenGL 2.0 lifts the restriction that texture size must be a power of two
+    else if (dx & (dx - 1))
+        snprintf(error, errorSize, "%s image width not a power of two: %u", file, dx);
+    else if (dy & (dy - 1))
+        snprintf(error, errorSize, "%s image height not a power of two: %u", file, dy);
+#endif
+    if (error[0])
+        return -1;
+
+    // BMP rows are padded to 4 bytes
+    size_t rowSize = (size_t)3 * dx;
+    size_t stride = (rowSize + 3) & ~(size_t)3;
+    size_t needed = stride * (dy - 1) + rowSize;
+    if (offset > (unsigned long)fileSize || needed > (size_t)fileSize - offset)
+    {
+        snprintf(error, errorSize, "Error reading data from image %s", file);
+        return -1;
+    }
+
+    // Pack the rows and reverse colors (BGR -> RGB)
+    unsigned char *pixels = data + offset;
+    for (unsigned int y = 0; y < dy; y++)
+    {
+        unsigned char *row = pixels + y * rowSize;
+        if (stride != rowSize)
+            memmove(row, pixels + y * stride, rowSize);
+        for (size_t k = 0; k < rowSize; k += 3)
+        {
+            unsigned char temp = row[k];
+            row[k] = row[k + 2];
+            row[k + 2] = temp;
+        }
+    }
+
+    image->width = dx;
+    image->height = dy;
+    image->pixels = pixels;
+    return 0;
+}
+
+// Reads a 24 bit BMP and converts it to RGB (same checks as LoadTexBMP; maxSize 0 skips the size limit)
+// Returns 0 on success, otherwise error says what went wrong; texture_free_image releases the image
+int texture_decode_bmp(const char *file, int maxSize, TextureImage *image, char *error, int errorSize)
+{
+    memset(image, 0, sizeof(TextureImage));
+
+    FILE *f = fopen(file, "rb");
+    if (!f)
+    {
+        snprintf(error, errorSize, "Cannot open file %s", file);
+        return -1;
+    }
+
+    // Read the whole file in one go
+    long fileSize = -1;
+    if (fseek(f, 0, SEEK_END) == 0)
+        fileSize = ftell(f);
+    if (fileSize < 2 || fseek(f, 0, SEEK_SET) != 0)
+    {
+        fclose(f);
+        snprintf(error, errorSize, "Cannot read magic from %s", file);
+        return -1;
+    }
+
+    image->memory = malloc(fileSize);
+    if (!image->memory)
+    {
+        fclose(f);
+        snprintf(error, errorSize, "Cannot allocate %ld bytes of memory for image %s", fileSize, file);
+        return -1;
+    }
+    size_t got = fread(image->memory, 1, fileSize, f);
+    fclose(f);
+    if (got != (size_t)fileSize)
+    {
+        snprintf(error, errorSize, "Error reading data from image %s", file);
+        texture_free_image(image);
+        return -1;
+    }
+
+    if (parseBmp(file, (unsigned char *)image->memory, fileSize, maxSize, image, error, errorSize) != 0)
+    {
+        texture_free_image(image);
+        return -1;
+    }
+    return 0;
+}
+
+// Releases an image from texture_decode_bmp
+void texture_free_image(TextureImage *image)
+{
+    free(image->memory);
+    memset(image, 0, sizeof(TextureImage));
+}
+
+// Number of mipmap levels down to 1x1, counting the full size image
+int texture_mip_count(int width, int height)
+{
+    int levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        levels++;
+    }
+    return levels;
+}
+
+// Bytes of RGB data in a whole mipmap chain, the full size image included
+size_t texture_mip_chain_size(int width, int height)
+{
+    size_t size = (size_t)3 * width * height;
+    while (width > 1 || height > 1)
+    {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        size += (size_t)3 * width * height;
+    }
+    return size;
+}
+
+// Builds the smaller mipmap levels of an RGB image by averaging 2x2 blocks
+// chain starts with the full size image; the other levels are written after it, packed
+void texture_build_mipmaps(unsigned char *chain, int width, int height)
+{
+    const unsigned char *source = chain;
+    while (width > 1 || height > 1)
+    {
+        int newWidth = width > 1 ? width / 2 : 1;
+        int newHeight = height > 1 ? height / 2 : 1;
+        unsigned char *target = chain + (source - chain) + (size_t)3 * width * height;
+
+        for (int y = 0; y < newHeight; y++)
+        {
+            // A side of 1 repeats its only row or column
+            int y0 = 2 * y;
+            int y1 = 2 * y + 1 < height ? 2 * y + 1 : y0;
+            for (int x = 0; x < newWidth; x++)
+            {
+                int x0 = 2 * x;
+                int x1 = 2 * x + 1 < width ? 2 * x + 1 : x0;
+                for (int c = 0; c < 3; c++)
+                {
+                    int sum = source[3 * (y0 * width + x0) + c] + source[3 * (y0 * width + x1) + c] +
+                              source[3 * (y1 * width + x0) + c] + source[3 * (y1 * width + x1) + c];
+                    target[3 * (y * newWidth + x) + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+
+        source = target;
+        width = newWidth;
+        height = newHeight;
+    }
+}
+
+// Decode thread: takes jobs until there are none left
+static void *decodeMain(void *unused)
+{
+    (void)unused;
+
+    pthread_mutex_lock(&jobMutex);
+    while (nextJob < jobCount)
+    {
+        TextureJob *job = &jobs[nextJob++];
+        pthread_mutex_unlock(&jobMutex);
+
+        // The baked cache skips the BMP entirely when it is up to date
+        double startTime = timer_now_ms();
+        job->fromCache = texture_cache_find(job->file, &job->cached);
+        if (!job->fromCache &&
+            texture_decode_bmp(job->file, maxTextureSize, &job->image, job->error, sizeof(job->error)) == 0)
+        {
+            // Build the mipmaps here so the main thread only uploads
+            TextureImage *image = &job->image;
+            job->chain = (unsigned char *)malloc(texture_mip_chain_size(image->width, image->height));
+            if (job->chain)
+            {
+                memcpy(job->chain, image->pixels, (size_t)3 * image->width * image->height);
+                texture_build_mipmaps(job->chain, image->width, image->height);
+            }
+            else
+            {
+                snprintf(job->error, sizeof(job->error), "Cannot allocate mipmaps for image %s", job->file);
+            }
+        }
+        job->decodeMs = timer_now_ms() - startTime;
+
+        // Hand the result to the main thread
+        pthread_mutex_lock(&jobMutex);
+        doneOrder[doneCount++] = (int)(job - jobs);
+        pthread_cond_signal(&doneCondition);
+    }
+    pthread_mutex_unlock(&jobMutex);
+
+    return NULL;
+}
+
+// Helper function to check the driver's extension list
+static int hasExtension(const char *name)
+{
+    const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    return extensions && strstr(extensions, name) != NULL;
+}
+
+// Helper function to set the filters of the bound texture
+static void setFilter(int levelCount)
+{
+    int mipmapped = textureFilter != TEXTURE_FILTER_LINEAR && levelCount > 1;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+
+    if (maxAnisotropy > 0.0f)
+    {
+        float anisotropy = 1.0f;
+        if (textureFilter == TEXTURE_FILTER_ANISOTROPIC)
+            anisotropy = TEXTURE_ANISOTROPY < maxAnisotropy ? TEXTURE_ANISOTROPY : maxAnisotropy;
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
+    }
+}
+
+// Helper function to add up the memory the driver gave the bound texture
+static size_t measureTexture(int levelCount, int *compressedOut)
+{
+    size_t bytes = 0;
+    int compressed = 0;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+
+    for (int level = 0; level < levelCount; level++)
+    {
+        int width = 0, height = 0;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+
+        if (compressed)
+        {
+            int size = 0;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+            bytes += size;
+        }
+        else
+        {
+            // Drivers usually keep RGB with a spare byte per texel
+            int bits[4] = {0, 0, 0, 0};
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_RED_SIZE, &bits[0]);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_GREEN_SIZE, &bits[1]);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_BLUE_SIZE, &bits[2]);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_ALPHA_SIZE, &bits[3]);
+            int texelBytes = (bits[0] + bits[1] + bits[2] + bits[3] + 7) / 8;
+            if (texelBytes == 3)
+                texelBytes = 4;
+            bytes += (size_t)width * height * texelBytes;
+        }
+    }
+
+    *compressedOut = compressed;
+    return bytes;
+}
+
+// Helper function to create a GL texture from a packed RGB mipmap chain and record it in its source
+static void uploadTexture(int sourceIndex, int width, int height, int levelCount, const unsigned char *chain)
+{
+    TextureSource *source = &sources[sourceIndex];
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    // Every level, smallest last
+    int internalFormat = textureCompression ? GL_COMPRESSED_RGB : GL_RGB;
+    const unsigned char *level = chain;
+    int levelWidth = width, levelHeight = height;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < levelCount; i++)
+    {
+        glTexImage2D(GL_TEXTURE_2D, i, internalFormat, levelWidth, levelHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, level);
+        level += (size_t)3 * levelWidth * levelHeight;
+        levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+        levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (glGetError())
+        Fatal("Error in glTexImage2D %s %dx%d\n", source->file ? source->file : "furniture atlas", width, height);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    setFilter(levelCount);
+    boundTexture = BINDING_UNKNOWN;
+
+    // Remember it for filter changes, the memory report and the budget
+    source->texture = texture;
+    source->width = width;
+    source->height = height;
+    source->levelCount = levelCount;
+    source->bytes = measureTexture(levelCount, &source->compressed);
+    source->lastUsed = frameNumber;
+}
+
+// Helper function to add a texture the program may load later
+static int newSource(const char *file)
+{
+    if (sourceCount == sourceCapacity)
+    {
+        int newCapacity = sourceCapacity ? sourceCapacity * 2 : 32;
+        TextureSource *grown = (TextureSource *)realloc(sources, newCapacity * sizeof(TextureSource));
+        if (!grown)
+            Fatal("Cannot allocate memory for textures\n");
+        sources = grown;
+        sourceCapacity = newCapacity;
+    }
+
+    TextureSource *source = &sources[sourceCount];
+    memset(source, 0, sizeof(TextureSource));
+    source->file = file;
+    return sourceCount++;
+}
+
+// Helper function to hand out a handle for the draw code
+static unsigned int newHandle(const char *file, int source, int atlasSlot)
+{
+    if (handleCount == handleCapacity)
+    {
+        int newCapacity = handleCapacity ? handleCapacity * 2 : 32;
+        TextureHandle *grown = (TextureHandle *)realloc(handles, newCapacity * sizeof(TextureHandle));
+        if (!grown)
+            Fatal("Cannot allocate memory for texture handles\n");
+        handles = grown;
+        handleCapacity = newCapacity;
+    }
+
+    TextureHandle *handle = &handles[handleCount++];
+    handle->file = file;
+    handle->source = source;
+    handle->atlasSlot = atlasSlot;
+    handle->offsetU = handle->offsetV = 0.0f;
+    handle->scaleU = handle->scaleV = 1.0f;
+    return handleCount;
+}
+
+// Helper function to delete a loaded texture; the next bind loads it again
+static void unloadSource(int sourceIndex)
+{
+    TextureSource *source = &sources[sourceIndex];
+    unsigned int idle = frameNumber - source->lastUsed;
+    printf("  unloaded %s (%.1f MB, last drawn %u frame%s ago)\n", source->file ? source->file : "furniture atlas",
+           source->bytes / (1024.0 * 1024.0), idle, idle == 1 ? "" : "s");
+    glDeleteTextures(1, &source->texture);
+    source->texture = 0;
+    source->bytes = 0;
+    boundTexture = BINDING_UNKNOWN;
+    unloadCount++;
+}
+
+// Helper function to unload the least recently drawn textures until the rest fit the budget
+// Only textures last drawn before frame keepSince go, so a frame that needs more than the
+// budget still draws
+static void applyBudget(unsigned int keepSince)
+{
+    if (textureBudgetMB <= 0)
+        return;
+
+    size_t budget = (size_t)textureBudgetMB * 1024 * 1024;
+    while (texture_memory_bytes() > budget)
+    {
+        int oldest = -1;
+        for (int i = 0; i < sourceCount; i++)
+        {
+            if (sources[i].texture && sources[i].lastUsed < keepSince &&
+                (oldest < 0 || sources[i].lastUsed < sources[oldest].lastUsed))
+                oldest = i;
+        }
+        if (oldest < 0)
+            return;
+        unloadSource(oldest);
+    }
+}
+
+static void loadSources(const int *list, int listCount);
+
+// Binds a texture handle on the active texture unit (0 unbinds)
+// A texture that isn't loaded yet, or was unloaded, is loaded here first.
+// Atlas tiles bind the shared atlas once and then only change the texture matrix, which
+// maps the part's 0-1 texture coordinates onto its tile. Expects the modelview matrix mode
+void texture_bind(unsigned int handle)
+{
+    const TextureHandle *entry = (handle > 0 && handle <= (unsigned int)handleCount) ? &handles[handle - 1] : NULL;
+    unsigned int glTexture = 0;
+    if (entry)
+    {
+        if (!sources[entry->source].texture)
+            loadSources(&entry->source, 1);
+        // Loading may move a tile that doesn't fit the atlas to a texture of its own
+        sources[entry->source].lastUsed = frameNumber;
+        glTexture = sources[entry->source].texture;
+    }
+    int slot = entry ? entry->atlasSlot : -1;
+
+    if (glTexture != boundTexture)
+    {
+        glBindTexture(GL_TEXTURE_2D, glTexture);
+        boundTexture = glTexture;
+        bindCount++;
+    }
+
+    if (slot != boundSlot)
+    {
+        glMatrixMode(GL_TEXTURE);
+        glLoadIdentity();
+        if (slot >= 0)
+        {
+            glTranslatef(entry->offsetU, entry->offsetV, 0.0f);
+            glScalef(entry->scaleU, entry->scaleV, 1.0f);
+        }
+        glMatrixMode(GL_MODELVIEW);
+        boundSlot = slot;
+    }
+}
+
+// Returns the number of real texture binds since the last call
+int texture_take_bind_count(void)
+{
+    int count = bindCount;
+    bindCount = 0;
+    return count;
+}
+
+// Marks the end of a frame: unloads textures this frame didn't draw if the budget is exceeded,
+// and counts later binds as the next frame
+void texture_end_frame(void)
+{
+    applyBudget(frameNumber);
+    frameNumber++;
+}
+
+// Total GPU memory of the loaded textures in bytes
+size_t texture_memory_bytes(void)
+{
+    size_t bytes = 0;
+    for (int i = 0; i < sourceCount; i++)
+        bytes += sources[i].bytes;
+    return bytes;
+}
+
+// Number of textures loaded right now; total gets the number that could be
+int texture_loaded_count(int *total)
+{
+    int loaded = 0;
+    for (int i = 0; i < sourceCount; i++)
+        loaded += sources[i].texture != 0;
+    if (total)
+        *total = sourceCount;
+    return loaded;
+}
+
+// Name of the current filter for messages
+const char *texture_filter_name(void)
+{
+    switch (textureFilter)
+    {
+    case TEXTURE_FILTER_LINEAR:
+        return "bilinear, no mipmaps";
+    case TEXTURE_FILTER_TRILINEAR:
+        return "trilinear mipmaps";
+    default:
+        return "trilinear + anisotropic";
+    }
+}
+
+// Texels read for one screen pixel with the current filter (at most, for anisotropic)
+int texture_samples_per_pixel(void)
+{
+    switch (textureFilter)
+    {
+    case TEXTURE_FILTER_LINEAR:
+        return 4;
+    case TEXTURE_FILTER_TRILINEAR:
+        return 8;
+    default:
+        return 8 * (int)(TEXTURE_ANISOTROPY < maxAnisotropy ? TEXTURE_ANISOTROPY : maxAnisotropy);
+    }
+}
+
+// Switches to the next filter and applies it to every loaded texture
+// Anisotropic filtering is skipped when the driver doesn't have it
+void texture_cycle_filter(void)
+{
+    textureFilter = (TextureFilter)((textureFilter + 1) % TEXTURE_FILTER_COUNT);
+    if (textureFilter == TEXTURE_FILTER_ANISOTROPIC && maxAnisotropy <= 0.0f)
+        textureFilter = TEXTURE_FILTER_LINEAR;
+
+    for (int i = 0; i < sourceCount; i++)
+    {
+        if (!sources[i].texture)
+            continue;
+        glBindTexture(GL_TEXTURE_2D, sources[i].texture);
+        setFilter(sources[i].levelCount);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    boundTexture = BINDING_UNKNOWN;
+
+    printf("Texture filter: %s\n", texture_filter_name());
+}
+
+// Prints how much memory the textures use
+void texture_print_report(void)
+{
+    int compressedCount = 0;
+    size_t plainBytes = 0;
+    for (int i = 0; i < sourceCount; i++)
+    {
+        if (!sources[i].texture)
+            continue;
+        compressedCount += sources[i].compressed;
+        plainBytes += (size_t)4 * sources[i].width * sources[i].height;
+    }
+
+    int total = 0;
+    int loaded = texture_loaded_count(&total);
+    printf("Texture memory: %.1f MB for %d of %d textures with mipmaps (%d compressed; %.1f MB without mipmaps or compression)\n",
+           texture_memory_bytes() / (1024.0 * 1024.0), loaded, total, compressedCount, plainBytes / (1024.0 * 1024.0));
+    if (textureBudgetMB > 0)
+        printf("Texture budget: %d MB, %d textures unloaded to stay inside it\n", textureBudgetMB, unloadCount);
+    else
+        printf("Texture budget: none\n");
+    printf("Texture filter: %s, up to %d texel reads per pixel\n", texture_filter_name(), texture_samples_per_pixel());
+}
+
+// Packs same sized, power of two textures into the atlas texture, a grid of tiles
+// Each level of the atlas is made from the same level of every tile, so no mipmaps are rebuilt
+// Returns 0 on success, -1 if the atlas would be too big (the textures are then loaded on their own)
+static int buildAtlas(TextureJob **members, int memberCount)
+{
+    int tile = members[0]->width;
+    int columns = 1;
+    while (columns * columns < atlasSlotCount)
+        columns++;
+    int rows = (atlasSlotCount + columns - 1) / columns;
+    if (columns * tile > maxTextureSize || rows * tile > maxTextureSize)
+        return -1;
+
+    int levelCount = 1;
+    while ((tile >> levelCount) >= ATLAS_MIN_TILE)
+        levelCount++;
+
+    size_t atlasSize = 0;
+    for (int level = 0; level < levelCount; level++)
+        atlasSize += (size_t)3 * (columns * tile >> level) * (rows * tile >> level);
+    unsigned char *atlas = (unsigned char *)calloc(1, atlasSize);
+    if (!atlas)
+        return -1;
+
+    // Copy every tile's levels into place
+    unsigned char *atlasLevel = atlas;
+    size_t tileOffset = 0; // start of this level inside each tile's own chain
+    for (int level = 0; level < levelCount; level++)
+    {
+        int levelTile = tile >> level;
+        int atlasWidth = columns * levelTile;
+        for (int i = 0; i < memberCount; i++)
+        {
+            int slot = handles[members[i]->handle].atlasSlot;
+            const unsigned char *source = members[i]->levels + tileOffset;
+            int x = (slot % columns) * levelTile;
+            int y = (slot / columns) * levelTile;
+            for (int row = 0; row < levelTile; row++)
+                memcpy(atlasLevel + (size_t)3 * ((y + row) * atlasWidth + x),
+                       source + (size_t)3 * row * levelTile, (size_t)3 * levelTile);
+        }
+        atlasLevel += (size_t)3 * atlasWidth * (rows * levelTile);
+        tileOffset += (size_t)3 * levelTile * levelTile;
+    }
+
+    uploadTexture(atlasSource, columns * tile, rows * tile, levelCount, atlas);
+    free(atlas);
+
+    // Each tile's texture matrix keeps half a texel of the smallest level away from its neighbours
+    float inset = 0.5f / (tile >> (levelCount - 1));
+    for (int i = 0; i < memberCount; i++)
+    {
+        TextureHandle *entry = &handles[members[i]->handle];
+        entry->scaleU = (1.0f - 2.0f * inset) / columns;
+        entry->scaleV = (1.0f - 2.0f * inset) / rows;
+        entry->offsetU = (entry->atlasSlot % columns + inset) / columns;
+        entry->offsetV = (entry->atlasSlot / columns + inset) / rows;
+    }
+
+    printf("  furniture atlas: %d textures in %dx%d tiles (%dx%d)\n", memberCount, columns, rows,
+           columns * tile, rows * tile);
+    return 0;
+}
+
+// Helper function to take a tile out of the atlas; it gets a texture of its own from now on
+static void leaveAtlas(TextureHandle *handle)
+{
+    handle->source = newSource(handle->file);
+    handle->atlasSlot = -1;
+    handle->offsetU = handle->offsetV = 0.0f;
+    handle->scaleU = handle->scaleV = 1.0f;
+}
+
+// Helper function to upload one finished job as the texture of its handle's source
+static double uploadJob(TextureJob *job)
+{
+    double uploadStart = timer_now_ms();
+    uploadTexture(handles[job->handle].source, job->width, job->height,
+                  texture_mip_count(job->width, job->height), job->levels);
+    return timer_now_ms() - uploadStart;
+}
+
+// Loads a list of textures: their files are read and converted on worker threads while
+// this thread uploads each one as soon as it is ready. Files that are up to date in the
+// baked texture cache come from there instead. The atlas is built once all its tiles are here.
+// Stops the program with Fatal if a file can't be loaded, like LoadTexBMP
+static void loadSources(const int *list, int listCount)
+{
+    double startTime = timer_now_ms();
+
+    // One job per file: a texture's own BMP, or every tile of the atlas
+    int count = 0;
+    for (int h = 0; h < handleCount; h++)
+    {
+        for (int l = 0; l < listCount; l++)
+            count += handles[h].source == list[l];
+    }
+    if (count == 0)
+        return;
+
+    jobs = (TextureJob *)calloc(count, sizeof(TextureJob));
+    doneOrder = (int *)malloc(count * sizeof(int));
+    TextureJob **atlasMembers = (TextureJob **)malloc(count * sizeof(TextureJob *));
+    if (!jobs || !doneOrder || !atlasMembers)
+        Fatal("Cannot allocate memory for %d textures\n", count);
+
+    jobCount = 0;
+    for (int h = 0; h < handleCount; h++)
+    {
+        for (int l = 0; l < listCount; l++)
+        {
+            if (handles[h].source != list[l])
+                continue;
+            jobs[jobCount].file = handles[h].file;
+            jobs[jobCount].handle = h;
+            jobCount++;
+        }
+    }
+    nextJob = 0;
+    doneCount = 0;
+
+    // Start the decode threads (a single file is decoded here)
+    pthread_t threads[TEXTURE_DECODE_THREADS];
+    int threadCount = 0;
+    while (count > 1 && threadCount < TEXTURE_DECODE_THREADS && threadCount < count &&
+           pthread_create(&threads[threadCount], NULL, decodeMain, NULL) == 0)
+        threadCount++;
+
+    if (threadCount == 0)
+        decodeMain(NULL);
+
+    // Upload in the order the decodes finish; atlas tiles wait until they are all here
+    int atlasCount = 0;
+    double uploadTotal = 0.0;
+    int cachedCount = 0;
+    for (int finished = 0; finished < count; finished++)
+    {
+        pthread_mutex_lock(&jobMutex);
+        while (doneCount == finished)
+            pthread_cond_wait(&doneCondition, &jobMutex);
+        TextureJob *job = &jobs[doneOrder[finished]];
+        pthread_mutex_unlock(&jobMutex);
+
+        if (job->error[0])
+            Fatal("%s\n", job->error);
+
+        job->width = job->fromCache ? job->cached.width : job->image.width;
+        job->height = job->fromCache ? job->cached.height : job->image.height;
+        job->levels = job->fromCache ? job->cached.levels : job->chain;
+        if (job->fromCache)
+            cachedCount++;
+
+        // Tiles must be square, a power of two, and the size of the first tile
+        TextureHandle *handle = &handles[job->handle];
+        if (handle->atlasSlot >= 0)
+        {
+            int tile = atlasCount > 0 ? atlasMembers[0]->width : job->width;
+            if (job->width == job->height && job->width == tile && (tile & (tile - 1)) == 0)
+            {
+                atlasMembers[atlasCount++] = job;
+                printf("  %-32s %dx%d  %s %6.2f ms  (atlas)\n", job->file, job->width, job->height,
+                       job->fromCache ? "cache " : "decode", job->decodeMs);
+                continue;
+            }
+            leaveAtlas(handle);
+        }
+
+        double uploadMs = uploadJob(job);
+        uploadTotal += uploadMs;
+        printf("  %-32s %dx%d  %s %6.2f ms  upload %6.2f ms\n", job->file, job->width, job->height,
+               job->fromCache ? "cache " : "decode", job->decodeMs, uploadMs);
+
+        texture_free_image(&job->image);
+        free(job->chain);
+        job->chain = NULL;
+    }
+
+    // One texture for all the furniture, or each on its own if that doesn't fit
+    if (atlasCount > 0)
+    {
+        double uploadStart = timer_now_ms();
+        if (buildAtlas(atlasMembers, atlasCount) != 0)
+        {
+            printf("  furniture atlas too large, loading its textures separately\n");
+            for (int i = 0; i < atlasCount; i++)
+            {
+                leaveAtlas(&handles[atlasMembers[i]->handle]);
+                uploadJob(atlasMembers[i]);
+            }
+        }
+        uploadTotal += timer_now_ms() - uploadStart;
+
+        for (int i = 0; i < atlasCount; i++)
+        {
+            texture_free_image(&atlasMembers[i]->image);
+            free(atlasMembers[i]->chain);
+            atlasMembers[i]->chain = NULL;
+        }
+    }
+    free(atlasMembers);
+
+    for (int i = 0; i < threadCount; i++)
+        pthread_join(threads[i], NULL);
+
+    if (count > 1)
+        printf("Loaded %d textures in %.1f ms (%d decode thread%s, %.1f ms uploading, %d from cache)\n",
+               count, timer_now_ms() - startTime, threadCount, threadCount == 1 ? "" : "s",
+               uploadTotal, cachedCount);
+    if (cacheEntries >= 0 && cachedCount < count && !cacheWarned)
+    {
+        printf("Texture cache %s is out of date, run ./final --bake-textures\n", TEXTURE_CACHE_FILE);
+        cacheWarned = 1;
+    }
+
+    free(jobs);
+    free(doneOrder);
+    jobs = NULL;
+    doneOrder = NULL;
+    jobCount = 0;
+
+    // Textures the last frame drew are likely needed again in this one; end of frame trims the rest
+    applyBudget(frameNumber > 0 ? frameNumber - 1 : 0);
+}
+
+// Registers a list of BMP textures and fills in a handle for each request. Only requests marked
+// preload are loaded now (on the decode threads); the rest load the first time they are bound,
+// so memory and startup time follow what is drawn rather than the whole catalog.
+// Requests naming the same file share a handle; atlas requests are tiles of one shared texture
+void texture_register_batch(const TextureRequest *requests, int count)
+{
+    if (count <= 0)
+        return;
+
+    ErrCheck("texture_register_batch");
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    if (hasExtension("GL_EXT_texture_filter_anisotropic") || hasExtension("GL_ARB_texture_filter_anisotropic"))
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+
+    // The cache stays mapped for textures loaded later
+    if (cacheEntries < 0)
+        cacheEntries = texture_cache_open(TEXTURE_CACHE_FILE);
+
+    int *preload = (int *)malloc(count * sizeof(int));
+    if (!preload)
+        Fatal("Cannot allocate memory for %d textures\n", count);
+    int preloadCount = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        unsigned int handle = 0;
+        for (int h = 0; h < handleCount && !handle; h++)
+        {
+            if (strcmp(handles[h].file, requests[i].file) == 0)
+                handle = h + 1;
+        }
+
+        if (!handle && requests[i].atlas)
+        {
+            // New tiles change the grid, so a loaded atlas is rebuilt on its next bind
+            if (atlasSource < 0)
+                atlasSource = newSource(NULL);
+            else if (sources[atlasSource].texture)
+                unloadSource(atlasSource);
+            handle = newHandle(requests[i].file, atlasSource, atlasSlotCount++);
+        }
+        else if (!handle)
+        {
+            handle = newHandle(requests[i].file, newSource(requests[i].file), -1);
+        }
+        *requests[i].texture = handle;
+
+        // Each source is loaded once, however many requests share it
+        int source = handles[handle - 1].source;
+        int listed = 0;
+        for (int j = 0; j < preloadCount && !listed; j++)
+            listed = preload[j] == source;
+        if (requests[i].preload && !listed && !sources[source].texture)
+            preload[preloadCount++] = source;
+    }
+
+    loadSources(preload, preloadCount);
+    free(preload);
+
+    texture_print_report();
+}
@@ -0,0 +1,629 @@
+#include "CSCIx229.h"
+#include <time.h>
+
+// Prints the command line tools
+static void printUsage(const char *program)
+{
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, "  %s                          run the visualizer\n", program);
+    fprintf(stderr, "  %s --compress-textures      run it with compressed textures\n", program);
+    fprintf(stderr, "  %s --texture-budget MB      run it keeping at most MB of textures loaded (0 = no limit)\n", program);
+    fprintf(stderr, "  %s --convert IN OUT         convert a layout between .csv and .ehl\n", program);
+    fprintf(stderr, "  %s --library-list LIB       list the layouts in a library\n", program);
+    fprintf(stderr, "  %s --library-add LIB NAME IN   add a layout file to a library\n", program);
+    fprintf(stderr, "  %s --library-get LIB NAME OUT  write a library layout to a file\n", program);
+    fprintf(stderr, "  %s --diff A B               list what changed from layout A to layout B\n", program);
+    fprintf(stderr, "  %s --merge BASE OURS THEIRS OUT   merge two edited copies of BASE\n", program);
+    fprintf(stderr, "  %s --bake-textures [CACHE]   pack the textures into a cache (default %s)\n", program, TEXTURE_CACHE_FILE);
+    fprintf(stderr, "  %s --bake-lightmaps [FILE]   bake the room's lighting (default %s)\n", program, LIGHTMAP_FILE);
+    fprintf(stderr, "  %s --render [--size WxH] [--views LIST] [--light 0|1|2] [--out DIR] LAYOUT...\n", program);
+    fprintf(stderr, "      draw each layout into BMP files without a window (views: perspective,fpv,orthogonal)\n");
+    fprintf(stderr, "  %s --bench [--layout FILE | --synthetic N] [--frames N] [--size WxH] [--out FILE]\n", program);
+    fprintf(stderr, "      time a camera path through every view offscreen and write the results as JSON\n");
+    fprintf(stderr, "  %s --selftest [LAYOUT...]   check the CSV number parser and journal recovery\n", program);
+}
+
+// Reads a whole layout file into a list
+// Returns 0 on success
+static int readLayout(const char *filename, LayoutRecordList *list)
+{
+    if (layout_read(filename, layout_collect_record, list) < 0)
+    {
+        fprintf(stderr, "Cannot read layout %s\n", filename);
+        return -1;
+    }
+    return 0;
+}
+
+// Prints the differences between two layouts
+static int diffLayouts(const char *fileA, const char *fileB)
+{
+    LayoutRecordList a = {NULL, 0, 0};
+    LayoutRecordList b = {NULL, 0, 0};
+    if (readLayout(fileA, &a) != 0 || readLayout(fileB, &b) != 0)
+    {
+        free(a.records);
+        free(b.records);
+        return 1;
+    }
+
+    double startTime = timer_now_ms();
+    LayoutDiffEntry *entries = NULL;
+    int entryCount = layout_diff(a.records, a.count, b.records, b.count, &entries);
+    double elapsed = timer_now_ms() - startTime;
+
+    int counts[5] = {0};
+    for (int i = 0; i < entryCount; i++)
+    {
+        const LayoutDiffEntry *entry = &entries[i];
+
+        if (entry->flags & DIFF_ADDED)
+        {
+            const LayoutRecord *added = &b.records[entry->indexB];
+            printf("+ %s at (%.2f, %.2f)\n", entry->name, added->x, added->z);
+            counts[0]++;
+            continue;
+        }
+        if (entry->flags & DIFF_REMOVED)
+        {
+            printf("- %s\n", entry->name);
+            counts[1]++;
+            continue;
+        }
+
+        const LayoutRecord *before = &a.records[entry->indexA];
+        const LayoutRecord *after = &b.records[entry->indexB];
+        if (entry->flags & DIFF_MOVED)
+        {
+            printf("~ %s moved (%.2f, %.2f) -> (%.2f, %.2f)\n", entry->name, before->x, before->z, after->x, after->z);
+            counts[2]++;
+        }
+        if (entry->flags & DIFF_ROTATED)
+        {
+            printf("~ %s rotated %.1f -> %.1f\n", entry->name, before->rotation, after->rotation);
+            counts[3]++;
+        }
+        if (entry->flags & DIFF_SCALED)
+        {
+            printf("~ %s scaled %.2f -> %.2f\n", entry->name, before->scale, after->scale);
+            counts[4]++;
+        }
+    }
+
+    printf("%d added, %d removed, %d moved, %d rotated, %d scaled (%d vs %d objects, %.2f ms)\n",
+           counts[0], counts[1], counts[2], counts[3], counts[4], a.count, b.count, elapsed);
+
+    free(entries);
+    free(a.records);
+    free(b.records);
+    return entryCount < 0 ? 1 : 0;
+}
+
+// Merges two edited copies of a layout, then checks the result for overlapping furniture
+// Returns 0 for a clean merge, 1 if there were conflicts or overlaps (the result is written anyway)
+static int mergeRecords(const LayoutRecordList *base, const LayoutRecordList *ours, const LayoutRecordList *theirs,
+                        const char *outputFile)
+{
+    static const char *conflictText[] = {
+        [MERGE_BOTH_CHANGED] = "changed on both sides, kept ours",
+        [MERGE_CHANGED_AND_REMOVED] = "changed on one side and removed on the other, kept",
+        [MERGE_BOTH_ADDED] = "added on both sides in different places, kept both; theirs is now"};
+
+    LayoutRecordList merged = {NULL, 0, 0};
+    LayoutMergeConflict *conflicts = NULL;
+
+    double startTime = timer_now_ms();
+    int conflictCount = layout_merge(base->records, base->count, ours->records, ours->count,
+                                     theirs->records, theirs->count, &merged, &conflicts);
+    double elapsed = timer_now_ms() - startTime;
+    if (conflictCount < 0)
+    {
+        fprintf(stderr, "Out of memory while merging\n");
+        free(merged.records);
+        return 1;
+    }
+
+    for (int i = 0; i < conflictCount; i++)
+        printf("! %s: %s%s%s\n", conflicts[i].name, conflictText[conflicts[i].type],
+               conflicts[i].renamed[0] ? " " : "", conflicts[i].renamed);
+    free(conflicts);
+
+    if (layout_write(outputFile, merged.records, merged.count) != 0)
+    {
+        fprintf(stderr, "Cannot write layout %s\n", outputFile);
+        free(merged.records);
+        return 1;
+    }
+    printf("Merged %d objects into %s with %d conflicts (%.2f ms)\n", merged.count, outputFile, conflictCount, elapsed);
+
+    // Put the result in the hall to catch furniture the two sides moved into each other
+    scene_init_objects();
+    int firstLoaded = scene_begin_load();
+    for (int i = 0; i < merged.count; i++)
+        if (!scene_restore_record(&merged.records[i], (void *)outputFile))
+            break;
+    int overlapCount = scene_check_overlaps(firstLoaded);
+    if (overlapCount > 0)
+        printf("Warning: %d overlapping pairs in the merged layout\n", overlapCount);
+
+    free(merged.records);
+    return (conflictCount > 0 || overlapCount > 0) ? 1 : 0;
+}
+
+// Reads the three layouts of a merge and merges them
+static int mergeLayouts(const char *baseFile, const char *oursFile, const char *theirsFile, const char *outputFile)
+{
+    LayoutRecordList base = {NULL, 0, 0};
+    LayoutRecordList ours = {NULL, 0, 0};
+    LayoutRecordList theirs = {NULL, 0, 0};
+    int result = 1;
+
+    if (readLayout(baseFile, &base) == 0 && readLayout(oursFile, &ours) == 0 && readLayout(theirsFile, &theirs) == 0)
+        result = mergeRecords(&base, &ours, &theirs, outputFile);
+
+    free(base.records);
+    free(ours.records);
+    free(theirs.records);
+    return result;
+}
+
+// Prints the index of a layout library
+static int libraryList(const char *archiveFile)
+{
+    LibraryEntry *entries = NULL;
+    int entryCount = library_read_index(archiveFile, &entries);
+    if (entryCount < 0)
+    {
+        fprintf(stderr, "Cannot read library %s\n", archiveFile);
+        return 1;
+    }
+
+    for (int i = 0; i < entryCount; i++)
+    {
+        char savedText[32];
+        time_t savedTime = (time_t)entries[i].savedTime;
+        strftime(savedText, sizeof(savedText), "%Y-%m-%d %H:%M:%S", localtime(&savedTime));
+        printf("%-32s %s %5u objects ", entries[i].name, savedText, entries[i].objectCount);
+
+        for (int type = 0; type < SPAWN_TYPE_COUNT; type++)
+            if (entries[i].typeCounts[type] > 0)
+                printf(" %s:%u", scene_spawn_type_name((SceneSpawnType)type), entries[i].typeCounts[type]);
+        printf("\n");
+    }
+
+    free(entries);
+    return 0;
+}
+
+// Adds a layout file to a library
+static int libraryAdd(const char *archiveFile, const char *name, const char *inputFile)
+{
+    LayoutRecordList list = {NULL, 0, 0};
+    if (layout_read(inputFile, layout_collect_record, &list) < 0)
+    {
+        fprintf(stderr, "Cannot read layout %s\n", inputFile);
+        free(list.records);
+        return 1;
+    }
+
+    int result = library_add(archiveFile, name, list.records, list.count);
+    if (result != 0)
+        fprintf(stderr, "Cannot add to library %s\n", archiveFile);
+    else
+        printf("Added \"%s\" (%d objects) to %s\n", name, list.count, archiveFile);
+
+    free(list.records);
+    return result == 0 ? 0 : 1;
+}
+
+// Writes one library entry out as a normal layout file
+static int libraryGet(const char *archiveFile, const char *name, const char *outputFile)
+{
+    LibraryEntry *entries = NULL;
+    int entryCount = library_read_index(archiveFile, &entries);
+    if (entryCount < 0)
+    {
+        fprintf(stderr, "Cannot read library %s\n", archiveFile);
+        return 1;
+    }
+
+    int result = 1;
+    for (int i = 0; i < entryCount; i++)
+    {
+        if (strcmp(entries[i].name, name) != 0)
+            continue;
+
+        LayoutRecordList list = {NULL, 0, 0};
+        if (library_load_entry(archiveFile, &entries[i], layout_collect_record, &list) >= 0 &&
+            layout_write(outputFile, list.records, list.count) == 0)
+        {
+            printf("Wrote \"%s\" (%d objects) to %s\n", name, list.count, outputFile);
+            result = 0;
+        }
+        free(list.records);
+        break;
+    }
+
+    if (result != 0)
+        fprintf(stderr, "Cannot get \"%s\" from %s\n", name, archiveFile);
+    free(entries);
+    return result;
+}
+
+// Bakes the scene's textures into the texture cache
+static int bakeTextures(const char *cacheFile)
+{
+    int textureCount = 0;
+    const TextureRequest *textures = scene_texture_list(&textureCount);
+
+    const char **files = (const char **)malloc(textureCount * sizeof(const char *));
+    if (!files)
+        return 1;
+    for (int i = 0; i < textureCount; i++)
+        files[i] = textures[i].file;
+
+    double startTime = timer_now_ms();
+    int result = texture_cache_bake(cacheFile, files, textureCount);
+    if (result == 0)
+        printf("Took %.1f ms\n", timer_now_ms() - startTime);
+
+    free(files);
+    return result == 0 ? 0 : 1;
+}
+
+// Helper function to turn a view list ("perspective,orthogonal") into a bit per ViewPreset
+// Returns 0 if a name isn't known
+static unsigned int parseViews(const char *list)
+{
+    unsigned int views = 0;
+    char names[128];
+    snprintf(names, sizeof(names), "%s", list);
+    for (char *name = strtok(names, ","); name; name = strtok(NULL, ","))
+    {
+        int view = 0;
+        while (view < VIEW_COUNT && strcmp(name, view_preset_name((ViewPreset)view)) != 0)
+            view++;
+        if (view == VIEW_COUNT)
+            return 0;
+        views |= 1u << view;
+    }
+    return views;
+}
+
+// Draws every view of every layout into DIR/<layout>-<view>.bmp, loading the scene only once
+static int renderLayouts(int argc, char *argv[])
+{
+    int width = 1280, height = 720;
+    unsigned int views = (1u << VIEW_COUNT) - 1;
+    int light = lightState;
+    const char *outputDir = ".";
+
+    int first = 2;
+    for (; first < argc && strncmp(argv[first], "--", 2) == 0; first++)
+    {
+        if (strcmp(argv[first], "--size") == 0 && first + 1 < argc &&
+            sscanf(argv[first + 1], "%dx%d", &width, &height) == 2 && width > 0 && height > 0)
+            first++;
+        else if (strcmp(argv[first], "--views") == 0 && first + 1 < argc && (views = parseViews(argv[first + 1])))
+            first++;
+        else if (strcmp(argv[first], "--light") == 0 && first + 1 < argc)
+            light = atoi(argv[++first]);
+        else if (strcmp(argv[first], "--out") == 0 && first + 1 < argc)
+            outputDir = argv[++first];
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (first == argc)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    double startTime = timer_now_ms();
+    if (offscreen_open(width, height) != 0)
+        return 1;
+    lightState = light;
+
+    int imageCount = 0, failures = 0;
+    for (int i = first; i < argc; i++)
+    {
+        if (load_scene(argv[i]) != 0)
+        {
+            failures++;
+            continue;
+        }
+
+        // Images are named after the layout file, without its folder and extension
+        const char *slash = strrchr(argv[i], '/');
+        char name[256];
+        snprintf(name, sizeof(name), "%s", slash ? slash + 1 : argv[i]);
+        char *extension = strrchr(name, '.');
+        if (extension)
+            *extension = '\0';
+
+        for (int view = 0; view < VIEW_COUNT; view++)
+        {
+            if (!(views & (1u << view)))
+                continue;
+            char file[512];
+            snprintf(file, sizeof(file), "%s/%s-%s.bmp", outputDir, name, view_preset_name((ViewPreset)view));
+            view_preset_apply((ViewPreset)view);
+            if (offscreen_write_bmp(file) != 0)
+                failures++;
+            else
+                imageCount++;
+        }
+    }
+    offscreen_close();
+
+    printf("Rendered %d image%s (%dx%d) in %.0f ms\n", imageCount, imageCount == 1 ? "" : "s",
+           width, height, timer_now_ms() - startTime);
+    return failures == 0 ? 0 : 1;
+}
+
+// Runs the render benchmark on a layout, or on a synthetic hall of N chairs and tables
+static int runBench(int argc, char *argv[])
+{
+    const char *layout = NULL;
+    int syntheticCount = 0;
+    int frameCount = 600;
+    int width = 1280, height = 720;
+    const char *outputFile = "bench.json";
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--layout") == 0 && i + 1 < argc)
+            layout = argv[++i];
+        else if (strcmp(argv[i], "--synthetic") == 0 && i + 1 < argc)
+            syntheticCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frameCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc &&
+                 sscanf(argv[i + 1], "%dx%d", &width, &height) == 2 && width > 0 && height > 0)
+            i++;
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            outputFile = argv[++i];
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (offscreen_open(width, height) != 0)
+        return 1;
+    int result = bench_run(layout, syntheticCount, frameCount, outputFile);
+    offscreen_close();
+    return result;
+}
+
+// Helper function to check that csv_parse_float gives exactly the float sscanf("%f") does
+// Returns 1 if they match
+static int sameAsScanf(const char *text)
+{
+    float parsed = 0.0f, scanned = 0.0f;
+    if (!csv_parse_float(text, &parsed) || sscanf(text, "%f", &scanned) != 1)
+    {
+        printf("  \"%s\": not read as a number\n", text);
+        return 0;
+    }
+
+    unsigned int parsedBits, scannedBits;
+    memcpy(&parsedBits, &parsed, sizeof(parsedBits));
+    memcpy(&scannedBits, &scanned, sizeof(scannedBits));
+    if (parsedBits != scannedBits)
+    {
+        printf("  \"%s\": parsed %.9g (0x%08x), sscanf %.9g (0x%08x)\n", text, parsed, parsedBits, scanned, scannedBits);
+        return 0;
+    }
+    return 1;
+}
+
+// Checks csv_parse_float against sscanf bit for bit: awkward numbers, every value the layout
+// writer produces between -360 and 360, and the numbers in the given layout files
+// Returns the number of mismatches
+static int checkParser(int argc, char *argv[])
+{
+    static const char *edgeCases[] = {
+        "0", "-0", "+0", "0.0000", "-0.0000", "1", "-1", "0.1", "0.2", "0.3", "1.5", "-12.5000",
+        "3e-2", "3E+2", "1e0", "1e-0", " 2.5", "2.5 ", "\t-7.25\t", ".5", "5.", "-.5",
+        "00000000000000000001", "0.000000000000000000001", "123456789", "16777216", "16777217",
+        "16777218", "33554435", "0.1000000000000000055511151231257827", "1234567890123456789012",
+        "9999999999999999999999999", "0.9999999999999999999999", "3.4028234e38", "3.4028235e38",
+        "3.4028236e38", "1e38", "1e39", "1.17549435e-38", "1.4e-45", "7e-46", "1e-50", "1e-400",
+        "1e400", "2.2250738585072014e-308", "4.9406564584124654e-324", "8.589973e9", "1.00000005",
+        "1.0000000596046448", "1.00000006", "0.30000001192092896", "7.038531e-26", "9.5e-16",
+        "1.7014118e38", "33554434.5", "83886085", "1e22", "1e23", "123.456e-10", "-999.9999"};
+
+    printf("Checking csv_parse_float against sscanf\n");
+    int failures = 0, checked = 0;
+
+    // Awkward numbers: float limits, halfway cases, long and short digit strings
+    float value;
+    int valueCount = (int)(sizeof(edgeCases) / sizeof(edgeCases[0]));
+    for (int i = 0; i < valueCount; i++)
+    {
+        failures += !sameAsScanf(edgeCases[i]);
+        checked++;
+    }
+
+    // Exactly halfway between 1 and the next float, then a hair above it far past the kept digits
+    char halfway[200];
+    snprintf(halfway, sizeof(halfway), "1.000000059604644775390625");
+    failures += !sameAsScanf(halfway);
+    snprintf(halfway, sizeof(halfway), "1.000000059604644775390625%0150d", 1);
+    failures += !sameAsScanf(halfway);
+    checked += 2;
+
+    // sscanf stops early on these, but a CSV field has to be a number all the way through
+    static const char *notNumbers[] = {"", "-", ".", "e5", "2.5e", "1e+", "1.5x", "1 2", "0x10", "nan", "inf"};
+    int notNumberCount = (int)(sizeof(notNumbers) / sizeof(notNumbers[0]));
+    for (int i = 0; i < notNumberCount; i++)
+    {
+        if (csv_parse_float(notNumbers[i], &value))
+        {
+            printf("  \"%s\": should not be a number\n", notNumbers[i]);
+            failures++;
+        }
+        checked++;
+    }
+
+    // Everything save_scene can write for a position, rotation or scale
+    char text[32];
+    for (long step = -3600000; step <= 3600000; step++)
+    {
+        snprintf(text, sizeof(text), "%.4f", step / 10000.0);
+        if (!sameAsScanf(text) && ++failures > 20)
+            break;
+        checked++;
+    }
+
+    // The numbers in real layouts
+    for (int i = 2; i < argc; i++)
+    {
+        CsvReader reader;
+        if (csv_open(&reader, argv[i]) != 0)
+        {
+            printf("  Cannot read %s\n", argv[i]);
+            failures++;
+            continue;
+        }
+        while (csv_next_record(&reader) >= 0)
+        {
+            if (strcmp(reader.fields[0], "O") != 0)
+                continue;
+            for (int field = 2; field < reader.fieldCount && field < CSV_MAX_FIELDS; field++)
+            {
+                failures += !sameAsScanf(reader.fields[field]);
+                checked++;
+            }
+        }
+        csv_close(&reader);
+    }
+
+    printf("%d numbers checked, %d mismatches\n", checked, failures);
+    return failures;
+}
+
+// Checks that a removal which starts a journal checkpoint stays removed after crash recovery
+// Returns 1 if it came back
+static int checkJournal(void)
+{
+    const char *journalFile = "selftest.journal";
+    const char *checkpointFile = "selftest_checkpoint.ehl";
+    printf("Checking that a removal survives a journal checkpoint\n");
+
+    // A fresh journal over the starting layout
+    remove(journalFile);
+    remove(checkpointFile);
+    journal_use_files(journalFile, checkpointFile);
+    scene_init_objects();
+    journal_open();
+
+    // Records 1 to 255: a spawn and moves, then the removal is record 256 and starts a checkpoint
+    SceneObject *chair = scene_spawn_at(SPAWN_BANQUET_CHAIR, 0.0f, 10.0f, 0.0f);
+    if (!chair)
+    {
+        printf("  Cannot spawn a chair\n");
+        journal_close();
+        return 1;
+    }
+    char name[32];
+    memcpy(name, chair->name, sizeof(name));
+    journal_spawn(chair);
+    for (int i = 1; i < 255; i++)
+        journal_move(chair);
+    selectedObject = chair;
+    scene_remove_selected_object();
+
+    // Recover the way the next launch would after a crash
+    scene_init_objects();
+    scene_begin_load();
+    layout_read(checkpointFile, scene_restore_record, (void *)checkpointFile);
+    journal_replay(journalFile);
+
+    int cameBack = 0;
+    for (int i = 0; i < objectCount; i++)
+        if (strcmp(objects[i].name, name) == 0)
+            cameBack = 1;
+    printf("%s %s\n", name, cameBack ? "came back after recovery" : "stayed removed");
+
+    journal_close();
+    return cameBack;
+}
+
+// Runs the self checks; returns 0 if they all pass
+static int selfTest(int argc, char *argv[])
+{
+    int failures = checkParser(argc, argv);
+    failures += checkJournal();
+    return failures == 0 ? 0 : 1;
+}
+
+// Runs a command line tool instead of the visualizer
+// Returns the exit code, or -1 if the arguments don't ask for a tool
+int tools_main(int argc, char *argv[])
+{
+    if (argc < 2 || strncmp(argv[1], "--", 2) != 0)
+        return -1;
+
+    // Layout format converter
+    if (strcmp(argv[1], "--convert") == 0)
+    {
+        if (argc != 4)
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return layout_convert(argv[2], argv[3]);
+    }
+
+    // Layout library
+    if (strcmp(argv[1], "--library-list") == 0 && argc == 3)
+        return libraryList(argv[2]);
+    if (strcmp(argv[1], "--library-add") == 0 && argc == 5)
+        return libraryAdd(argv[2], argv[3], argv[4]);
+    if (strcmp(argv[1], "--library-get") == 0 && argc == 5)
+        return libraryGet(argv[2], argv[3], argv[4]);
+
+    // Layout diff and merge
+    if (strcmp(argv[1], "--diff") == 0 && argc == 4)
+        return diffLayouts(argv[2], argv[3]);
+    if (strcmp(argv[1], "--merge") == 0 && argc == 6)
+        return mergeLayouts(argv[2], argv[3], argv[4], argv[5]);
+
+    // Texture cache
+    if (strcmp(argv[1], "--bake-textures") == 0 && argc <= 3)
+        return bakeTextures(argc == 3 ? argv[2] : TEXTURE_CACHE_FILE);
+
+    // Room lightmaps
+    if (strcmp(argv[1], "--bake-lightmaps") == 0 && argc <= 3)
+    {
+        scene_init_objects();
+        return lightmap_bake_file(argc == 3 ? argv[2] : LIGHTMAP_FILE);
+    }
+
+    // Offscreen renders of layouts
+    if (strcmp(argv[1], "--render") == 0)
+        return renderLayouts(argc, argv);
+
+    // Render benchmark
+    if (strcmp(argv[1], "--bench") == 0)
+        return runBench(argc, argv);
+
+    // Parser self test
+    if (strcmp(argv[1], "--selftest") == 0)
+        return selfTest(argc, argv);
+
+    if (strcmp(argv[1], "--help") == 0)
+    {
+        printUsage(argv[0]);
+        return 0;
+    }
+
+    // Leave anything else for GLUT
+    return -1;
+}
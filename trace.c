@@ -0,0 +1,183 @@
+#include "CSCIx229.h"
+#include <time.h>
+
+// Trace recorder: timed events written as Chrome trace JSON (chrome://tracing or ui.perfetto.dev)
+// Any thread records into a ring buffer without taking a lock: it claims a slot with an atomic
+// counter and marks the slot with its sequence number once the event is filled in. When the ring
+// is full the oldest events are overwritten, so a long recording keeps the last TRACE_CAPACITY events.
+// Two threads whose claims are TRACE_CAPACITY apart land in the same slot; the slot is locked while
+// an event is written into it, and whichever comes second (or is older) drops its event.
+#define TRACE_CAPACITY (1 << 17) // events, a power of two
+#define TRACE_SLOT_BUSY 0xffffffffu // sequence of a slot an event is being written into
+#define TRACE_ENV "EVENTHALL_TRACE"
+
+_Atomic int traceRecording = 0;
+
+#ifndef NO_PROFILER
+typedef struct
+{
+    const char *name;
+    const char *category;
+    double startMs;
+    double durationMs;
+    int thread;
+    _Atomic unsigned int sequence; // claim number + 1 once the event is complete, 0 if empty
+} TraceEvent;
+
+static TraceEvent *events = NULL;
+static _Atomic unsigned int nextEvent = 0;
+static double traceStartMs = 0.0;
+static char traceFile[256];
+
+// Small thread numbers for the trace, the main thread (numbered by trace_init) is 1
+static _Thread_local int traceThread = 0;
+static _Atomic int threadCount = 0;
+
+// Records one event that ran from startMs to endMs (from timer_now_ms)
+void trace_record(const char *name, const char *category, double startMs, double endMs)
+{
+    // Started before the recording did
+    if (!events || startMs < traceStartMs)
+        return;
+
+    if (traceThread == 0)
+        traceThread = atomic_fetch_add(&threadCount, 1) + 1;
+
+    unsigned int claim = atomic_fetch_add_explicit(&nextEvent, 1, memory_order_relaxed);
+    TraceEvent *event = &events[claim & (TRACE_CAPACITY - 1)];
+
+    // Lock the slot, unless another thread is writing it or has already put a newer event there
+    unsigned int seen = atomic_load_explicit(&event->sequence, memory_order_relaxed);
+    if (seen == TRACE_SLOT_BUSY || seen > claim ||
+        !atomic_compare_exchange_strong(&event->sequence, &seen, TRACE_SLOT_BUSY))
+        return;
+    atomic_thread_fence(memory_order_release);
+    event->name = name;
+    event->category = category;
+    event->startMs = startMs;
+    event->durationMs = endMs - startMs;
+    event->thread = traceThread;
+    atomic_store_explicit(&event->sequence, claim + 1, memory_order_release);
+}
+
+// Helper function to write the recorded events out; returns how many were written, -1 on error
+static int writeTrace(const char *file)
+{
+    FILE *f = fopen(file, "w");
+    if (!f)
+        return -1;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}}");
+
+    unsigned int end = atomic_load(&nextEvent);
+    unsigned int begin = end > TRACE_CAPACITY ? end - TRACE_CAPACITY : 0;
+    int written = 0;
+    for (unsigned int claim = begin; claim != end; claim++)
+    {
+        TraceEvent *event = &events[claim & (TRACE_CAPACITY - 1)];
+        if (atomic_load_explicit(&event->sequence, memory_order_acquire) != claim + 1)
+            continue; // still being written, or overwritten since
+
+        TraceEvent copy;
+        copy.name = event->name;
+        copy.category = event->category;
+        copy.startMs = event->startMs;
+        copy.durationMs = event->durationMs;
+        copy.thread = event->thread;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&event->sequence, memory_order_relaxed) != claim + 1)
+            continue;
+
+        // Trace times are in microseconds
+        fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                copy.name, copy.category, copy.thread,
+                (copy.startMs - traceStartMs) * 1000.0, copy.durationMs * 1000.0);
+        written++;
+    }
+
+    fprintf(f, "\n]}\n");
+    if (fclose(f) != 0)
+        return -1;
+    return written;
+}
+
+static void stopTrace(void);
+
+// Starts recording; the trace is written to file when it stops
+static void startTrace(const char *file)
+{
+    if (!events)
+        events = (TraceEvent *)calloc(TRACE_CAPACITY, sizeof(TraceEvent));
+    if (!events)
+    {
+        printf("Cannot allocate the trace buffer\n");
+        return;
+    }
+
+    snprintf(traceFile, sizeof(traceFile), "%s", file);
+    atomic_store(&nextEvent, 0);
+    for (int i = 0; i < TRACE_CAPACITY; i++)
+        atomic_store_explicit(&events[i].sequence, 0, memory_order_relaxed);
+    traceStartMs = timer_now_ms();
+    traceRecording = 1;
+    printf("Tracing to %s\n", traceFile);
+
+    // A recording still running at exit is written then
+    static int exitHandlerAdded = 0;
+    if (!exitHandlerAdded)
+        atexit(stopTrace);
+    exitHandlerAdded = 1;
+}
+
+// Stops recording and writes the trace
+static void stopTrace(void)
+{
+    if (!traceRecording)
+        return;
+    traceRecording = 0;
+
+    unsigned int recorded = atomic_load(&nextEvent);
+    int written = writeTrace(traceFile);
+    if (written < 0)
+        printf("Error: could not write %s\n", traceFile);
+    else
+        printf("Wrote %d trace events to %s%s\n", written, traceFile,
+               recorded > TRACE_CAPACITY ? " (the oldest were dropped)" : "");
+}
+
+// Numbers the main thread and starts a recording right away when EVENTHALL_TRACE names a file
+void trace_init(void)
+{
+    traceThread = atomic_fetch_add(&threadCount, 1) + 1;
+
+    const char *file = getenv(TRACE_ENV);
+    if (file && file[0])
+        startTrace(file);
+}
+
+// Starts or stops recording (a new recording goes to trace-<date>-<time>.json)
+void trace_toggle(void)
+{
+    if (traceRecording)
+    {
+        stopTrace();
+        return;
+    }
+
+    char file[64];
+    time_t now = time(NULL);
+    strftime(file, sizeof(file), "trace-%Y%m%d-%H%M%S.json", localtime(&now));
+    startTrace(file);
+}
+#else
+// Tracing is compiled out
+void trace_init(void)
+{
+}
+
+void trace_toggle(void)
+{
+    printf("Tracing is left out of this build (-DNO_PROFILER)\n");
+}
+#endif
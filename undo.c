@@ -0,0 +1,359 @@
+#include "CSCIx229.h"
+
+// Deltas stored per memory chunk
+#define UNDO_CHUNK_DELTAS 256
+
+// Memory the history may use before the oldest edits are dropped (KB)
+int undoMemoryLimitKB = 4096;
+
+typedef enum
+{
+    DELTA_TRANSFORM, // object moved, rotated or scaled
+    DELTA_SPAWN,     // object added
+    DELTA_REMOVE     // object deleted
+} UndoDeltaKind;
+
+// One changed object: only its identity and transform before and after the edit
+typedef struct
+{
+    UndoDeltaKind kind;
+    int objectId;
+    int type; // SceneSpawnType, for bringing removed objects back
+    char name[32];
+    SceneTransform before;
+    SceneTransform after;
+} UndoDelta;
+
+// One undo step; its deltas are numbered first .. first + count - 1
+typedef struct
+{
+    long first;
+    int count;
+} UndoEdit;
+
+// Deltas live in fixed size chunks so the history grows without copying old entries
+// Delta number d is in chunks[d / UNDO_CHUNK_DELTAS - chunkBase]
+static UndoDelta **chunks = NULL;
+static int chunkCount = 0;
+static int chunkCapacity = 0;
+static long chunkBase = 0;
+static long deltaEnd = 0; // number of the next delta
+
+// Edits in order; the ones before editCursor are applied, the rest can be redone
+static UndoEdit *edits = NULL;
+static int editCount = 0;
+static int editCapacity = 0;
+static int editCursor = 0;
+
+// Set between undo_begin_edit and undo_end_edit so several changes undo as one
+static int groupDepth = 0;
+static int groupHasEdit = 0;
+
+// Helper function to get a delta by number
+static UndoDelta *deltaAt(long number)
+{
+    return &chunks[number / UNDO_CHUNK_DELTAS - chunkBase][number % UNDO_CHUNK_DELTAS];
+}
+
+// Memory used by the history right now
+static size_t historyBytes(void)
+{
+    return (size_t)chunkCount * UNDO_CHUNK_DELTAS * sizeof(UndoDelta) +
+           (size_t)editCapacity * sizeof(UndoEdit);
+}
+
+// Frees chunks that only hold deltas numbered below firstKept
+static void dropChunksBefore(long firstKept)
+{
+    int dropCount = (int)(firstKept / UNDO_CHUNK_DELTAS - chunkBase);
+    if (dropCount <= 0)
+        return;
+    if (dropCount > chunkCount)
+        dropCount = chunkCount;
+
+    for (int i = 0; i < dropCount; i++)
+        free(chunks[i]);
+    memmove(chunks, chunks + dropCount, (chunkCount - dropCount) * sizeof(UndoDelta *));
+    chunkCount -= dropCount;
+    chunkBase += dropCount;
+}
+
+// Frees chunks past the last delta in use (after redo steps are thrown away)
+static void dropChunksFrom(long firstUnused)
+{
+    long neededChunks = (firstUnused + UNDO_CHUNK_DELTAS - 1) / UNDO_CHUNK_DELTAS - chunkBase;
+    if (neededChunks < 0)
+        neededChunks = 0;
+
+    while (chunkCount > neededChunks)
+        free(chunks[--chunkCount]);
+}
+
+// Drops the oldest edits until the history fits in its memory limit (the newest edit is always kept)
+static void enforceLimit(void)
+{
+    size_t limit = (size_t)undoMemoryLimitKB * 1024;
+    int dropCount = 0;
+
+    while (historyBytes() > limit && editCount - dropCount > 1)
+    {
+        dropCount++;
+        dropChunksBefore(edits[dropCount].first);
+    }
+
+    if (dropCount > 0)
+    {
+        memmove(edits, edits + dropCount, (editCount - dropCount) * sizeof(UndoEdit));
+        editCount -= dropCount;
+        editCursor -= dropCount;
+        if (editCursor < 0)
+            editCursor = 0;
+    }
+}
+
+// Adds a delta to the history, starting a new edit unless one is open
+static UndoDelta *newDelta(void)
+{
+    // A fresh change throws away anything that could have been redone
+    if (editCursor < editCount && (groupDepth == 0 || !groupHasEdit))
+    {
+        deltaEnd = edits[editCursor].first;
+        editCount = editCursor;
+        dropChunksFrom(deltaEnd);
+    }
+
+    // Start a new edit
+    if (groupDepth == 0 || !groupHasEdit)
+    {
+        if (editCount == editCapacity)
+        {
+            int newCapacity = editCapacity ? editCapacity * 2 : 64;
+            UndoEdit *grown = (UndoEdit *)realloc(edits, newCapacity * sizeof(UndoEdit));
+            if (!grown)
+                return NULL;
+            edits = grown;
+            editCapacity = newCapacity;
+        }
+        edits[editCount].first = deltaEnd;
+        edits[editCount].count = 0;
+        editCount++;
+        editCursor = editCount;
+        groupHasEdit = 1;
+    }
+
+    // Grab another chunk when the last one is full
+    if (deltaEnd / UNDO_CHUNK_DELTAS - chunkBase >= chunkCount)
+    {
+        if (chunkCount == chunkCapacity)
+        {
+            int newCapacity = chunkCapacity ? chunkCapacity * 2 : 16;
+            UndoDelta **grown = (UndoDelta **)realloc(chunks, newCapacity * sizeof(UndoDelta *));
+            if (!grown)
+                return NULL;
+            chunks = grown;
+            chunkCapacity = newCapacity;
+        }
+        UndoDelta *chunk = (UndoDelta *)malloc(UNDO_CHUNK_DELTAS * sizeof(UndoDelta));
+        if (!chunk)
+            return NULL;
+        chunks[chunkCount++] = chunk;
+    }
+
+    UndoDelta *delta = deltaAt(deltaEnd++);
+    memset(delta, 0, sizeof(UndoDelta));
+    edits[editCount - 1].count++;
+    return delta;
+}
+
+// Finishes adding a delta
+static void endDelta(void)
+{
+    if (groupDepth == 0)
+    {
+        groupHasEdit = 0;
+        enforceLimit();
+    }
+}
+
+// Starts grouping changes so one undo reverts all of them
+void undo_begin_edit(void)
+{
+    if (groupDepth++ == 0)
+        groupHasEdit = 0;
+}
+
+// Closes a group started with undo_begin_edit
+void undo_end_edit(void)
+{
+    if (groupDepth > 0 && --groupDepth == 0)
+    {
+        groupHasEdit = 0;
+        enforceLimit();
+    }
+}
+
+// Forgets the whole history (used when the layout is replaced)
+void undo_clear(void)
+{
+    dropChunksFrom(chunkBase * UNDO_CHUNK_DELTAS);
+    chunkBase = deltaEnd / UNDO_CHUNK_DELTAS;
+    editCount = 0;
+    editCursor = 0;
+    groupHasEdit = 0;
+}
+
+// Records that an object's transform changed from "before" to what it is now
+void undo_record_transform(const SceneObject *sceneObject, const SceneTransform *before)
+{
+    if (!sceneObject)
+        return;
+
+    UndoDelta *delta = newDelta();
+    if (!delta)
+        return;
+
+    delta->kind = DELTA_TRANSFORM;
+    delta->objectId = sceneObject->id;
+    delta->before = *before;
+    scene_get_transform(sceneObject, &delta->after);
+    endDelta();
+}
+
+// Helper function to record a spawn or removal with everything needed to rebuild the object
+static void recordPresence(const SceneObject *sceneObject, UndoDeltaKind kind)
+{
+    if (!sceneObject)
+        return;
+
+    UndoDelta *delta = newDelta();
+    if (!delta)
+        return;
+
+    delta->kind = kind;
+    delta->objectId = sceneObject->id;
+    delta->type = layout_type_from_name(sceneObject->name);
+    memcpy(delta->name, sceneObject->name, sizeof(delta->name));
+    scene_get_transform(sceneObject, &delta->before);
+    delta->after = delta->before;
+    endDelta();
+}
+
+// Records a newly spawned object
+void undo_record_spawn(const SceneObject *sceneObject)
+{
+    recordPresence(sceneObject, DELTA_SPAWN);
+}
+
+// Records an object that is about to be removed
+void undo_record_remove(const SceneObject *sceneObject)
+{
+    recordPresence(sceneObject, DELTA_REMOVE);
+}
+
+// Helper function to bring back a removed object under its old id
+static void restoreObject(const UndoDelta *delta)
+{
+    if (delta->type < 0 || delta->type >= SPAWN_TYPE_COUNT)
+        return;
+
+    const SceneTransform *transform = &delta->before;
+    SceneObject *restored = scene_spawn_restore((SceneSpawnType)delta->type, delta->name,
+                                                transform->x, transform->y, transform->z,
+                                                transform->rotation, transform->scale);
+    if (!restored)
+    {
+        printf("Maximum object count reached, %s not restored.\n", delta->name);
+        return;
+    }
+
+    scene_set_object_id(restored, delta->objectId);
+    journal_spawn(restored);
+}
+
+// Helper function to delete an object by id
+static void deleteObject(int objectId)
+{
+    SceneObject *sceneObject = scene_find_object_id(objectId);
+    if (!sceneObject)
+        return;
+
+    char name[32];
+    memcpy(name, sceneObject->name, sizeof(name));
+    scene_remove_object(sceneObject);
+    journal_remove(name);
+}
+
+// Applies one delta forwards (redo) or backwards (undo)
+static void applyDelta(const UndoDelta *delta, int forwards)
+{
+    switch (delta->kind)
+    {
+    case DELTA_TRANSFORM:
+    {
+        SceneObject *sceneObject = scene_find_object_id(delta->objectId);
+        if (sceneObject)
+        {
+            scene_set_transform(sceneObject, forwards ? &delta->after : &delta->before);
+            journal_spawn(sceneObject); // S records also update objects that exist
+        }
+        break;
+    }
+
+    case DELTA_SPAWN:
+        if (forwards)
+            restoreObject(delta);
+        else
+            deleteObject(delta->objectId);
+        break;
+
+    case DELTA_REMOVE:
+        if (forwards)
+            deleteObject(delta->objectId);
+        else
+            restoreObject(delta);
+        break;
+    }
+}
+
+// Reverts the latest edit
+// Returns 0 if there was nothing to undo
+int undo_undo(void)
+{
+    if (editCursor == 0)
+    {
+        printf("Nothing to undo.\n");
+        return 0;
+    }
+
+    const UndoEdit *edit = &edits[--editCursor];
+
+    // Walk backwards so changes to the same object unwind in order
+    for (int i = edit->count - 1; i >= 0; i--)
+        applyDelta(deltaAt(edit->first + i), 0);
+
+    selectedObject = NULL;
+    dragging = 0;
+    printf("Undo (%d object%s).\n", edit->count, edit->count == 1 ? "" : "s");
+    return 1;
+}
+
+// Applies the last undone edit again
+// Returns 0 if there was nothing to redo
+int undo_redo(void)
+{
+    if (editCursor == editCount)
+    {
+        printf("Nothing to redo.\n");
+        return 0;
+    }
+
+    const UndoEdit *edit = &edits[editCursor++];
+
+    for (int i = 0; i < edit->count; i++)
+        applyDelta(deltaAt(edit->first + i), 1);
+
+    selectedObject = NULL;
+    dragging = 0;
+    printf("Redo (%d object%s).\n", edit->count, edit->count == 1 ? "" : "s");
+    return 1;
+}